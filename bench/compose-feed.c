@@ -0,0 +1,349 @@
+/*
+ * Copyright © 2021 The libxkbcommon contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include "xkbcommon/xkbcommon-compose.h"
+
+#include "../test/test.h"
+#include "../src/utils.h"
+#include "../src/utf8.h"
+#include "bench.h"
+
+#define BENCHMARK_EVENTS 5000000
+#define BATCH_SIZE 4096
+
+/*
+ * Feeds keysym streams through a compose state, the way a client does
+ * for every key press, and reports the time per event.  The streams are
+ * derived from a small multilingual text corpus, typed in a few ways.
+ */
+
+static const char *corpus[] = {
+    /* French */
+    "Le cœur a ses raisons que la raison ne connaît point. "
+    "Où êtes-vous allés déjeuner ? Près de la forêt, à côté du château, "
+    "où l'été dernier nous avions goûté une crème brûlée très réussie. ",
+    /* German */
+    "Für die Prüfung müssen die Schüler größere Übungen lösen. "
+    "Während der Öffnungszeiten ist das Büro äußerst schön gefüllt, "
+    "und die Grüße aus Köln kommen täglich. ",
+    /* Spanish */
+    "El niño pequeño comió una piña en la montaña. ¿Dónde está el "
+    "camión? Mañana habrá reunión en la oficina después del almuerzo. ",
+    /* Portuguese */
+    "A informação não está disponível, mas a solução é simples: "
+    "vá à estação e peça as instruções ao funcionário. ",
+    /* Czech */
+    "Příliš žluťoučký kůň úpěl ďábelské ódy. Děkuji, že jste přišli "
+    "včas, přátelé; řekněte mi, co se stalo. ",
+    /* Polish */
+    "Zażółć gęślą jaźń. Mówię, że jutro pójdę do księgarni kupić "
+    "książkę o historii Łodzi. ",
+    /* Swedish */
+    "Vi åkte till sjön på söndag och åt räkor med bröd. "
+    "Är det här nära hålet där älgen bor? ",
+};
+
+struct accent {
+    /* XKB_KEY_NoSymbol if there is no dead key for the accent. */
+    xkb_keysym_t dead;
+    /* The keysym following Multi_key. */
+    xkb_keysym_t multi;
+    const char *bases;
+    const char *composed;
+};
+
+static const struct accent accents[] = {
+    { XKB_KEY_dead_acute, XKB_KEY_apostrophe,
+      "aeiouyAEIOUYcnszCNSZ", "áéíóúýÁÉÍÓÚÝćńśźĆŃŚŹ" },
+    { XKB_KEY_dead_grave, XKB_KEY_grave, "aeiouAEIOU", "àèìòùÀÈÌÒÙ" },
+    { XKB_KEY_dead_circumflex, XKB_KEY_asciicircum,
+      "aeiouAEIOU", "âêîôûÂÊÎÔÛ" },
+    { XKB_KEY_dead_diaeresis, XKB_KEY_quotedbl,
+      "aeiouyAEIOU", "äëïöüÿÄËÏÖÜ" },
+    { XKB_KEY_dead_tilde, XKB_KEY_asciitilde, "anoANO", "ãñõÃÑÕ" },
+    { XKB_KEY_dead_cedilla, XKB_KEY_comma, "cC", "çÇ" },
+    { XKB_KEY_dead_abovering, XKB_KEY_o, "auAU", "åůÅŮ" },
+    { XKB_KEY_dead_caron, XKB_KEY_c,
+      "cdenrstzCDENRSTZ", "čďěňřšťžČĎĚŇŘŠŤŽ" },
+    { XKB_KEY_dead_ogonek, XKB_KEY_semicolon, "aeAE", "ąęĄĘ" },
+    { XKB_KEY_dead_abovedot, XKB_KEY_period, "zZ", "żŻ" },
+    { XKB_KEY_dead_stroke, XKB_KEY_slash, "lL", "łŁ" },
+    { XKB_KEY_NoSymbol, XKB_KEY_s, "s", "ß" },
+    { XKB_KEY_NoSymbol, XKB_KEY_o, "e", "œ" },
+};
+
+enum scenario {
+    /* Accented letters are typed with dead keys where possible. */
+    SCENARIO_DEAD_KEYS,
+    /* Accented letters are typed with Multi_key sequences. */
+    SCENARIO_MULTI_KEY,
+    /* Dead keys and Multi_key mixed, with some mistyped sequences. */
+    SCENARIO_MIXED,
+};
+
+static const char *scenario_names[] = {
+    [SCENARIO_DEAD_KEYS] = "dead-keys",
+    [SCENARIO_MULTI_KEY] = "multi-key",
+    [SCENARIO_MIXED] = "mixed",
+};
+
+struct stream {
+    darray(xkb_keysym_t) keysyms;
+    /* The expected output of each composed sequence, in order. */
+    darray(uint32_t) composed;
+    unsigned num_cancelled;
+};
+
+static bool
+find_accent(uint32_t cp, const struct accent **accent_out, char *base_out)
+{
+    uint32_t composed[32];
+    size_t count;
+
+    for (size_t i = 0; i < ARRAY_SIZE(accents); i++) {
+        const struct accent *accent = &accents[i];
+        bool ok = utf8_to_utf32(accent->composed, strlen(accent->composed),
+                                composed, &count);
+        assert(ok && count == strlen(accent->bases));
+
+        for (size_t j = 0; j < count; j++) {
+            if (composed[j] == cp) {
+                *accent_out = accent;
+                *base_out = accent->bases[j];
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static void
+build_stream(struct stream *stream, enum scenario scenario)
+{
+    unsigned num_accented = 0;
+
+    darray_init(stream->keysyms);
+    darray_init(stream->composed);
+    stream->num_cancelled = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(corpus); i++) {
+        size_t len = strlen(corpus[i]);
+        uint32_t *text = calloc(len, sizeof(*text));
+        size_t count;
+        bool ok;
+
+        assert(text);
+        ok = utf8_to_utf32(corpus[i], len, text, &count);
+        assert(ok);
+
+        for (size_t j = 0; j < count; j++) {
+            const struct accent *accent;
+            char base;
+            bool use_dead;
+
+            if (!find_accent(text[j], &accent, &base)) {
+                darray_append(stream->keysyms, xkb_utf32_to_keysym(text[j]));
+                continue;
+            }
+
+            num_accented++;
+            switch (scenario) {
+            case SCENARIO_DEAD_KEYS:
+                use_dead = true;
+                break;
+            case SCENARIO_MULTI_KEY:
+                use_dead = false;
+                break;
+            case SCENARIO_MIXED:
+            default:
+                use_dead = num_accented % 2 == 0;
+                /* Start a sequence, then a wrong key cancels it. */
+                if (num_accented % 5 == 0) {
+                    darray_append(stream->keysyms, use_dead ?
+                                  XKB_KEY_dead_acute : XKB_KEY_Multi_key);
+                    if (!use_dead)
+                        darray_append(stream->keysyms, XKB_KEY_apostrophe);
+                    darray_append(stream->keysyms, XKB_KEY_q);
+                    stream->num_cancelled++;
+                }
+                break;
+            }
+
+            if (use_dead && accent->dead != XKB_KEY_NoSymbol) {
+                darray_append(stream->keysyms, accent->dead);
+            }
+            else {
+                darray_append(stream->keysyms, XKB_KEY_Multi_key);
+                darray_append(stream->keysyms, accent->multi);
+            }
+            darray_append(stream->keysyms, xkb_utf32_to_keysym(base));
+            darray_append(stream->composed, text[j]);
+        }
+
+        free(text);
+    }
+}
+
+/* Make sure the stream does what it's supposed to, before timing it. */
+static void
+check_stream(struct xkb_compose_state *state, const struct stream *stream)
+{
+    unsigned num_composed = 0, num_cancelled = 0;
+    xkb_keysym_t *keysym;
+
+    xkb_compose_state_reset(state);
+    darray_foreach(keysym, stream->keysyms) {
+        char buffer[8], expected[8];
+
+        xkb_compose_state_feed(state, *keysym);
+        switch (xkb_compose_state_get_status(state)) {
+        case XKB_COMPOSE_COMPOSED:
+            assert(num_composed < darray_size(stream->composed));
+            utf32_to_utf8(darray_item(stream->composed, num_composed),
+                          expected);
+            xkb_compose_state_get_utf8(state, buffer, sizeof(buffer));
+            if (!streq(buffer, expected)) {
+                fprintf(stderr, "expected %s, got %s\n", expected, buffer);
+                assert(!"unexpected compose result");
+            }
+            num_composed++;
+            break;
+        case XKB_COMPOSE_CANCELLED:
+            num_cancelled++;
+            break;
+        default:
+            break;
+        }
+    }
+
+    assert(num_composed == darray_size(stream->composed));
+    assert(num_cancelled == stream->num_cancelled);
+}
+
+static int
+compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double *) a, db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+static void
+bench_stream(struct xkb_compose_state *state, const struct stream *stream,
+             const char *name)
+{
+    const unsigned num_batches = BENCHMARK_EVENTS / BATCH_SIZE;
+    double *ns_per_event = calloc(num_batches, sizeof(*ns_per_event));
+    const xkb_keysym_t *keysyms = stream->keysyms.item;
+    const unsigned num_keysyms = darray_size(stream->keysyms);
+    unsigned pos = 0;
+    double total = 0;
+    struct bench bench;
+    struct bench_time elapsed;
+    char buffer[64];
+
+    assert(ns_per_event);
+    xkb_compose_state_reset(state);
+
+    for (unsigned b = 0; b < num_batches; b++) {
+        bench_start(&bench);
+        for (unsigned i = 0; i < BATCH_SIZE; i++) {
+            xkb_compose_state_feed(state, keysyms[pos]);
+            if (xkb_compose_state_get_status(state) == XKB_COMPOSE_COMPOSED)
+                xkb_compose_state_get_utf8(state, buffer, sizeof(buffer));
+            if (++pos == num_keysyms)
+                pos = 0;
+        }
+        bench_stop(&bench);
+
+        bench_elapsed(&bench, &elapsed);
+        ns_per_event[b] =
+            (elapsed.seconds * 1e9 + elapsed.microseconds * 1e3) / BATCH_SIZE;
+        total += ns_per_event[b];
+    }
+
+    qsort(ns_per_event, num_batches, sizeof(*ns_per_event), compare_doubles);
+    fprintf(stderr,
+            "%-10s %u events (%u per pass): %.1f ns/event "
+            "(p50 %.1f, p90 %.1f, p99 %.1f)\n",
+            name, num_batches * BATCH_SIZE, num_keysyms,
+            total / num_batches,
+            ns_per_event[num_batches / 2],
+            ns_per_event[num_batches * 9 / 10],
+            ns_per_event[num_batches * 99 / 100]);
+
+    free(ns_per_event);
+}
+
+int
+main(void)
+{
+    struct xkb_context *ctx;
+    char *path;
+    FILE *file;
+    struct xkb_compose_table *table;
+    struct xkb_compose_state *state;
+
+    ctx = test_get_context(CONTEXT_NO_FLAG);
+    assert(ctx);
+
+    path = test_get_path("compose/en_US.UTF-8/Compose");
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        free(path);
+        xkb_context_unref(ctx);
+        return -1;
+    }
+
+    xkb_context_set_log_level(ctx, XKB_LOG_LEVEL_CRITICAL);
+    xkb_context_set_log_verbosity(ctx, 0);
+
+    table = xkb_compose_table_new_from_file(ctx, file, "",
+                                            XKB_COMPOSE_FORMAT_TEXT_V1,
+                                            XKB_COMPOSE_COMPILE_NO_FLAGS);
+    fclose(file);
+    free(path);
+    assert(table);
+
+    state = xkb_compose_state_new(table, XKB_COMPOSE_STATE_NO_FLAGS);
+    assert(state);
+
+    for (enum scenario s = SCENARIO_DEAD_KEYS; s <= SCENARIO_MIXED; s++) {
+        struct stream stream;
+
+        build_stream(&stream, s);
+        check_stream(state, &stream);
+        bench_stream(state, &stream, scenario_names[s]);
+
+        darray_free(stream.keysyms);
+        darray_free(stream.composed);
+    }
+
+    xkb_compose_state_unref(state);
+    xkb_compose_table_unref(table);
+    xkb_context_unref(ctx);
+    return 0;
+}
@@ -0,0 +1,629 @@
+/**
+ * This file comes from libxkbcommon and was generated by makecasetables
+ * from the Unicode 14.0.0 Character Database.
+ */
+
+#define CASE_MAPPING_MAX 0x1e943
+#define CASE_MAPPING_BLOCK_SHIFT 6
+
+struct case_mapping {
+    int32_t lower;
+    int32_t upper;
+};
+
+static const struct case_mapping case_mappings[] = {
+    { 0, 0 },
+    { 32, 0 },
+    { 0, -32 },
+    { 0, 743 },
+    { 0, 7615 },
+    { 0, 121 },
+    { 1, 0 },
+    { 0, -1 },
+    { -199, 0 },
+    { 0, -232 },
+    { -121, 0 },
+    { 0, -300 },
+    { 0, 195 },
+    { 210, 0 },
+    { 206, 0 },
+    { 205, 0 },
+    { 79, 0 },
+    { 202, 0 },
+    { 203, 0 },
+    { 207, 0 },
+    { 0, 97 },
+    { 211, 0 },
+    { 209, 0 },
+    { 0, 163 },
+    { 213, 0 },
+    { 0, 130 },
+    { 214, 0 },
+    { 218, 0 },
+    { 217, 0 },
+    { 219, 0 },
+    { 0, 56 },
+    { 2, 0 },
+    { 1, -1 },
+    { 0, -2 },
+    { 0, -79 },
+    { -97, 0 },
+    { -56, 0 },
+    { -130, 0 },
+    { 10795, 0 },
+    { -163, 0 },
+    { 10792, 0 },
+    { 0, 10815 },
+    { -195, 0 },
+    { 69, 0 },
+    { 71, 0 },
+    { 0, 10783 },
+    { 0, 10780 },
+    { 0, 10782 },
+    { 0, -210 },
+    { 0, -206 },
+    { 0, -205 },
+    { 0, -202 },
+    { 0, -203 },
+    { 0, 42319 },
+    { 0, 42315 },
+    { 0, -207 },
+    { 0, 42280 },
+    { 0, 42308 },
+    { 0, -209 },
+    { 0, -211 },
+    { 0, 10743 },
+    { 0, 42305 },
+    { 0, 10749 },
+    { 0, -213 },
+    { 0, -214 },
+    { 0, 10727 },
+    { 0, -218 },
+    { 0, 42307 },
+    { 0, 42282 },
+    { 0, -69 },
+    { 0, -217 },
+    { 0, -71 },
+    { 0, -219 },
+    { 0, 42261 },
+    { 0, 42258 },
+    { 0, 84 },
+    { 116, 0 },
+    { 38, 0 },
+    { 37, 0 },
+    { 64, 0 },
+    { 63, 0 },
+    { 0, -38 },
+    { 0, -37 },
+    { 0, -31 },
+    { 0, -64 },
+    { 0, -63 },
+    { 8, 0 },
+    { 0, -62 },
+    { 0, -57 },
+    { 0, -47 },
+    { 0, -54 },
+    { 0, -8 },
+    { 0, -86 },
+    { 0, -80 },
+    { 0, 7 },
+    { 0, -116 },
+    { -60, 0 },
+    { 0, -96 },
+    { -7, 0 },
+    { 80, 0 },
+    { 15, 0 },
+    { 0, -15 },
+    { 48, 0 },
+    { 0, -48 },
+    { 7264, 0 },
+    { 0, 3008 },
+    { 38864, 0 },
+    { 0, -6254 },
+    { 0, -6253 },
+    { 0, -6244 },
+    { 0, -6242 },
+    { 0, -6243 },
+    { 0, -6236 },
+    { 0, -6181 },
+    { 0, 35266 },
+    { -3008, 0 },
+    { 0, 35332 },
+    { 0, 3814 },
+    { 0, 35384 },
+    { 0, -59 },
+    { -7615, 0 },
+    { 0, 8 },
+    { -8, 0 },
+    { 0, 74 },
+    { 0, 86 },
+    { 0, 100 },
+    { 0, 128 },
+    { 0, 112 },
+    { 0, 126 },
+    { 0, 9 },
+    { -74, 0 },
+    { -9, 0 },
+    { 0, -7205 },
+    { -86, 0 },
+    { -100, 0 },
+    { -112, 0 },
+    { -128, 0 },
+    { -126, 0 },
+    { -7517, 0 },
+    { -8383, 0 },
+    { -8262, 0 },
+    { 28, 0 },
+    { 0, -28 },
+    { 16, 0 },
+    { 0, -16 },
+    { 26, 0 },
+    { 0, -26 },
+    { -10743, 0 },
+    { -3814, 0 },
+    { -10727, 0 },
+    { 0, -10795 },
+    { 0, -10792 },
+    { -10780, 0 },
+    { -10749, 0 },
+    { -10783, 0 },
+    { -10782, 0 },
+    { -10815, 0 },
+    { 0, -7264 },
+    { -35332, 0 },
+    { -42280, 0 },
+    { 0, 48 },
+    { -42308, 0 },
+    { -42319, 0 },
+    { -42315, 0 },
+    { -42305, 0 },
+    { -42258, 0 },
+    { -42282, 0 },
+    { -42261, 0 },
+    { 928, 0 },
+    { -48, 0 },
+    { -42307, 0 },
+    { -35384, 0 },
+    { 0, -928 },
+    { 0, -38864 },
+    { 40, 0 },
+    { 0, -40 },
+    { 39, 0 },
+    { 0, -39 },
+    { 34, 0 },
+    { 0, -34 },
+};
+
+static const uint8_t case_mapping_blocks[] = {
+      0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,   0,
+      0,  11,  12,  13,  14,  15,  16,  17,  18,  19,  20,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,  21,  22,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,  23,  24,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,  25,   0,   0,  26,  27,   0,
+     28,  28,  29,  28,  30,  31,  32,  33,   0,   0,   0,   0,
+     34,  35,  36,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,  37,  38,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  39,  40,  28,  41,
+     42,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,  43,  44,   0,  45,  46,  47,  48,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,  49,  50,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     51,  52,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  53,  54,  55,  56,
+      0,  57,  58,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,  59,  60,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,  61,  62,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,  63,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     64,  65,
+};
+
+static const uint8_t case_mapping_entries[] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   0,   0,   0,   0,   0,
+      0,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   3,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   0,   1,   1,   1,   1,   1,   1,   1,   4,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   0,   2,   2,   2,   2,   2,   2,   2,   5,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      8,   9,   6,   7,   6,   7,   6,   7,   0,   6,   7,   6,   7,   6,   7,   6,
+      7,   6,   7,   6,   7,   6,   7,   6,   7,   0,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,  10,   6,   7,   6,   7,   6,   7,  11,
+     12,  13,   6,   7,   6,   7,  14,   6,   7,  15,  15,   6,   7,   0,  16,  17,
+     18,   6,   7,  15,  19,  20,  21,  22,   6,   7,  23,   0,  21,  24,  25,  26,
+      6,   7,   6,   7,   6,   7,  27,   6,   7,  27,   0,   0,   6,   7,  27,   6,
+      7,  28,  28,   6,   7,   6,   7,  29,   6,   7,   0,   0,   6,   7,   0,  30,
+      0,   0,   0,   0,  31,  32,  33,  31,  32,  33,  31,  32,  33,   6,   7,   6,
+      7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,  34,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      0,  31,  32,  33,   6,   7,  35,  36,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+     37,   0,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   0,   0,   0,   0,   0,   0,  38,   6,   7,  39,  40,  41,
+     41,   6,   7,  42,  43,  44,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+     45,  46,  47,  48,  49,   0,  50,  50,   0,  51,   0,  52,  53,   0,   0,   0,
+     50,  54,   0,  55,   0,  56,  57,   0,  58,  59,  57,  60,  61,   0,   0,  59,
+      0,  62,  63,   0,   0,  64,   0,   0,   0,   0,   0,   0,   0,  65,   0,   0,
+     66,   0,  67,  66,   0,   0,   0,  68,  66,  69,  70,  70,  71,   0,   0,   0,
+      0,   0,  72,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  73,  74,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,  75,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      6,   7,   6,   7,   0,   0,   6,   7,   0,   0,   0,  25,  25,  25,   0,  76,
+      0,   0,   0,   0,   0,   0,  77,   0,  78,  78,  78,   0,  79,   0,  80,  80,
+      0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   0,   1,   1,   1,   1,   1,   1,   1,   1,   1,  81,  82,  82,  82,
+      0,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,  83,   2,   2,   2,   2,   2,   2,   2,   2,   2,  84,  85,  85,  86,
+     87,  88,   0,   0,   0,  89,  90,  91,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+     92,  93,  94,  95,  96,  97,   0,   6,   7,  98,   6,   7,   0,  37,  37,  37,
+     99,  99,  99,  99,  99,  99,  99,  99,  99,  99,  99,  99,  99,  99,  99,  99,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+     93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   0,   0,   0,   0,   0,   0,   0,   0,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+    100,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7, 101,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      0, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102,
+    102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102,
+    102, 102, 102, 102, 102, 102, 102,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103,
+    103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103,
+    103, 103, 103, 103, 103, 103, 103,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104,
+    104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104,
+    104, 104, 104, 104, 104, 104,   0, 104,   0,   0,   0,   0,   0, 104,   0,   0,
+    105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105,
+    105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105,
+    105, 105, 105, 105, 105, 105, 105, 105, 105, 105, 105,   0,   0, 105, 105, 105,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106,
+    106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106,
+    106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106,
+    106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106,
+    106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106, 106,
+     86,  86,  86,  86,  86,  86,   0,   0,  91,  91,  91,  91,  91,  91,   0,   0,
+    107, 108, 109, 110, 110, 111, 112, 113, 114,   0,   0,   0,   0,   0,   0,   0,
+    115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115,
+    115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115,
+    115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 115,   0,   0, 115, 115, 115,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0, 116,   0,   0,   0, 117,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 118,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   0,   0,   0,   0,   0, 119,   0,   0, 120,   0,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+    121, 121, 121, 121, 121, 121, 121, 121, 122, 122, 122, 122, 122, 122, 122, 122,
+    121, 121, 121, 121, 121, 121,   0,   0, 122, 122, 122, 122, 122, 122,   0,   0,
+    121, 121, 121, 121, 121, 121, 121, 121, 122, 122, 122, 122, 122, 122, 122, 122,
+    121, 121, 121, 121, 121, 121, 121, 121, 122, 122, 122, 122, 122, 122, 122, 122,
+    121, 121, 121, 121, 121, 121,   0,   0, 122, 122, 122, 122, 122, 122,   0,   0,
+      0, 121,   0, 121,   0, 121,   0, 121,   0, 122,   0, 122,   0, 122,   0, 122,
+    121, 121, 121, 121, 121, 121, 121, 121, 122, 122, 122, 122, 122, 122, 122, 122,
+    123, 123, 124, 124, 124, 124, 125, 125, 126, 126, 127, 127, 128, 128,   0,   0,
+    121, 121, 121, 121, 121, 121, 121, 121, 122, 122, 122, 122, 122, 122, 122, 122,
+    121, 121, 121, 121, 121, 121, 121, 121, 122, 122, 122, 122, 122, 122, 122, 122,
+    121, 121, 121, 121, 121, 121, 121, 121, 122, 122, 122, 122, 122, 122, 122, 122,
+    121, 121,   0, 129,   0,   0,   0,   0, 122, 122, 130, 130, 131,   0, 132,   0,
+      0,   0,   0, 129,   0,   0,   0,   0, 133, 133, 133, 133, 131,   0,   0,   0,
+    121, 121,   0,   0,   0,   0,   0,   0, 122, 122, 134, 134,   0,   0,   0,   0,
+    121, 121,   0,   0,   0,  94,   0,   0, 122, 122, 135, 135,  98,   0,   0,   0,
+      0,   0,   0, 129,   0,   0,   0,   0, 136, 136, 137, 137, 131,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0, 138,   0,   0,   0, 139, 140,   0,   0,   0,   0,
+      0,   0, 141,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 142,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    143, 143, 143, 143, 143, 143, 143, 143, 143, 143, 143, 143, 143, 143, 143, 143,
+    144, 144, 144, 144, 144, 144, 144, 144, 144, 144, 144, 144, 144, 144, 144, 144,
+      0,   0,   0,   6,   7,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145,
+    145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145, 145,
+    146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146, 146,
+    146, 146, 146, 146, 146, 146, 146, 146, 146, 146,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102,
+    102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102,
+    102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102, 102,
+    103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103,
+    103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103,
+    103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103, 103,
+      6,   7, 147, 148, 149, 150, 151,   6,   7,   6,   7,   6,   7, 152, 153, 154,
+    155,   0,   6,   7,   0,   6,   7,   0,   0,   0,   0,   0,   0,   0, 156, 156,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   0,   0,   0,   0,   0,   0,   0,   6,   7,   6,   7,   0,
+      0,   0,   6,   7,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157,
+    157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157, 157,
+    157, 157, 157, 157, 157, 157,   0, 157,   0,   0,   0,   0,   0, 157,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      0,   0,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   6,   7,   6,   7, 158,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   0,   0,   0,   6,   7, 159,   0,   0,
+      6,   7,   6,   7, 160,   0,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7,   6,   7,   6,   7,   6,   7, 161, 162, 163, 164, 161,   0,
+    165, 166, 167, 168,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,   6,   7,
+      6,   7,   6,   7, 169, 170, 171,   6,   7,   6,   7,   0,   0,   0,   0,   0,
+      6,   7,   0,   0,   0,   0,   6,   7,   6,   7,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   6,   7,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0, 172,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173,
+    173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173,
+    173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173,
+    173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173,
+    173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173, 173,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   0,   0,   0,   0,   0,
+      0,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174,
+    174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174,
+    174, 174, 174, 174, 174, 174, 174, 174, 175, 175, 175, 175, 175, 175, 175, 175,
+    175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175,
+    175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174,
+    174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174, 174,
+    174, 174, 174, 174,   0,   0,   0,   0, 175, 175, 175, 175, 175, 175, 175, 175,
+    175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175,
+    175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175, 175,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176,   0, 176, 176, 176, 176,
+    176, 176, 176, 176, 176, 176, 176, 176, 176, 176, 176,   0, 176, 176, 176, 176,
+    176, 176, 176,   0, 176, 176,   0, 177, 177, 177, 177, 177, 177, 177, 177, 177,
+    177, 177,   0, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177, 177,
+    177, 177,   0, 177, 177, 177, 177, 177, 177, 177,   0, 177, 177,   0,   0,   0,
+     79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,
+     79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,
+     79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,  79,
+     79,  79,  79,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,
+     84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,
+     84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,  84,
+     84,  84,  84,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+    178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178,
+    178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178, 178,
+    178, 178, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179,
+    179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179, 179,
+    179, 179, 179, 179,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+};
@@ -0,0 +1,433 @@
+/*
+ * Copyright © 2021 The libxkbcommon contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include "utils.h"
+#include "table.h"
+#include "paths.h"
+#include "cache.h"
+
+/*
+ * A cache file is a compiled compose table which can be used in place,
+ * after mapping the file into memory.  All sections are 8-byte aligned:
+ *
+ *      struct cache_header
+ *      key                   (NUL-terminated)
+ *      num_files times:
+ *          struct cache_file
+ *          path              (NUL-terminated)
+ *      nodes                 (struct compose_node[num_nodes])
+ *      utf8                  (char[utf8_size])
+ *
+ * The key identifies the inputs which determine the result of compiling
+ * the table, besides the files themselves.  The files are the Compose
+ * files the table was compiled from, the main file first, followed by the
+ * compose.dir and locale.alias files which %L includes are resolved with,
+ * with their size and modification time to the nanosecond; the entry is
+ * stale once any of them changes, or a file recorded as missing appears.
+ *
+ * Everything is in host byte order and struct layout.  The header
+ * identifies these, and a cache file written by a different build is
+ * simply ignored, rather than converted.
+ */
+
+#ifdef HAVE_MMAP
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/* "XKBC" */
+#define CACHE_MAGIC 0x43424b58
+#define CACHE_FORMAT_VERSION 4
+#define CACHE_ALIGN 8
+
+struct cache_header {
+    uint32_t magic;
+    uint32_t format_version;
+    char lib_version[16];
+    uint32_t node_size;
+    uint32_t key_size;
+    uint32_t num_files;
+    uint32_t num_nodes;
+    uint32_t utf8_size;
+    uint32_t reserved;
+};
+
+/* The file did not exist when the table was compiled. */
+#define CACHE_FILE_MISSING (1 << 0)
+
+struct cache_file {
+    int64_t mtime_sec;
+    uint32_t mtime_nsec;
+    uint32_t flags;
+    uint64_t size;
+    uint32_t path_size;
+    uint32_t reserved;
+};
+
+static char *
+get_cache_key(struct xkb_compose_table *table, const char *path)
+{
+    /*
+     * Includes may expand %H, %L and %S, which depend on the
+     * environment rather than on the contents of the files.
+     */
+    return asprintf_safe("%s\n%s\n%s\n%s\n%d", table->locale, path,
+                         strempty(secure_getenv("HOME")),
+                         get_xlocaledir_path(),
+                         !!(table->flags & XKB_COMPOSE_COMPILE_COMPACT));
+}
+
+static char *
+get_cache_file_path(const char *key)
+{
+    char name[64];
+
+    snprintf(name, sizeof(name), "compose-%016" PRIx64 ".cache",
+             fnv1a_64(FNV1A_64_INIT, key, strlen(key)));
+    return get_xdg_cache_file_path(name);
+}
+
+static bool
+file_unchanged(const struct cache_file *file, const char *path)
+{
+    struct stat st;
+    int64_t sec;
+    uint32_t nsec;
+
+    if (stat(path, &st) != 0)
+        return (file->flags & CACHE_FILE_MISSING) && errno == ENOENT;
+
+    if (file->flags & CACHE_FILE_MISSING)
+        return false;
+
+    get_mtime(&st, &sec, &nsec);
+    return sec == file->mtime_sec && nsec == file->mtime_nsec &&
+           (uint64_t) st.st_size == file->size;
+}
+
+/* Returns the offset of the next section, or 0 if it is out of bounds. */
+static size_t
+section_end(size_t offset, size_t size, size_t total)
+{
+    if (size > total || offset > total - size)
+        return 0;
+    return MIN(ROUNDUP(offset + size, CACHE_ALIGN), total);
+}
+
+static bool
+check_nodes(const struct compose_node *nodes, uint32_t num_nodes,
+            uint32_t utf8_size)
+{
+    if (num_nodes == 0)
+        return false;
+
+    for (uint32_t i = 0; i < num_nodes; i++) {
+        const struct compose_node *node = &nodes[i];
+
+        if (node->is_leaf) {
+            if (node->offset >= utf8_size)
+                return false;
+        }
+        else {
+            if (node->offset == 0 ||
+                node->offset > num_nodes ||
+                node->u.num_children > num_nodes - node->offset)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static bool
+load_mapping(struct xkb_compose_table *table, const char *key,
+             char *string, size_t size)
+{
+    const struct cache_header *header;
+    const char *utf8;
+    size_t offset, end;
+
+    if (size < sizeof(*header))
+        return false;
+
+    header = (const struct cache_header *) string;
+    if (header->magic != CACHE_MAGIC ||
+        header->format_version != CACHE_FORMAT_VERSION ||
+        strncmp(header->lib_version, LIBXKBCOMMON_VERSION,
+                sizeof(header->lib_version)) != 0 ||
+        header->node_size != sizeof(struct compose_node))
+        return false;
+
+    offset = ROUNDUP(sizeof(*header), CACHE_ALIGN);
+    end = section_end(offset, header->key_size, size);
+    if (end == 0 || header->key_size != strlen(key) + 1 ||
+        memcmp(string + offset, key, header->key_size) != 0)
+        return false;
+    offset = end;
+
+    for (uint32_t i = 0; i < header->num_files; i++) {
+        const struct cache_file *file;
+        const char *path;
+
+        end = section_end(offset, sizeof(*file), size);
+        if (end == 0)
+            return false;
+        file = (const struct cache_file *) (string + offset);
+        offset = end;
+
+        end = section_end(offset, file->path_size, size);
+        if (end == 0 || file->path_size == 0)
+            return false;
+        path = string + offset;
+        if (path[file->path_size - 1] != '\0' || !file_unchanged(file, path))
+            return false;
+        offset = end;
+    }
+
+    end = section_end(offset,
+                      (size_t) header->num_nodes * sizeof(struct compose_node),
+                      size);
+    if (end == 0)
+        return false;
+
+    utf8 = string + end;
+    if (header->utf8_size == 0 ||
+        section_end(end, header->utf8_size, size) == 0 ||
+        utf8[0] != '\0' || utf8[header->utf8_size - 1] != '\0')
+        return false;
+
+    if (!check_nodes((const struct compose_node *) (string + offset),
+                     header->num_nodes, header->utf8_size))
+        return false;
+
+    /*
+     * The table is never modified after it is compiled, so the arrays
+     * can point straight into the (read-only) mapping.  A zero alloc
+     * marks them as not owned.
+     */
+    darray_free(table->nodes);
+    darray_free(table->utf8);
+    table->nodes.item = (struct compose_node *) (string + offset);
+    table->nodes.size = header->num_nodes;
+    table->utf8.item = (char *) utf8;
+    table->utf8.size = header->utf8_size;
+    table->cache_map = string;
+    table->cache_map_size = size;
+    return true;
+}
+
+bool
+compose_cache_load(struct xkb_compose_table *table, const char *path)
+{
+    char *key, *cache_path;
+    char *string;
+    size_t size;
+    FILE *file;
+    bool ok = false;
+
+    key = get_cache_key(table, path);
+    if (!key)
+        return false;
+
+    cache_path = get_cache_file_path(key);
+    if (!cache_path)
+        goto err_key;
+
+    file = fopen(cache_path, "rb");
+    if (!file)
+        goto err_path;
+
+    ok = map_file(file, &string, &size);
+    fclose(file);
+    if (!ok)
+        goto err_path;
+
+    ok = load_mapping(table, key, string, size);
+    if (!ok) {
+        log_dbg(table->ctx, "ignoring stale or invalid Compose cache file %s\n",
+                cache_path);
+        unmap_file(string, size);
+        goto err_path;
+    }
+
+    log_dbg(table->ctx, "loaded compose table for %s from cache file %s\n",
+            path, cache_path);
+
+err_path:
+    free(cache_path);
+err_key:
+    free(key);
+    return ok;
+}
+
+static bool
+write_padded(FILE *file, const void *data, size_t size)
+{
+    static const char zeros[CACHE_ALIGN];
+    size_t padding = ROUNDUP(size, CACHE_ALIGN) - size;
+
+    return fwrite(data, 1, size, file) == size &&
+           fwrite(zeros, 1, padding, file) == padding;
+}
+
+static bool
+write_file_record(FILE *file, const char *path)
+{
+    struct cache_file record;
+    struct stat st;
+
+    memset(&record, 0, sizeof(record));
+    if (stat(path, &st) == 0) {
+        get_mtime(&st, &record.mtime_sec, &record.mtime_nsec);
+        record.size = st.st_size;
+    }
+    else if (errno == ENOENT) {
+        record.flags = CACHE_FILE_MISSING;
+    }
+    else {
+        return false;
+    }
+    record.path_size = strlen(path) + 1;
+
+    return write_padded(file, &record, sizeof(record)) &&
+           write_padded(file, path, record.path_size);
+}
+
+static bool
+write_cache_file(struct xkb_compose_table *table, const char *key,
+                 FILE *file)
+{
+    static const char *const locale_files[] = {
+        "compose.dir", "locale.alias",
+    };
+    struct cache_header header;
+    char **path;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = CACHE_MAGIC;
+    header.format_version = CACHE_FORMAT_VERSION;
+    strncpy(header.lib_version, LIBXKBCOMMON_VERSION,
+            sizeof(header.lib_version));
+    header.node_size = sizeof(struct compose_node);
+    header.key_size = strlen(key) + 1;
+    header.num_files = darray_size(table->files) + ARRAY_SIZE(locale_files);
+    header.num_nodes = darray_size(table->nodes);
+    header.utf8_size = darray_size(table->utf8);
+
+    if (!write_padded(file, &header, sizeof(header)) ||
+        !write_padded(file, key, header.key_size))
+        return false;
+
+    darray_foreach(path, table->files)
+        if (!write_file_record(file, *path))
+            return false;
+
+    for (size_t i = 0; i < ARRAY_SIZE(locale_files); i++) {
+        char *locale_path = asprintf_safe("%s/%s", get_xlocaledir_path(),
+                                          locale_files[i]);
+        bool ok = locale_path && write_file_record(file, locale_path);
+
+        free(locale_path);
+        if (!ok)
+            return false;
+    }
+
+    return write_padded(file, table->nodes.item,
+                        darray_size(table->nodes) * sizeof(struct compose_node)) &&
+           write_padded(file, table->utf8.item, darray_size(table->utf8));
+}
+
+void
+compose_cache_save(struct xkb_compose_table *table, const char *path)
+{
+    char *key, *cache_path, *tmp_path;
+    FILE *file;
+    int fd;
+    bool ok;
+
+    if (table->cache_map || darray_empty(table->files))
+        return;
+
+    key = get_cache_key(table, path);
+    if (!key)
+        return;
+
+    cache_path = get_cache_file_path(key);
+    if (!cache_path)
+        goto err_key;
+
+    tmp_path = asprintf_safe("%s.XXXXXX", cache_path);
+    if (!tmp_path)
+        goto err_path;
+
+    if (!make_parent_dirs(tmp_path))
+        goto err_tmp;
+
+    /* Write to a temporary file, so readers never see a partial file. */
+    fd = mkstemp(tmp_path);
+    if (fd < 0)
+        goto err_tmp;
+
+    file = fdopen(fd, "wb");
+    if (!file) {
+        close(fd);
+        unlink(tmp_path);
+        goto err_tmp;
+    }
+
+    ok = write_cache_file(table, key, file);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmp_path, cache_path) != 0) {
+        log_dbg(table->ctx, "failed to write Compose cache file %s\n",
+                cache_path);
+        unlink(tmp_path);
+        goto err_tmp;
+    }
+
+    log_dbg(table->ctx, "saved compose table for %s to cache file %s\n",
+            path, cache_path);
+
+err_tmp:
+    free(tmp_path);
+err_path:
+    free(cache_path);
+err_key:
+    free(key);
+}
+
+#else
+
+bool
+compose_cache_load(struct xkb_compose_table *table, const char *path)
+{
+    return false;
+}
+
+void
+compose_cache_save(struct xkb_compose_table *table, const char *path)
+{
+}
+
+#endif
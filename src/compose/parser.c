@@ -273,7 +273,7 @@ lex_include_string(struct scanner *s, struct xkb_compose_table *table,
                 }
             }
             else if (chr(s, 'L')) {
-                char *path = get_locale_compose_file_path(table->locale);
+                char *path = get_locale_compose_file_path(table->ctx, table->locale);
                 if (!path) {
                     scanner_err(s, "failed to expand %%L to the locale Compose file");
                     return TOK_ERROR;
@@ -327,75 +327,185 @@ struct production {
     xkb_mod_mask_t mods;
 };
 
+/*
+ * While parsing, the trie is built with linked sibling lists, which makes
+ * insertion simple:
+ *
+ * [root]
+ *   |
+ *   v
+ * [<A>] -----------------> [<E>] -#
+ *   |                        |
+ *   v                        v
+ * [<B>] ---> [<C>] -#      [<F>] -#
+ *   |          |             |
+ *   #          v             #
+ *            [<D>] -#
+ *              |
+ *              #
+ * where:
+ * - right arrows are `next` pointers.
+ * - down arrows are `successor` pointers.
+ * - # is a nil pointer (offset 0, the root).
+ *
+ * The sibling lists are never searched; finding the child of a node with
+ * a given keysym goes through compose_builder::children, a hash table
+ * keyed by (parent, keysym).  In addition, Compose files are heavily
+ * clustered by common prefixes, so the path of the previous production
+ * is remembered, and the common prefix with it is not looked up at all.
+ *
+ * Once the whole file is parsed, this is laid out into the final
+ * xkb_compose_table::nodes array by compile_trie().
+ */
+struct build_node {
+    xkb_keysym_t keysym;
+    /* Offset into compose_builder::nodes. */
+    unsigned int next:31;
+    bool is_leaf:1;
+
+    union {
+        /* Offset into compose_builder::nodes. */
+        uint32_t successor;
+        struct {
+            /* Offset into xkb_compose_table::utf8. */
+            uint32_t utf8;
+            xkb_keysym_t keysym;
+        } leaf;
+    } u;
+};
+
+struct child_entry {
+    uint32_t parent;
+    xkb_keysym_t keysym;
+    /* Offset into compose_builder::nodes; 0 for an empty entry. */
+    uint32_t child;
+};
+
+/* Kept in scanner::priv, and shared by included files. */
+struct compose_builder {
+    darray(struct build_node) nodes;
+
+    /* Open addressing, linear probing; the size is a power of 2. */
+    darray(struct child_entry) children;
+    unsigned num_children;
+
+    /* The nodes along the lhs of the previous production. */
+    xkb_keysym_t prev_lhs[MAX_LHS_LEN];
+    uint32_t prev_path[MAX_LHS_LEN];
+    unsigned prev_len;
+};
+
 static uint32_t
-add_node(struct xkb_compose_table *table, xkb_keysym_t keysym)
+hash_child(uint32_t parent, xkb_keysym_t keysym)
 {
-    struct compose_node new = {
+    uint32_t hash = parent * 0x9e3779b1u ^ keysym;
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bu;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static struct child_entry *
+find_child_entry(struct compose_builder *builder,
+                 uint32_t parent, xkb_keysym_t keysym)
+{
+    unsigned mask = darray_size(builder->children) - 1;
+    unsigned i = hash_child(parent, keysym) & mask;
+
+    for (;;) {
+        struct child_entry *entry = &darray_item(builder->children, i);
+        if (entry->child == 0 ||
+            (entry->parent == parent && entry->keysym == keysym))
+            return entry;
+        i = (i + 1) & mask;
+    }
+}
+
+static void
+grow_children(struct compose_builder *builder)
+{
+    struct child_entry *old = builder->children.item;
+    unsigned old_size = darray_size(builder->children);
+
+    darray_init(builder->children);
+    darray_resize0(builder->children, old_size == 0 ? 256 : 2 * old_size);
+
+    for (unsigned i = 0; i < old_size; i++)
+        if (old[i].child != 0)
+            *find_child_entry(builder, old[i].parent, old[i].keysym) = old[i];
+
+    free(old);
+}
+
+/* Returns the child of @parent with @keysym, creating it if needed. */
+static uint32_t
+get_child(struct compose_builder *builder, uint32_t parent,
+          xkb_keysym_t keysym)
+{
+    struct child_entry *entry;
+    struct build_node new = {
         .keysym = keysym,
-        .next = 0,
         .is_leaf = true,
     };
-    darray_append(table->nodes, new);
-    return darray_size(table->nodes) - 1;
+    uint32_t child;
+
+    if (2 * (builder->num_children + 1) > darray_size(builder->children))
+        grow_children(builder);
+
+    entry = find_child_entry(builder, parent, keysym);
+    if (entry->child != 0)
+        return entry->child;
+
+    child = darray_size(builder->nodes);
+    new.next = darray_item(builder->nodes, parent).u.successor;
+    darray_append(builder->nodes, new);
+    darray_item(builder->nodes, parent).u.successor = child;
+
+    entry->parent = parent;
+    entry->keysym = keysym;
+    entry->child = child;
+    builder->num_children++;
+    return child;
 }
 
 static void
 add_production(struct xkb_compose_table *table, struct scanner *s,
                const struct production *production)
 {
-    unsigned lhs_pos;
+    struct compose_builder *builder = s->priv;
+    unsigned lhs_pos, common;
     uint32_t curr;
-    struct compose_node *node;
+    struct build_node *node;
 
-    curr = 0;
-    node = &darray_item(table->nodes, curr);
+    common = 0;
+    while (common < production->len && common < builder->prev_len &&
+           production->lhs[common] == builder->prev_lhs[common])
+        common++;
 
-    /*
-     * Insert the sequence to the trie, creating new nodes as needed.
-     *
-     * TODO: This can be sped up a bit by first trying the path that the
-     * previous production took, and only then doing the linear search
-     * through the trie levels.  This will work because sequences in the
-     * Compose files are often clustered by a common prefix; especially
-     * in the 1st and 2nd keysyms, which is where the largest variation
-     * (thus, longest search) is.
-     */
+    /* Insert the sequence to the trie, creating new nodes as needed. */
+    curr = 0;
     for (lhs_pos = 0; lhs_pos < production->len; lhs_pos++) {
-        while (production->lhs[lhs_pos] != node->keysym) {
-            if (node->next == 0) {
-                uint32_t next = add_node(table, production->lhs[lhs_pos]);
-                /* Refetch since add_node could have realloc()ed. */
-                node = &darray_item(table->nodes, curr);
-                node->next = next;
-            }
-
-            curr = node->next;
-            node = &darray_item(table->nodes, curr);
-        }
-
-        if (lhs_pos + 1 == production->len)
-            break;
+        node = &darray_item(builder->nodes, curr);
 
-        if (node->is_leaf) {
+        if (lhs_pos > 0 && node->is_leaf) {
             if (node->u.leaf.utf8 != 0 ||
-                node->u.leaf.keysym != XKB_KEY_NoSymbol) {
+                node->u.leaf.keysym != XKB_KEY_NoSymbol)
                 scanner_warn(s, "a sequence already exists which is a prefix of this sequence; overriding");
-                node->u.leaf.utf8 = 0;
-                node->u.leaf.keysym = XKB_KEY_NoSymbol;
-            }
-
-            {
-                uint32_t successor = add_node(table, production->lhs[lhs_pos + 1]);
-                /* Refetch since add_node could have realloc()ed. */
-                node = &darray_item(table->nodes, curr);
-                node->is_leaf = false;
-                node->u.successor = successor;
-            }
+            node->is_leaf = false;
+            node->u.successor = 0;
         }
 
-        curr = node->u.successor;
-        node = &darray_item(table->nodes, curr);
+        if (lhs_pos < common)
+            curr = builder->prev_path[lhs_pos];
+        else
+            curr = get_child(builder, curr, production->lhs[lhs_pos]);
+
+        builder->prev_lhs[lhs_pos] = production->lhs[lhs_pos];
+        builder->prev_path[lhs_pos] = curr;
     }
+    builder->prev_len = production->len;
+
+    node = &darray_item(builder->nodes, curr);
 
     if (!node->is_leaf) {
         scanner_warn(s, "this compose sequence is a prefix of another; skipping line");
@@ -468,7 +578,7 @@ do_include(struct xkb_compose_table *table, struct scanner *s,
 {
     FILE *file;
     bool ok;
-    char *string;
+    char *string, *copy;
     size_t size;
     struct scanner new_s;
 
@@ -478,6 +588,31 @@ do_include(struct xkb_compose_table *table, struct scanner *s,
         return false;
     }
 
+    /* The base of an overlay already has the sequences of its files. */
+    if (table->base) {
+        char **base_path;
+        darray_foreach(base_path, table->base->files) {
+            if (streq(*base_path, path)) {
+                log_dbg(table->ctx,
+                        "skipping include of \"%s\", which is in the base table\n",
+                        path);
+                return true;
+            }
+        }
+    }
+
+    /*
+     * Recorded before it is opened, so that the cache also notices when
+     * a file which is missing now appears later.
+     */
+    copy = strdup(path);
+    if (!copy) {
+        scanner_err(s, "failed to record included Compose file \"%s\"",
+                    path);
+        return false;
+    }
+    darray_append(table->files, copy);
+
     file = fopen(path, "rb");
     if (!file) {
         scanner_err(s, "failed to open included Compose file \"%s\": %s",
@@ -705,14 +840,320 @@ finished:
     return true;
 }
 
+struct child_ref {
+    xkb_keysym_t keysym;
+    uint32_t node;
+};
+
+static int
+compare_child_refs(const void *a, const void *b)
+{
+    const struct child_ref *ca = a, *cb = b;
+    if (ca->keysym < cb->keysym)
+        return -1;
+    if (ca->keysym > cb->keysym)
+        return 1;
+    return 0;
+}
+
+/*
+ * Lay out the parsed trie into the table, breadth first, with the
+ * children of every node contiguous and sorted by keysym.
+ */
+static void
+compile_trie(struct xkb_compose_table *table,
+             const struct compose_builder *builder)
+{
+    /* The builder node for each table node. */
+    darray(uint32_t) order = darray_new();
+    darray(struct child_ref) children = darray_new();
+    struct compose_node node;
+
+    darray_resize(table->nodes, 0);
+
+    node.keysym = XKB_KEY_NoSymbol;
+    node.is_leaf = true;
+    node.offset = 0;
+    node.u.keysym = XKB_KEY_NoSymbol;
+    darray_append(table->nodes, node);
+    darray_append(order, 0);
+
+    for (uint32_t i = 0; i < darray_size(table->nodes); i++) {
+        const struct build_node *bnode =
+            &darray_item(builder->nodes, darray_item(order, i));
+        struct child_ref *child;
+        uint32_t first;
+
+        first = bnode->is_leaf ? 0 : bnode->u.successor;
+        if (first == 0)
+            continue;
+
+        darray_resize(children, 0);
+        for (uint32_t c = first; ; ) {
+            const struct build_node *bchild = &darray_item(builder->nodes, c);
+            struct child_ref ref = { bchild->keysym, c };
+            darray_append(children, ref);
+            if (bchild->next == 0)
+                break;
+            c = bchild->next;
+        }
+        qsort(children.item, darray_size(children), sizeof(*children.item),
+              compare_child_refs);
+
+        darray_item(table->nodes, i).is_leaf = false;
+        darray_item(table->nodes, i).offset = darray_size(table->nodes);
+        darray_item(table->nodes, i).u.num_children = darray_size(children);
+
+        darray_foreach(child, children) {
+            const struct build_node *bchild =
+                &darray_item(builder->nodes, child->node);
+
+            node.keysym = bchild->keysym;
+            node.is_leaf = true;
+            node.offset = bchild->is_leaf ? bchild->u.leaf.utf8 : 0;
+            node.u.keysym =
+                bchild->is_leaf ? bchild->u.leaf.keysym : XKB_KEY_NoSymbol;
+            darray_append(table->nodes, node);
+            darray_append(order, child->node);
+        }
+    }
+
+    darray_free(order);
+    darray_free(children);
+}
+
+struct string_ref {
+    const char *string;
+    uint32_t len;
+    uint32_t offset;
+};
+
+/* Orders by the reversed strings, so that suffixes are adjacent. */
+static int
+compare_string_refs(const void *a, const void *b)
+{
+    const struct string_ref *ra = a, *rb = b;
+    uint32_t i = ra->len, j = rb->len;
+
+    while (i > 0 && j > 0) {
+        unsigned char ca = ra->string[--i], cb = rb->string[--j];
+        if (ca != cb)
+            return ca < cb ? -1 : 1;
+    }
+    if (i != j)
+        return i < j ? -1 : 1;
+    return (ra->offset > rb->offset) - (ra->offset < rb->offset);
+}
+
+/*
+ * Rebuild the utf8 array with only the strings still in use (overridden
+ * productions leave theirs behind), storing equal strings once, and
+ * strings which are a suffix of another inside it.
+ */
+static void
+compact_strings(struct xkb_compose_table *table)
+{
+    darray(struct string_ref) refs = darray_new();
+    darray_uint remap = darray_new();
+    darray_char utf8 = darray_new();
+    struct compose_node *node;
+
+    darray_foreach(node, table->nodes) {
+        if (node->is_leaf && node->offset != 0) {
+            struct string_ref ref;
+            ref.string = &darray_item(table->utf8, node->offset);
+            ref.len = strlen(ref.string);
+            ref.offset = node->offset;
+            darray_append(refs, ref);
+        }
+    }
+
+    qsort(refs.item, darray_size(refs), sizeof(*refs.item),
+          compare_string_refs);
+
+    /*
+     * In this order, if a string is a suffix of any other, it is a
+     * suffix of the one right after it.  So going backwards, the longer
+     * string is always already placed.
+     */
+    darray_resize0(remap, darray_size(table->utf8));
+    darray_append(utf8, '\0');
+    for (unsigned i = darray_size(refs); i-- > 0; ) {
+        const struct string_ref *ref = &darray_item(refs, i);
+        const struct string_ref *next =
+            i + 1 < darray_size(refs) ? &darray_item(refs, i + 1) : NULL;
+
+        if (next && next->len >= ref->len &&
+            memcmp(next->string + next->len - ref->len,
+                   ref->string, ref->len) == 0) {
+            darray_item(remap, ref->offset) =
+                darray_item(remap, next->offset) + next->len - ref->len;
+        }
+        else {
+            darray_item(remap, ref->offset) = darray_size(utf8);
+            darray_append_items(utf8, ref->string, ref->len + 1);
+        }
+    }
+
+    darray_foreach(node, table->nodes)
+        if (node->is_leaf && node->offset != 0)
+            node->offset = darray_item(remap, node->offset);
+
+    darray_free(table->utf8);
+    table->utf8.item = utf8.item;
+    table->utf8.size = utf8.size;
+    table->utf8.alloc = utf8.alloc;
+
+    darray_free(refs);
+    darray_free(remap);
+}
+
+/* A run of sibling nodes, i.e. the children of some node. */
+struct sibling_block {
+    uint32_t start;
+    /* 0 for an empty hash table entry. */
+    uint32_t len;
+    uint32_t hash;
+};
+
+static uint32_t
+hash_sibling_block(const struct xkb_compose_table *table,
+                   uint32_t start, uint32_t len)
+{
+    uint32_t hash = FNV1A_32_INIT;
+    for (uint32_t i = start; i < start + len; i++) {
+        const struct compose_node *node = &darray_item(table->nodes, i);
+        const uint32_t fields[] = {
+            node->keysym, node->is_leaf, node->offset, node->u.keysym,
+        };
+        hash = fnv1a_32(hash, fields, sizeof(fields));
+    }
+    return hash;
+}
+
+static bool
+sibling_blocks_equal(const struct xkb_compose_table *table,
+                     const struct sibling_block *a,
+                     const struct sibling_block *b)
+{
+    if (a->len != b->len || a->hash != b->hash)
+        return false;
+
+    for (uint32_t i = 0; i < a->len; i++) {
+        const struct compose_node *na = &darray_item(table->nodes, a->start + i);
+        const struct compose_node *nb = &darray_item(table->nodes, b->start + i);
+        if (na->keysym != nb->keysym || na->is_leaf != nb->is_leaf ||
+            na->offset != nb->offset || na->u.keysym != nb->u.keysym)
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ * Make all equal subtrees share a single copy, turning the trie into a
+ * DAWG.  This is common in practice, e.g. <Multi_key> <apostrophe> and
+ * <dead_acute> are followed by mostly the same sequences.
+ *
+ * Two subtrees are equal if their children are pairwise equal, so going
+ * bottom up, it suffices to compare the sibling blocks directly, once
+ * their own children have been redirected to the canonical copies.
+ * Since the nodes are in breadth-first order, going backwards over the
+ * nodes is bottom up.
+ */
+static void
+merge_subtrees(struct xkb_compose_table *table)
+{
+    darray(struct sibling_block) blocks = darray_new();
+    darray(struct compose_node) nodes = darray_new();
+    darray_uint remap = darray_new();
+    unsigned mask;
+
+    darray_resize0(blocks, 1u << msb_pos(darray_size(table->nodes)));
+    mask = darray_size(blocks) - 1;
+
+    for (uint32_t i = darray_size(table->nodes); i-- > 0; ) {
+        struct compose_node *node = &darray_item(table->nodes, i);
+        struct sibling_block block, *entry;
+
+        if (node->is_leaf)
+            continue;
+
+        block.start = node->offset;
+        block.len = node->u.num_children;
+        block.hash = hash_sibling_block(table, block.start, block.len);
+
+        for (unsigned j = block.hash & mask; ; j = (j + 1) & mask) {
+            entry = &darray_item(blocks, j);
+            if (entry->len == 0) {
+                *entry = block;
+                break;
+            }
+            if (sibling_blocks_equal(table, entry, &block)) {
+                node->offset = entry->start;
+                break;
+            }
+        }
+    }
+
+    /* Lay out the nodes again, dropping the unreferenced blocks. */
+    darray_resize0(remap, darray_size(table->nodes));
+    darray_append(nodes, darray_item(table->nodes, 0));
+    for (uint32_t i = 0; i < darray_size(nodes); i++) {
+        struct compose_node node = darray_item(nodes, i);
+
+        if (node.is_leaf)
+            continue;
+
+        if (darray_item(remap, node.offset) == 0) {
+            darray_item(remap, node.offset) = darray_size(nodes);
+            darray_append_items(nodes, &darray_item(table->nodes, node.offset),
+                                node.u.num_children);
+        }
+        darray_item(nodes, i).offset = darray_item(remap, node.offset);
+    }
+
+    darray_free(table->nodes);
+    table->nodes.item = nodes.item;
+    table->nodes.size = nodes.size;
+    table->nodes.alloc = nodes.alloc;
+
+    darray_free(blocks);
+    darray_free(remap);
+}
+
 bool
 parse_string(struct xkb_compose_table *table, const char *string, size_t len,
              const char *file_name)
 {
     struct scanner s;
-    scanner_init(&s, table->ctx, string, len, file_name, NULL);
-    if (!parse(table, &s, 0))
+    struct compose_builder builder;
+    struct build_node root = {
+        .keysym = XKB_KEY_NoSymbol,
+        .next = 0,
+        .is_leaf = false,
+        .u.successor = 0,
+    };
+    bool ok;
+
+    memset(&builder, 0, sizeof(builder));
+    darray_append(builder.nodes, root);
+
+    scanner_init(&s, table->ctx, string, len, file_name, &builder);
+    ok = parse(table, &s, 0);
+    if (ok) {
+        compile_trie(table, &builder);
+        if (table->flags & XKB_COMPOSE_COMPILE_COMPACT) {
+            compact_strings(table);
+            merge_subtrees(table);
+        }
+    }
+
+    darray_free(builder.nodes);
+    darray_free(builder.children);
+    if (!ok)
         return false;
+
     /* Maybe the allocator can use the excess space. */
     darray_shrink(table->nodes);
     darray_shrink(table->utf8);
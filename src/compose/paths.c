@@ -23,9 +23,12 @@
 
 #include "config.h"
 
+#include <sys/stat.h>
+
+#include "xkbcommon/xkbcommon.h"
 #include "utils.h"
+#include "context.h"
 #include "paths.h"
-#include "utils.h"
 
 enum resolve_name_direction {
     LEFT_TO_RIGHT,
@@ -41,46 +44,94 @@ get_xlocaledir_path(void)
     return dir;
 }
 
+struct locale_file_entry {
+    /* NULL for an empty hash table entry. */
+    const char *key;
+    const char *value;
+};
+
 /*
- * Files like compose.dir have the format LEFT: RIGHT.  Lookup @name in
- * such a file and return its matching value, according to @direction.
- * @filename is relative to the xlocaledir.
+ * A parsed compose.dir or locale.alias file, as a hash table from the
+ * names to their matching values.  It is kept until the file changes.
  */
-static char *
-resolve_name(const char *filename, enum resolve_name_direction direction,
-             const char *name)
+struct locale_file {
+    char *path;
+    int64_t mtime_sec;
+    uint32_t mtime_nsec;
+    uint64_t size;
+    /* The contents of the file; the entries point into it. */
+    char *strings;
+    /* Open addressing, linear probing; the size is a power of 2. */
+    darray(struct locale_file_entry) entries;
+};
+
+/* Kept in xkb_context::compose_locale_cache. */
+struct compose_locale_cache {
+    struct locale_file alias;
+    struct locale_file dir;
+};
+
+static void
+locale_file_clear(struct locale_file *file)
 {
-    int ret;
-    bool ok;
-    const char *xlocaledir;
-    char path[512];
-    FILE *file;
-    char *string;
-    size_t string_size;
-    const char *end;
-    const char *s, *left, *right;
-    char *match;
-    size_t left_len, right_len, name_len;
+    free(file->path);
+    free(file->strings);
+    darray_free(file->entries);
+    memset(file, 0, sizeof(*file));
+}
 
-    xlocaledir = get_xlocaledir_path();
+void
+compose_locale_cache_free(struct compose_locale_cache *cache)
+{
+    if (!cache)
+        return;
+    locale_file_clear(&cache->alias);
+    locale_file_clear(&cache->dir);
+    free(cache);
+}
 
-    ret = snprintf(path, sizeof(path), "%s/%s", xlocaledir, filename);
-    if (ret < 0 || (size_t) ret >= sizeof(path))
-        return false;
+static struct locale_file_entry *
+locale_file_find(struct locale_file *file, const char *key)
+{
+    unsigned mask = darray_size(file->entries) - 1;
+    uint32_t hash = fnv1a_32(FNV1A_32_INIT, key, strlen(key));
 
-    file = fopen(path, "rb");
-    if (!file)
-        return false;
+    for (unsigned i = hash & mask; ; i = (i + 1) & mask) {
+        struct locale_file_entry *entry = &darray_item(file->entries, i);
+        if (!entry->key || streq(entry->key, key))
+            return entry;
+    }
+}
 
-    ok = map_file(file, &string, &string_size);
-    fclose(file);
-    if (!ok)
+/*
+ * Files like compose.dir have the format LEFT: RIGHT.  Parse @string,
+ * mapping each name to its matching value, according to @direction.
+ * The first match of a name wins.  Returns false on allocation failure.
+ */
+static bool
+locale_file_parse(struct locale_file *file,
+                  enum resolve_name_direction direction,
+                  char *string, size_t string_size)
+{
+    struct {
+        char *name, *value;
+        size_t name_len, value_len;
+    } *pairs;
+    size_t num_pairs = 0, max_pairs = 0;
+    const char *end;
+    char *s, *left, *right;
+    size_t left_len, right_len;
+
+    /* Each line has at most one pair. */
+    for (size_t i = 0; i < string_size; i++)
+        if (string[i] == '\n')
+            max_pairs++;
+    pairs = calloc(max_pairs + 1, sizeof(*pairs));
+    if (!pairs)
         return false;
 
     s = string;
     end = string + string_size;
-    name_len = strlen(name);
-    match = NULL;
 
     while (s < end) {
         /* Skip spaces. */
@@ -118,28 +169,155 @@ resolve_name(const char *filename, enum resolve_name_direction direction,
         while (s < end && *s != '\n')
             s++;
 
+        if (num_pairs > max_pairs)
+            break;
         if (direction == LEFT_TO_RIGHT) {
-            if (left_len == name_len && memcmp(left, name, left_len) == 0) {
-                match = strndup(right, right_len);
-                break;
-            }
+            pairs[num_pairs].name = left;
+            pairs[num_pairs].name_len = left_len;
+            pairs[num_pairs].value = right;
+            pairs[num_pairs].value_len = right_len;
+        }
+        else {
+            pairs[num_pairs].name = right;
+            pairs[num_pairs].name_len = right_len;
+            pairs[num_pairs].value = left;
+            pairs[num_pairs].value_len = left_len;
         }
-        else if (direction == RIGHT_TO_LEFT) {
-            if (right_len == name_len && memcmp(right, name, right_len) == 0) {
-                match = strndup(left, left_len);
-                break;
-            }
+        num_pairs++;
+    }
+
+    /*
+     * Only now that the scanning is done, terminate the strings in
+     * place.  The terminators are all on separators, never inside
+     * another string.
+     */
+    for (size_t i = 0; i < num_pairs; i++) {
+        pairs[i].name[pairs[i].name_len] = '\0';
+        pairs[i].value[pairs[i].value_len] = '\0';
+    }
+
+    darray_resize0(file->entries, 1u << msb_pos(2 * num_pairs + 1));
+    for (size_t i = 0; i < num_pairs; i++) {
+        struct locale_file_entry *entry;
+
+        if (pairs[i].name_len == 0)
+            continue;
+
+        entry = locale_file_find(file, pairs[i].name);
+        if (!entry->key) {
+            entry->key = pairs[i].name;
+            entry->value = pairs[i].value;
         }
     }
 
+    free(pairs);
+    return true;
+}
+
+/*
+ * Make sure @file has the current contents of @filename, relative to
+ * the xlocaledir.  Returns false if the file cannot be read.
+ */
+static bool
+locale_file_update(struct locale_file *file, const char *filename,
+                   enum resolve_name_direction direction)
+{
+    int ret;
+    bool ok;
+    const char *xlocaledir;
+    char path[512];
+    struct stat st;
+    FILE *fp;
+    char *string;
+    size_t string_size;
+    int64_t mtime_sec;
+    uint32_t mtime_nsec;
+
+    xlocaledir = get_xlocaledir_path();
+
+    ret = snprintf(path, sizeof(path), "%s/%s", xlocaledir, filename);
+    if (ret < 0 || (size_t) ret >= sizeof(path))
+        return false;
+
+    if (stat(path, &st) != 0)
+        return false;
+
+    get_mtime(&st, &mtime_sec, &mtime_nsec);
+    if (file->path && streq(file->path, path) &&
+        file->mtime_sec == mtime_sec &&
+        file->mtime_nsec == mtime_nsec &&
+        file->size == (uint64_t) st.st_size)
+        return true;
+
+    fp = fopen(path, "rb");
+    if (!fp)
+        return false;
+
+    locale_file_clear(file);
+
+    ok = map_file(fp, &string, &string_size);
+    fclose(fp);
+    if (!ok)
+        return false;
+
+    file->strings = malloc(string_size + 1);
+    if (!file->strings) {
+        unmap_file(string, string_size);
+        return false;
+    }
+    memcpy(file->strings, string, string_size);
+    file->strings[string_size] = '\0';
     unmap_file(string, string_size);
-    return match;
+
+    /* Only a fully parsed file is marked as current. */
+    if (!locale_file_parse(file, direction, file->strings, string_size)) {
+        locale_file_clear(file);
+        return false;
+    }
+
+    file->path = strdup(path);
+    if (!file->path) {
+        locale_file_clear(file);
+        return false;
+    }
+    file->mtime_sec = mtime_sec;
+    file->mtime_nsec = mtime_nsec;
+    file->size = st.st_size;
+    return true;
+}
+
+/*
+ * Lookup @name in @filename and return its matching value, according to
+ * @direction.  The parsed file is cached on the context.
+ */
+static char *
+resolve_name(struct xkb_context *ctx, const char *filename,
+             enum resolve_name_direction direction, const char *name)
+{
+    struct compose_locale_cache *cache;
+    struct locale_file *file;
+    struct locale_file_entry *entry;
+
+    if (!ctx->compose_locale_cache) {
+        ctx->compose_locale_cache = calloc(1, sizeof(*cache));
+        if (!ctx->compose_locale_cache)
+            return NULL;
+    }
+    cache = ctx->compose_locale_cache;
+    file = direction == LEFT_TO_RIGHT ? &cache->alias : &cache->dir;
+
+    if (!locale_file_update(file, filename, direction) ||
+        darray_empty(file->entries))
+        return NULL;
+
+    entry = locale_file_find(file, name);
+    return entry->key ? strdup(entry->value) : NULL;
 }
 
 char *
-resolve_locale(const char *locale)
+resolve_locale(struct xkb_context *ctx, const char *locale)
 {
-    char *alias = resolve_name("locale.alias", LEFT_TO_RIGHT, locale);
+    char *alias = resolve_name(ctx, "locale.alias", LEFT_TO_RIGHT, locale);
     return alias ? alias : strdup(locale);
 }
 
@@ -179,7 +357,7 @@ get_home_xcompose_file_path(void)
 }
 
 char *
-get_locale_compose_file_path(const char *locale)
+get_locale_compose_file_path(struct xkb_context *ctx, const char *locale)
 {
     char *resolved;
     char *path;
@@ -198,7 +376,7 @@ get_locale_compose_file_path(const char *locale)
     if (streq(locale, "C"))
         locale = "en_US.UTF-8";
 
-    resolved = resolve_name("compose.dir", RIGHT_TO_LEFT, locale);
+    resolved = resolve_name(ctx, "compose.dir", RIGHT_TO_LEFT, locale);
     if (!resolved)
         return NULL;
 
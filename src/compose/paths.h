@@ -24,8 +24,14 @@
 #ifndef COMPOSE_RESOLVE_H
 #define COMPOSE_RESOLVE_H
 
+struct xkb_context;
+struct compose_locale_cache;
+
+void
+compose_locale_cache_free(struct compose_locale_cache *cache);
+
 char *
-resolve_locale(const char *locale);
+resolve_locale(struct xkb_context *ctx, const char *locale);
 
 const char *
 get_xlocaledir_path(void);
@@ -40,6 +46,6 @@ char *
 get_home_xcompose_file_path(void);
 
 char *
-get_locale_compose_file_path(const char *locale);
+get_locale_compose_file_path(struct xkb_context *ctx, const char *locale);
 
 #endif
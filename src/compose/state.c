@@ -43,6 +43,14 @@ struct xkb_compose_state {
      */
     uint32_t prev_context;
     uint32_t context;
+
+    /*
+     * The same, but into xkb_compose_table::base::nodes, if the table is
+     * an overlay.  These are only consulted when the corresponding
+     * overlay context is 0, i.e. the overlay has no such sequence.
+     */
+    uint32_t prev_base_context;
+    uint32_t base_context;
 };
 
 XKB_EXPORT struct xkb_compose_state *
@@ -61,6 +69,8 @@ xkb_compose_state_new(struct xkb_compose_table *table,
     state->flags = flags;
     state->prev_context = 0;
     state->context = 0;
+    state->prev_base_context = 0;
+    state->base_context = 0;
 
     return state;
 }
@@ -88,11 +98,63 @@ xkb_compose_state_get_compose_table(struct xkb_compose_state *state)
     return state->table;
 }
 
+/*
+ * Return the node at the given position, consulting the overlay before
+ * the base, and the table which contains it; or NULL if the position is
+ * the root.
+ */
+static const struct compose_node *
+get_node(const struct xkb_compose_table *table,
+         uint32_t context, uint32_t base_context,
+         const struct xkb_compose_table **owner)
+{
+    if (context != 0) {
+        *owner = table;
+        return &darray_item(table->nodes, context);
+    }
+    if (base_context != 0) {
+        *owner = table->base;
+        return &darray_item(table->base->nodes, base_context);
+    }
+    return NULL;
+}
+
+/* Returns the offset of the child of @parent with @keysym, or 0. */
+static uint32_t
+find_child(const struct xkb_compose_table *table, uint32_t parent,
+           xkb_keysym_t keysym)
+{
+    const struct compose_node *node = &darray_item(table->nodes, parent);
+    uint32_t lo, hi;
+
+    if (node->is_leaf)
+        return 0;
+
+    /* The children are sorted by keysym. */
+    lo = node->offset;
+    hi = lo + node->u.num_children;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        xkb_keysym_t mid_keysym = darray_item(table->nodes, mid).keysym;
+
+        if (mid_keysym < keysym)
+            lo = mid + 1;
+        else if (mid_keysym > keysym)
+            hi = mid;
+        else
+            return mid;
+    }
+
+    return 0;
+}
+
 XKB_EXPORT enum xkb_compose_feed_result
 xkb_compose_state_feed(struct xkb_compose_state *state, xkb_keysym_t keysym)
 {
-    uint32_t context;
+    const struct xkb_compose_table *table = state->table;
+    const struct xkb_compose_table *owner;
     const struct compose_node *node;
+    uint32_t context, base_context;
 
     /*
      * Modifiers do not affect the sequence directly.  In particular,
@@ -107,21 +169,25 @@ xkb_compose_state_feed(struct xkb_compose_state *state, xkb_keysym_t keysym)
     if (xkb_keysym_is_modifier(keysym))
         return XKB_COMPOSE_FEED_IGNORED;
 
-    node = &darray_item(state->table->nodes, state->context);
-
-    context = (node->is_leaf ? 0 : node->u.successor);
-    node = &darray_item(state->table->nodes, context);
+    node = get_node(table, state->context, state->base_context, &owner);
 
-    while (node->keysym != keysym && node->next != 0) {
-        context = node->next;
-        node = &darray_item(state->table->nodes, context);
+    /* After a finished sequence, start over from the root. */
+    if (!node || node->is_leaf) {
+        context = find_child(table, 0, keysym);
+        base_context = table->base ? find_child(table->base, 0, keysym) : 0;
+    }
+    else {
+        /* An overlay sequence takes precedence over the base. */
+        context = state->context == 0 ? 0 :
+            find_child(table, state->context, keysym);
+        base_context = state->base_context == 0 ? 0 :
+            find_child(table->base, state->base_context, keysym);
     }
-
-    if (node->keysym != keysym)
-        context = 0;
 
     state->prev_context = state->context;
     state->context = context;
+    state->prev_base_context = state->base_context;
+    state->base_context = base_context;
     return XKB_COMPOSE_FEED_ACCEPTED;
 }
 
@@ -130,20 +196,25 @@ xkb_compose_state_reset(struct xkb_compose_state *state)
 {
     state->prev_context = 0;
     state->context = 0;
+    state->prev_base_context = 0;
+    state->base_context = 0;
 }
 
 XKB_EXPORT enum xkb_compose_status
 xkb_compose_state_get_status(struct xkb_compose_state *state)
 {
+    const struct xkb_compose_table *owner;
     const struct compose_node *prev_node, *node;
 
-    prev_node = &darray_item(state->table->nodes, state->prev_context);
-    node = &darray_item(state->table->nodes, state->context);
+    prev_node = get_node(state->table, state->prev_context,
+                         state->prev_base_context, &owner);
+    node = get_node(state->table, state->context, state->base_context,
+                    &owner);
 
-    if (state->context == 0 && !prev_node->is_leaf)
+    if (!node && prev_node && !prev_node->is_leaf)
         return XKB_COMPOSE_CANCELLED;
 
-    if (state->context == 0)
+    if (!node)
         return XKB_COMPOSE_NOTHING;
 
     if (!node->is_leaf)
@@ -152,47 +223,110 @@ xkb_compose_state_get_status(struct xkb_compose_state *state)
     return XKB_COMPOSE_COMPOSED;
 }
 
-XKB_EXPORT int
-xkb_compose_state_get_utf8(struct xkb_compose_state *state,
-                           char *buffer, size_t size)
+/*
+ * Returns the result string of the current sequence, or NULL if it is
+ * not complete or has no viable result string.  @name is used for the
+ * string of a result keysym.
+ */
+static const char *
+get_result_utf8(struct xkb_compose_state *state, char name[64])
 {
+    const struct xkb_compose_table *owner;
     const struct compose_node *node =
-        &darray_item(state->table->nodes, state->context);
+        get_node(state->table, state->context, state->base_context, &owner);
 
-    if (!node->is_leaf)
-        goto fail;
+    if (!node || !node->is_leaf)
+        return NULL;
 
     /* If there's no string specified, but only a keysym, try to do the
      * most helpful thing. */
-    if (node->u.leaf.utf8 == 0 && node->u.leaf.keysym != XKB_KEY_NoSymbol) {
-        char name[64];
+    if (node->offset == 0 && node->u.keysym != XKB_KEY_NoSymbol) {
         int ret;
 
-        ret = xkb_keysym_to_utf8(node->u.leaf.keysym, name, sizeof(name));
+        ret = xkb_keysym_to_utf8(node->u.keysym, name, 64);
         if (ret < 0 || ret == 0) {
             /* ret < 0 is impossible.
              * ret == 0 means the keysym has no string representation. */
-            goto fail;
+            return NULL;
         }
 
-        return snprintf(buffer, size, "%s", name);
+        return name;
     }
 
-    return snprintf(buffer, size, "%s",
-                    &darray_item(state->table->utf8, node->u.leaf.utf8));
+    return &darray_item(owner->utf8, node->offset);
+}
 
-fail:
-    if (size > 0)
-        buffer[0] = '\0';
-    return 0;
+XKB_EXPORT int
+xkb_compose_state_get_utf8(struct xkb_compose_state *state,
+                           char *buffer, size_t size)
+{
+    char name[64];
+    const char *utf8 = get_result_utf8(state, name);
+
+    if (!utf8) {
+        if (size > 0)
+            buffer[0] = '\0';
+        return 0;
+    }
+
+    return snprintf(buffer, size, "%s", utf8);
 }
 
 XKB_EXPORT xkb_keysym_t
 xkb_compose_state_get_one_sym(struct xkb_compose_state *state)
 {
+    const struct xkb_compose_table *owner;
     const struct compose_node *node =
-        &darray_item(state->table->nodes, state->context);
-    if (!node->is_leaf)
+        get_node(state->table, state->context, state->base_context, &owner);
+    if (!node || !node->is_leaf)
         return XKB_KEY_NoSymbol;
-    return node->u.leaf.keysym;
+    return node->u.keysym;
+}
+
+XKB_EXPORT int
+xkb_compose_state_feed_keysyms(struct xkb_compose_state *state,
+                               const xkb_keysym_t *keysyms, size_t count,
+                               enum xkb_compose_status *statuses,
+                               char *buffer, size_t size)
+{
+    size_t offset = 0;
+    /* Number of bytes written; stops growing once the buffer is full. */
+    size_t written = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        enum xkb_compose_feed_result result;
+        enum xkb_compose_status status;
+        const char *utf8 = NULL;
+        char name[64];
+        size_t len;
+
+        result = xkb_compose_state_feed(state, keysyms[i]);
+        status = xkb_compose_state_get_status(state);
+        if (statuses)
+            statuses[i] = status;
+
+        if (result == XKB_COMPOSE_FEED_IGNORED)
+            continue;
+
+        if (status == XKB_COMPOSE_COMPOSED)
+            utf8 = get_result_utf8(state, name);
+        else if (status == XKB_COMPOSE_NOTHING &&
+                 xkb_keysym_to_utf8(keysyms[i], name, sizeof(name)) > 0)
+            utf8 = name;
+        if (!utf8)
+            continue;
+
+        len = strlen(utf8);
+        /* Only write whole strings. */
+        if (written == offset && offset + len < size) {
+            memcpy(buffer + offset, utf8, len);
+            written += len;
+        }
+        offset += len;
+    }
+
+    if (size > 0)
+        buffer[written] = '\0';
+
+    return (int) offset;
 }
@@ -27,6 +27,7 @@
 #include "table.h"
 #include "parser.h"
 #include "paths.h"
+#include "cache.h"
 
 static struct xkb_compose_table *
 xkb_compose_table_new(struct xkb_context *ctx,
@@ -38,7 +39,7 @@ xkb_compose_table_new(struct xkb_context *ctx,
     struct xkb_compose_table *table;
     struct compose_node root;
 
-    resolved_locale = resolve_locale(locale);
+    resolved_locale = resolve_locale(ctx, locale);
     if (!resolved_locale)
         return NULL;
 
@@ -57,12 +58,12 @@ xkb_compose_table_new(struct xkb_context *ctx,
 
     darray_init(table->nodes);
     darray_init(table->utf8);
+    darray_init(table->files);
 
     root.keysym = XKB_KEY_NoSymbol;
-    root.next = 0;
     root.is_leaf = true;
-    root.u.leaf.utf8 = 0;
-    root.u.leaf.keysym = XKB_KEY_NoSymbol;
+    root.offset = 0;
+    root.u.keysym = XKB_KEY_NoSymbol;
     darray_append(table->nodes, root);
 
     darray_append(table->utf8, '\0');
@@ -80,15 +81,33 @@ xkb_compose_table_ref(struct xkb_compose_table *table)
 XKB_EXPORT void
 xkb_compose_table_unref(struct xkb_compose_table *table)
 {
+    char **path;
+
     if (!table || --table->refcnt > 0)
         return;
     free(table->locale);
-    darray_free(table->nodes);
-    darray_free(table->utf8);
+    if (table->cache_map) {
+        unmap_file(table->cache_map, table->cache_map_size);
+    }
+    else {
+        darray_free(table->nodes);
+        darray_free(table->utf8);
+    }
+    darray_foreach(path, table->files)
+        free(*path);
+    darray_free(table->files);
+    xkb_compose_table_unref(table->base);
     xkb_context_unref(table->ctx);
     free(table);
 }
 
+XKB_EXPORT size_t
+xkb_compose_table_get_memory_size(struct xkb_compose_table *table)
+{
+    return darray_size(table->nodes) * sizeof(struct compose_node) +
+           darray_size(table->utf8);
+}
+
 XKB_EXPORT struct xkb_compose_table *
 xkb_compose_table_new_from_file(struct xkb_context *ctx,
                                 FILE *file,
@@ -99,7 +118,8 @@ xkb_compose_table_new_from_file(struct xkb_context *ctx,
     struct xkb_compose_table *table;
     bool ok;
 
-    if (flags & ~(XKB_COMPOSE_COMPILE_NO_FLAGS)) {
+    if (flags & ~(XKB_COMPOSE_COMPILE_USE_CACHE |
+                  XKB_COMPOSE_COMPILE_COMPACT)) {
         log_err_func(ctx, "unrecognized flags: %#x\n", flags);
         return NULL;
     }
@@ -132,7 +152,8 @@ xkb_compose_table_new_from_buffer(struct xkb_context *ctx,
     struct xkb_compose_table *table;
     bool ok;
 
-    if (flags & ~(XKB_COMPOSE_COMPILE_NO_FLAGS)) {
+    if (flags & ~(XKB_COMPOSE_COMPILE_USE_CACHE |
+                  XKB_COMPOSE_COMPILE_COMPACT)) {
         log_err_func(ctx, "unrecognized flags: %#x\n", flags);
         return NULL;
     }
@@ -161,11 +182,12 @@ xkb_compose_table_new_from_locale(struct xkb_context *ctx,
                                   enum xkb_compose_compile_flags flags)
 {
     struct xkb_compose_table *table;
-    char *path;
+    char *path, *copy;
     FILE *file;
     bool ok;
 
-    if (flags & ~(XKB_COMPOSE_COMPILE_NO_FLAGS)) {
+    if (flags & ~(XKB_COMPOSE_COMPILE_USE_CACHE |
+                  XKB_COMPOSE_COMPILE_COMPACT)) {
         log_err_func(ctx, "unrecognized flags: %#x\n", flags);
         return NULL;
     }
@@ -199,7 +221,7 @@ xkb_compose_table_new_from_locale(struct xkb_context *ctx,
     }
     free(path);
 
-    path = get_locale_compose_file_path(table->locale);
+    path = get_locale_compose_file_path(ctx, table->locale);
     if (path) {
         file = fopen(path, "rb");
         if (file)
@@ -212,6 +234,22 @@ xkb_compose_table_new_from_locale(struct xkb_context *ctx,
     return NULL;
 
 found_path:
+    copy = strdup(path);
+    if (!copy) {
+        fclose(file);
+        free(path);
+        xkb_compose_table_unref(table);
+        return NULL;
+    }
+    darray_append(table->files, copy);
+
+    if ((flags & XKB_COMPOSE_COMPILE_USE_CACHE) &&
+        compose_cache_load(table, path)) {
+        fclose(file);
+        free(path);
+        return table;
+    }
+
     ok = parse_file(table, file, path);
     fclose(file);
     if (!ok) {
@@ -220,9 +258,87 @@ found_path:
         return NULL;
     }
 
+    if (flags & XKB_COMPOSE_COMPILE_USE_CACHE)
+        compose_cache_save(table, path);
+
     log_dbg(ctx, "created compose table from locale %s with path %s\n",
             table->locale, path);
 
     free(path);
     return table;
 }
+
+static struct xkb_compose_table *
+xkb_compose_table_new_overlay(struct xkb_compose_table *base,
+                              enum xkb_compose_format format,
+                              enum xkb_compose_compile_flags flags)
+{
+    struct xkb_compose_table *table;
+
+    if (flags & ~(XKB_COMPOSE_COMPILE_USE_CACHE |
+                  XKB_COMPOSE_COMPILE_COMPACT)) {
+        log_err_func(base->ctx, "unrecognized flags: %#x\n", flags);
+        return NULL;
+    }
+
+    if (format != XKB_COMPOSE_FORMAT_TEXT_V1) {
+        log_err_func(base->ctx, "unsupported compose format: %d\n", format);
+        return NULL;
+    }
+
+    if (base->base) {
+        log_err_func1(base->ctx, "the base table cannot be an overlay\n");
+        return NULL;
+    }
+
+    table = xkb_compose_table_new(base->ctx, base->locale, format, flags);
+    if (!table)
+        return NULL;
+
+    table->base = xkb_compose_table_ref(base);
+    return table;
+}
+
+XKB_EXPORT struct xkb_compose_table *
+xkb_compose_table_new_overlay_from_file(struct xkb_compose_table *base,
+                                        FILE *file,
+                                        enum xkb_compose_format format,
+                                        enum xkb_compose_compile_flags flags)
+{
+    struct xkb_compose_table *table;
+    bool ok;
+
+    table = xkb_compose_table_new_overlay(base, format, flags);
+    if (!table)
+        return NULL;
+
+    ok = parse_file(table, file, "(unknown file)");
+    if (!ok) {
+        xkb_compose_table_unref(table);
+        return NULL;
+    }
+
+    return table;
+}
+
+XKB_EXPORT struct xkb_compose_table *
+xkb_compose_table_new_overlay_from_buffer(struct xkb_compose_table *base,
+                                          const char *buffer, size_t length,
+                                          enum xkb_compose_format format,
+                                          enum xkb_compose_compile_flags flags)
+{
+    struct xkb_compose_table *table;
+    bool ok;
+
+    table = xkb_compose_table_new_overlay(base, format, flags);
+    if (!table)
+        return NULL;
+
+    ok = parse_string(table, buffer, length, "(input string)");
+    if (!ok) {
+        xkb_compose_table_unref(table);
+        return NULL;
+    }
+
+    return table;
+}
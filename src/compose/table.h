@@ -38,27 +38,37 @@
  *
  * the trie would look like:
  *
- * [root] ---> [<A>] -----------------> [<E>] -#
- *   |           |                        |
- *   #           v                        v
- *             [<B>] ---> [<C>] -#      [<F>] -#
- *               |          |             -
- *               #          v             #
- *                        [<D>] -#
- *                          |
- *                          #
+ *   [root]
+ *     |
+ *     v
+ *   [<A>] [<E>]
+ *     |     |
+ *     |     +---------------+
+ *     v                     v
+ *   [<B>] [<C>]           [<F>]
+ *           |
+ *           v
+ *         [<D>]
+ *
  * where:
  * - [root] is a special empty root node.
  * - [<X>] is a node for a sequence keysym <X>.
- * - right arrows are `next` pointers.
- * - down arrows are `successor` pointers.
- * - # is a nil pointer.
+ * - nodes drawn side by side are siblings, and are adjacent in memory.
+ * - down arrows are `offset`s, pointing to the first child.
  *
  * The nodes are all kept in a contiguous array.  Pointers are represented
- * as integer offsets into this array.  A nil pointer is represented as 0
- * (which, helpfully, is the offset of the empty root node).
+ * as integer offsets into this array.  The root node is at offset 0.
+ *
+ * The children of a node are kept contiguously, sorted by keysym, so
+ * that finding the next node while composing is a binary search.  The
+ * nodes are laid out in breadth-first order, and are only written once
+ * the whole file has been parsed; the parser uses its own representation
+ * while building the trie (see parser.c).
  *
- * Nodes without a successor are leaf nodes.  Since a sequence cannot be a
+ * With XKB_COMPOSE_COMPILE_COMPACT, equal subtrees are stored once, so a
+ * node may be reachable by more than one sequence (see merge_subtrees()).
+ *
+ * Nodes without children are leaf nodes.  Since a sequence cannot be a
  * prefix of another, these are exactly the nodes which terminate the
  * sequences (in a bijective manner).
  *
@@ -70,18 +80,19 @@
 
 struct compose_node {
     xkb_keysym_t keysym;
-    /* Offset into xkb_compose_table::nodes. */
-    unsigned int next:31;
     bool is_leaf:1;
 
+    /*
+     * Internal nodes: offset into xkb_compose_table::nodes of the first
+     * child.  Leaf nodes: offset into xkb_compose_table::utf8.
+     */
+    uint32_t offset:31;
+
     union {
-        /* Offset into xkb_compose_table::nodes. */
-        uint32_t successor;
-        struct {
-            /* Offset into xkb_compose_table::utf8. */
-            uint32_t utf8;
-            xkb_keysym_t keysym;
-        } leaf;
+        /* Internal nodes: the number of children. */
+        uint32_t num_children;
+        /* Leaf nodes: the result keysym. */
+        xkb_keysym_t keysym;
     } u;
 };
 
@@ -93,8 +104,21 @@ struct xkb_compose_table {
 
     char *locale;
 
+    /* If the table is an overlay, the table underneath it. */
+    struct xkb_compose_table *base;
+
     darray_char utf8;
     darray(struct compose_node) nodes;
+
+    /* Paths of the Compose files the table was compiled from. */
+    darray(char *) files;
+
+    /*
+     * If the table was loaded from the cache, the file mapping which
+     * utf8 and nodes point into (see cache.c).
+     */
+    char *cache_map;
+    size_t cache_map_size;
 };
 
 #endif
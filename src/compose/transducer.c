@@ -0,0 +1,298 @@
+/*
+ * Copyright © 2021 The libxkbcommon contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include "xkbcommon/xkbcommon-compose.h"
+#include "utils.h"
+#include "keymap.h"
+
+/* The keysym and string of a key level, see xkb_state_key_get_one_sym(). */
+struct level_text {
+    xkb_keysym_t keysym;
+    /* The keysym with the Caps Lock transformation applied. */
+    xkb_keysym_t upper;
+    /*
+     * The level has more than one keysym; its keysym is then NoSymbol,
+     * and its string is found with xkb_state_key_get_utf8().
+     */
+    bool multiple_syms;
+    char utf8[5];
+    char upper_utf8[5];
+};
+
+struct key_text {
+    /* Index of the first level of the key in xkb_text_transducer::levels. */
+    uint32_t first;
+    /* The maximum number of levels over all the layouts of the key. */
+    xkb_level_index_t num_levels;
+    xkb_layout_index_t num_layouts;
+};
+
+struct xkb_text_transducer {
+    int refcnt;
+    enum xkb_text_transducer_flags flags;
+
+    struct xkb_state *state;
+    struct xkb_compose_state *compose_state;
+
+    xkb_mod_index_t caps;
+    xkb_mod_index_t ctrl;
+
+    xkb_keycode_t min_key_code;
+    xkb_keycode_t max_key_code;
+    /* Indexed by keycode - min_key_code. */
+    struct key_text *keys;
+    darray(struct level_text) levels;
+};
+
+/* The level of keys without a level in the current state. */
+static const struct level_text no_level;
+
+static void
+keysym_to_utf8(xkb_keysym_t keysym, char utf8[5])
+{
+    char buffer[7];
+
+    if (xkb_keysym_to_utf8(keysym, buffer, sizeof(buffer)) <= 0)
+        buffer[0] = '\0';
+    memcpy(utf8, buffer, 5);
+    utf8[4] = '\0';
+}
+
+static void
+add_levels(struct xkb_text_transducer *transducer,
+           struct xkb_keymap *keymap, xkb_keycode_t kc)
+{
+    struct key_text *key =
+        &transducer->keys[kc - transducer->min_key_code];
+
+    key->first = darray_size(transducer->levels);
+    key->num_layouts = xkb_keymap_num_layouts_for_key(keymap, kc);
+    key->num_levels = 0;
+    for (xkb_layout_index_t layout = 0; layout < key->num_layouts; layout++)
+        key->num_levels = MAX(key->num_levels,
+                              xkb_keymap_num_levels_for_key(keymap, kc,
+                                                            layout));
+
+    for (xkb_layout_index_t layout = 0; layout < key->num_layouts; layout++) {
+        for (xkb_level_index_t level = 0; level < key->num_levels; level++) {
+            struct level_text text = { 0 };
+            const xkb_keysym_t *syms;
+            int nsyms;
+
+            nsyms = xkb_keymap_key_get_syms_by_level(keymap, kc, layout,
+                                                     level, &syms);
+            text.keysym = nsyms == 1 ? syms[0] : XKB_KEY_NoSymbol;
+            text.upper = xkb_keysym_to_upper(text.keysym);
+            text.multiple_syms = nsyms > 1;
+            keysym_to_utf8(text.keysym, text.utf8);
+            keysym_to_utf8(text.upper, text.upper_utf8);
+
+            darray_append(transducer->levels, text);
+        }
+    }
+}
+
+XKB_EXPORT struct xkb_text_transducer *
+xkb_text_transducer_new(struct xkb_keymap *keymap,
+                        struct xkb_compose_table *table,
+                        enum xkb_text_transducer_flags flags)
+{
+    struct xkb_text_transducer *transducer;
+    size_t num_keys;
+
+    if (flags & ~(XKB_TEXT_TRANSDUCER_NO_FLAGS)) {
+        log_err_func(keymap->ctx, "unrecognized flags: %#x\n", flags);
+        return NULL;
+    }
+
+    transducer = calloc(1, sizeof(*transducer));
+    if (!transducer)
+        return NULL;
+
+    transducer->refcnt = 1;
+    transducer->flags = flags;
+    darray_init(transducer->levels);
+
+    transducer->state = xkb_state_new(keymap);
+    if (!transducer->state)
+        goto err;
+
+    if (table) {
+        transducer->compose_state =
+            xkb_compose_state_new(table, XKB_COMPOSE_STATE_NO_FLAGS);
+        if (!transducer->compose_state)
+            goto err;
+    }
+
+    transducer->caps = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_CAPS);
+    transducer->ctrl = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_CTRL);
+
+    transducer->min_key_code = xkb_keymap_min_keycode(keymap);
+    transducer->max_key_code = xkb_keymap_max_keycode(keymap);
+    num_keys = transducer->max_key_code - transducer->min_key_code + 1;
+    transducer->keys = calloc(num_keys, sizeof(*transducer->keys));
+    if (!transducer->keys)
+        goto err;
+
+    for (xkb_keycode_t kc = transducer->min_key_code;
+         kc <= transducer->max_key_code; kc++)
+        add_levels(transducer, keymap, kc);
+
+    return transducer;
+
+err:
+    xkb_text_transducer_unref(transducer);
+    return NULL;
+}
+
+XKB_EXPORT struct xkb_text_transducer *
+xkb_text_transducer_ref(struct xkb_text_transducer *transducer)
+{
+    transducer->refcnt++;
+    return transducer;
+}
+
+XKB_EXPORT void
+xkb_text_transducer_unref(struct xkb_text_transducer *transducer)
+{
+    if (!transducer || --transducer->refcnt > 0)
+        return;
+
+    darray_free(transducer->levels);
+    free(transducer->keys);
+    xkb_compose_state_unref(transducer->compose_state);
+    xkb_state_unref(transducer->state);
+    free(transducer);
+}
+
+XKB_EXPORT struct xkb_state *
+xkb_text_transducer_get_state(struct xkb_text_transducer *transducer)
+{
+    return transducer->state;
+}
+
+XKB_EXPORT struct xkb_compose_state *
+xkb_text_transducer_get_compose_state(struct xkb_text_transducer *transducer)
+{
+    return transducer->compose_state;
+}
+
+static const struct level_text *
+get_level_text(struct xkb_text_transducer *transducer, xkb_keycode_t kc)
+{
+    const struct key_text *key;
+    xkb_layout_index_t layout;
+    xkb_level_index_t level;
+
+    if (kc < transducer->min_key_code || kc > transducer->max_key_code)
+        return &no_level;
+
+    key = &transducer->keys[kc - transducer->min_key_code];
+    if (key->num_layouts == 0)
+        return &no_level;
+
+    layout = xkb_state_key_get_layout(transducer->state, kc);
+    if (layout == XKB_LAYOUT_INVALID)
+        return &no_level;
+
+    level = xkb_state_key_get_level(transducer->state, kc, layout);
+    if (level == XKB_LEVEL_INVALID)
+        return &no_level;
+
+    return &darray_item(transducer->levels,
+                        key->first + layout * key->num_levels + level);
+}
+
+/* Whether the Caps or Control transformation applies; see state.c. */
+static bool
+should_do_transformation(struct xkb_state *state, xkb_keycode_t kc,
+                         xkb_mod_index_t mod)
+{
+    return
+        mod != XKB_MOD_INVALID &&
+        xkb_state_mod_index_is_active(state, mod, XKB_STATE_MODS_EFFECTIVE) > 0 &&
+        xkb_state_mod_index_is_consumed(state, kc, mod) == 0;
+}
+
+XKB_EXPORT int
+xkb_text_transducer_key(struct xkb_text_transducer *transducer,
+                        xkb_keycode_t kc, enum xkb_key_direction direction,
+                        char *buffer, size_t size)
+{
+    struct xkb_state *state = transducer->state;
+    struct xkb_compose_state *compose_state = transducer->compose_state;
+    enum xkb_compose_status status = XKB_COMPOSE_NOTHING;
+    const struct level_text *level;
+    xkb_keysym_t keysym;
+    const char *utf8;
+    int ret;
+
+    /* Releases produce no text, but must still release modifiers. */
+    if (direction != XKB_KEY_DOWN) {
+        xkb_state_update_key(state, kc, direction);
+        if (size > 0)
+            buffer[0] = '\0';
+        return 0;
+    }
+
+    level = get_level_text(transducer, kc);
+    if (!level->multiple_syms &&
+        should_do_transformation(state, kc, transducer->caps)) {
+        keysym = level->upper;
+        utf8 = level->upper_utf8;
+    }
+    else {
+        keysym = level->keysym;
+        utf8 = level->utf8;
+    }
+
+    if (compose_state &&
+        xkb_compose_state_feed(compose_state, keysym) ==
+        XKB_COMPOSE_FEED_ACCEPTED)
+        status = xkb_compose_state_get_status(compose_state);
+
+    if (status == XKB_COMPOSE_COMPOSED) {
+        ret = xkb_compose_state_get_utf8(compose_state, buffer, size);
+    }
+    else if (status != XKB_COMPOSE_NOTHING) {
+        ret = 0;
+        if (size > 0)
+            buffer[0] = '\0';
+    }
+    else if (level->multiple_syms ||
+             should_do_transformation(state, kc, transducer->ctrl)) {
+        /*
+         * The Control transformation may take the string from another
+         * layout, so leave it to the state.
+         */
+        ret = xkb_state_key_get_utf8(state, kc, buffer, size);
+    }
+    else {
+        ret = snprintf(buffer, size, "%s", utf8);
+    }
+
+    xkb_state_update_key(state, kc, XKB_KEY_DOWN);
+    return ret;
+}
@@ -42,6 +42,7 @@
 #include "xkbcommon/xkbcommon.h"
 #include "utils.h"
 #include "context.h"
+#include "compose/paths.h"
 
 /**
  * Append one directory to the context's include path.
@@ -211,6 +212,10 @@ xkb_context_unref(struct xkb_context *ctx)
         return;
 
     free(ctx->x11_atom_cache);
+    /* Empty by now, as each keymap holds a reference on the context. */
+    darray_free(ctx->keymap_cache);
+    free(ctx->shared_blocks);
+    compose_locale_cache_free(ctx->compose_locale_cache);
     xkb_context_include_path_clear(ctx);
     atom_table_free(ctx->atom_table);
     free(ctx);
@@ -325,6 +330,7 @@ xkb_context_new(enum xkb_context_flags flags)
     }
 
     ctx->x11_atom_cache = NULL;
+    ctx->compose_locale_cache = NULL;
 
     return ctx;
 }
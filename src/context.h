@@ -48,6 +48,27 @@ struct xkb_context {
     /* Used and allocated by xkbcommon-x11, free()d with the context. */
     void *x11_atom_cache;
 
+    /*
+     * Keymaps which may be reused, by key, see xkb_keymap_cache_lookup().
+     * A keymap may be there under several keys. The keymaps are not
+     * referenced; a keymap removes itself when it is freed.
+     */
+    darray(struct keymap_cache_entry {
+        char *key;
+        struct xkb_keymap *keymap;
+    }) keymap_cache;
+
+    /*
+     * Parts of keymaps shared between them, by content; see
+     * keymap-share.c. A hash table with chained buckets.
+     */
+    struct shared_block **shared_blocks;
+    unsigned int shared_blocks_size;
+    unsigned int num_shared_blocks;
+
+    /* Parsed compose.dir and locale.alias files; see compose/paths.c. */
+    struct compose_locale_cache *compose_locale_cache;
+
     /* Buffer for the *Text() functions. */
     char text_buffer[2048];
     size_t text_next;
@@ -68,12 +68,105 @@ xkb_keymap_new(struct xkb_context *ctx,
 
     keymap->format = format;
     keymap->flags = flags;
+    keymap->fd = -1;
 
     update_builtin_keymap_fields(keymap);
 
     return keymap;
 }
 
+/*
+ * A per-context cache of keymaps by arbitrary string keys, which describe
+ * how the keymap was created or what it holds. The cache doesn't hold a
+ * reference; xkb_keymap_unref() removes the keymap when it is freed.
+ */
+
+/* Returns a new reference, or NULL if there is no such keymap. */
+struct xkb_keymap *
+xkb_keymap_cache_lookup(struct xkb_context *ctx, const char *key)
+{
+    struct keymap_cache_entry *entry;
+
+    darray_foreach(entry, ctx->keymap_cache)
+        if (streq(entry->key, key))
+            return xkb_keymap_ref(entry->keymap);
+
+    return NULL;
+}
+
+/* Best effort; the keymap is just not cached on failure. */
+void
+xkb_keymap_cache_add(struct xkb_keymap *keymap, const char *key)
+{
+    struct keymap_cache_entry entry;
+
+    entry.key = strdup(key);
+    if (!entry.key)
+        return;
+    entry.keymap = keymap;
+
+    darray_append(keymap->ctx->keymap_cache, entry);
+    keymap->cached = true;
+}
+
+void
+xkb_keymap_cache_remove(struct xkb_keymap *keymap)
+{
+    struct xkb_context *ctx = keymap->ctx;
+    unsigned i = 0;
+
+    if (!keymap->cached)
+        return;
+
+    while (i < darray_size(ctx->keymap_cache)) {
+        struct keymap_cache_entry *entry = &darray_item(ctx->keymap_cache, i);
+
+        if (entry->keymap != keymap) {
+            i++;
+            continue;
+        }
+
+        free(entry->key);
+        *entry = darray_item(ctx->keymap_cache,
+                             darray_size(ctx->keymap_cache) - 1);
+        darray_size(ctx->keymap_cache)--;
+    }
+
+    keymap->cached = false;
+}
+
+/*
+ * Replace a freshly compiled keymap with an identical one from the cache,
+ * by its fingerprint, or else add it there. Returns the keymap to use,
+ * taking over the reference on @keymap.
+ */
+struct xkb_keymap *
+xkb_keymap_cache_dedup(struct xkb_keymap *keymap)
+{
+    char key[3 + 2 * XKB_KEYMAP_FINGERPRINT_SIZE + 1] = "fp:";
+    const uint8_t *fingerprint;
+    struct xkb_keymap *cached;
+
+    fingerprint = xkb_keymap_get_fingerprint(keymap);
+    if (!fingerprint)
+        return keymap;
+
+    for (unsigned i = 0; i < XKB_KEYMAP_FINGERPRINT_SIZE; i++)
+        snprintf(key + 3 + 2 * i, 3, "%02x", fingerprint[i]);
+
+    cached = xkb_keymap_cache_lookup(keymap->ctx, key);
+    if (cached) {
+        if (cached != keymap)
+            xkb_keymap_unref(keymap);
+        else
+            xkb_keymap_unref(cached);
+        return cached;
+    }
+
+    xkb_keymap_cache_add(keymap, key);
+    return keymap;
+}
+
 struct xkb_key *
 XkbKeyByName(struct xkb_keymap *keymap, xkb_atom_t name, bool use_aliases)
 {
@@ -0,0 +1,579 @@
+/*
+ * Copyright © 2021 The libxkbcommon contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sharing of the immutable parts of keymaps.
+ *
+ * Once a keymap is complete, its key types, the groups of each key and
+ * the levels of each group are moved into refcounted blocks, which are
+ * interned in the context by their content. Keymaps with the same types
+ * or key definitions, e.g. compiled from overlapping RMLVOs, then point
+ * to the same memory. Nothing writes to a complete keymap, so the blocks
+ * need no copy-on-write beyond that.
+ *
+ * Each keymap holds a reference on its types block, on the groups block
+ * of each key and on the levels block of each group, whether it made them
+ * or found them in the context.
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+
+#include "keymap.h"
+
+enum block_kind {
+    BLOCK_TYPES,
+    BLOCK_GROUPS,
+    BLOCK_LEVELS,
+};
+
+struct shared_block {
+    struct shared_block *next;
+    enum block_kind kind;
+    uint32_t hash;
+    unsigned int refcnt;
+    /* The number of types, groups or levels at the start of the data. */
+    unsigned int count;
+    size_t size;
+    /* Aligned for any of the keymap structs. */
+    union {
+        void *ptr;
+        uint64_t u64;
+        double d;
+    } data[];
+};
+
+static struct shared_block *
+block_of(const void *data)
+{
+    return (struct shared_block *)
+        ((char *) data - offsetof(struct shared_block, data));
+}
+
+static struct shared_block *
+block_new(enum block_kind kind, unsigned int count, size_t size)
+{
+    struct shared_block *block;
+
+    block = calloc(1, offsetof(struct shared_block, data) + size);
+    if (!block)
+        return NULL;
+
+    block->kind = kind;
+    block->refcnt = 1;
+    block->count = count;
+    block->size = size;
+    return block;
+}
+
+#define hash_value(hash, value) fnv1a_32(hash, &(value), sizeof(value))
+
+/*
+ * The hash and equality of the blocks only look at the content, not at
+ * the pointers into the block itself.
+ */
+
+static uint32_t
+hash_types(const struct xkb_key_type *types, unsigned int num_types)
+{
+    uint32_t hash = FNV1A_32_INIT;
+
+    for (unsigned i = 0; i < num_types; i++) {
+        const struct xkb_key_type *type = &types[i];
+
+        hash = hash_value(hash, type->name);
+        hash = hash_value(hash, type->mods.mods);
+        hash = hash_value(hash, type->num_levels);
+        hash = hash_value(hash, type->num_entries);
+        hash = fnv1a_32(hash, type->entries,
+                        type->num_entries * sizeof(*type->entries));
+        hash = hash_value(hash, type->num_level_names);
+        hash = fnv1a_32(hash, type->level_names,
+                        type->num_level_names * sizeof(*type->level_names));
+    }
+
+    return hash;
+}
+
+static bool
+types_equal(const struct xkb_key_type *a, const struct xkb_key_type *b,
+            unsigned int num_types)
+{
+    for (unsigned i = 0; i < num_types; i++) {
+        if (a[i].name != b[i].name ||
+            a[i].mods.mods != b[i].mods.mods ||
+            a[i].mods.mask != b[i].mods.mask ||
+            a[i].num_levels != b[i].num_levels ||
+            a[i].num_entries != b[i].num_entries ||
+            a[i].num_level_names != b[i].num_level_names)
+            return false;
+
+        /* entries and level_names are NULL when empty. */
+        if (a[i].num_entries &&
+            memcmp(a[i].entries, b[i].entries,
+                   a[i].num_entries * sizeof(*a[i].entries)) != 0)
+            return false;
+        if (a[i].num_level_names &&
+            memcmp(a[i].level_names, b[i].level_names,
+                   a[i].num_level_names * sizeof(*a[i].level_names)) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+/* The groups only point to interned types and levels, so are compared
+ * by pointer. */
+static uint32_t
+hash_groups(const struct xkb_group *groups, unsigned int num_groups)
+{
+    uint32_t hash = FNV1A_32_INIT;
+
+    for (unsigned i = 0; i < num_groups; i++) {
+        hash = hash_value(hash, groups[i].explicit_type);
+        hash = hash_value(hash, groups[i].type);
+        hash = hash_value(hash, groups[i].levels);
+    }
+
+    return hash;
+}
+
+static bool
+groups_equal(const struct xkb_group *a, const struct xkb_group *b,
+             unsigned int num_groups)
+{
+    for (unsigned i = 0; i < num_groups; i++)
+        if (a[i].explicit_type != b[i].explicit_type ||
+            a[i].type != b[i].type ||
+            a[i].levels != b[i].levels)
+            return false;
+
+    return true;
+}
+
+static uint32_t
+hash_levels(const struct xkb_level *levels, unsigned int num_levels)
+{
+    uint32_t hash = FNV1A_32_INIT;
+
+    for (unsigned i = 0; i < num_levels; i++) {
+        const struct xkb_level *level = &levels[i];
+
+        hash = hash_value(hash, level->action);
+        hash = hash_value(hash, level->num_syms);
+        if (level->num_syms > 1)
+            hash = fnv1a_32(hash, level->u.syms,
+                            level->num_syms * sizeof(*level->u.syms));
+        else
+            hash = hash_value(hash, level->u.sym);
+    }
+
+    return hash;
+}
+
+static bool
+levels_equal(const struct xkb_level *a, const struct xkb_level *b,
+             unsigned int num_levels)
+{
+    for (unsigned i = 0; i < num_levels; i++) {
+        if (memcmp(&a[i].action, &b[i].action, sizeof(a[i].action)) != 0 ||
+            a[i].num_syms != b[i].num_syms)
+            return false;
+
+        if (a[i].num_syms > 1) {
+            if (memcmp(a[i].u.syms, b[i].u.syms,
+                       a[i].num_syms * sizeof(*a[i].u.syms)) != 0)
+                return false;
+        }
+        else if (a[i].u.sym != b[i].u.sym) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool
+blocks_equal(const struct shared_block *a, const struct shared_block *b)
+{
+    if (a->kind != b->kind || a->hash != b->hash ||
+        a->count != b->count || a->size != b->size)
+        return false;
+
+    switch (a->kind) {
+    case BLOCK_TYPES:
+        return types_equal((const void *) a->data, (const void *) b->data,
+                           a->count);
+    case BLOCK_GROUPS:
+        return groups_equal((const void *) a->data, (const void *) b->data,
+                            a->count);
+    case BLOCK_LEVELS:
+        return levels_equal((const void *) a->data, (const void *) b->data,
+                            a->count);
+    }
+
+    return false;
+}
+
+/* The table of blocks in the context, with chained buckets. */
+
+static bool
+table_grow(struct xkb_context *ctx)
+{
+    unsigned int size = ctx->shared_blocks_size ? 2 * ctx->shared_blocks_size
+                                                : 256;
+    struct shared_block **buckets;
+
+    buckets = calloc(size, sizeof(*buckets));
+    if (!buckets)
+        return false;
+
+    for (unsigned i = 0; i < ctx->shared_blocks_size; i++) {
+        struct shared_block *block = ctx->shared_blocks[i], *next;
+
+        for (; block; block = next) {
+            next = block->next;
+            block->next = buckets[block->hash & (size - 1)];
+            buckets[block->hash & (size - 1)] = block;
+        }
+    }
+
+    free(ctx->shared_blocks);
+    ctx->shared_blocks = buckets;
+    ctx->shared_blocks_size = size;
+    return true;
+}
+
+/*
+ * Intern a new block: returns the data of an equal block already in the
+ * context with a new reference, freeing @block, or else of @block itself.
+ * Returns NULL on failure, freeing @block.
+ */
+static void *
+block_intern(struct xkb_context *ctx, struct shared_block *block)
+{
+    struct shared_block **bucket, *other;
+
+    if (ctx->num_shared_blocks >= ctx->shared_blocks_size) {
+        if (!table_grow(ctx)) {
+            free(block);
+            return NULL;
+        }
+    }
+
+    bucket = &ctx->shared_blocks[block->hash & (ctx->shared_blocks_size - 1)];
+    for (other = *bucket; other; other = other->next) {
+        if (blocks_equal(block, other)) {
+            free(block);
+            other->refcnt++;
+            return other->data;
+        }
+    }
+
+    block->next = *bucket;
+    *bucket = block;
+    ctx->num_shared_blocks++;
+    return block->data;
+}
+
+static void
+block_unref(struct xkb_context *ctx, const void *data)
+{
+    struct shared_block *block, **link;
+
+    if (!data)
+        return;
+
+    block = block_of(data);
+    if (--block->refcnt > 0)
+        return;
+
+    link = &ctx->shared_blocks[block->hash & (ctx->shared_blocks_size - 1)];
+    while (*link != block)
+        link = &(*link)->next;
+    *link = block->next;
+    ctx->num_shared_blocks--;
+
+    free(block);
+}
+
+static struct xkb_key_type *
+intern_types(struct xkb_context *ctx,
+             const struct xkb_key_type *types, unsigned int num_types)
+{
+    struct shared_block *block;
+    struct xkb_key_type *new_types;
+    struct xkb_key_type_entry *entries;
+    xkb_atom_t *level_names;
+    size_t num_entries = 0, num_level_names = 0;
+
+    for (unsigned i = 0; i < num_types; i++) {
+        num_entries += types[i].num_entries;
+        num_level_names += types[i].num_level_names;
+    }
+
+    block = block_new(BLOCK_TYPES, num_types,
+                      num_types * sizeof(*types) +
+                      num_entries * sizeof(*entries) +
+                      num_level_names * sizeof(*level_names));
+    if (!block)
+        return NULL;
+
+    new_types = (struct xkb_key_type *) block->data;
+    entries = (struct xkb_key_type_entry *) (new_types + num_types);
+    level_names = (xkb_atom_t *) (entries + num_entries);
+
+    for (unsigned i = 0; i < num_types; i++) {
+        new_types[i] = types[i];
+
+        new_types[i].entries = NULL;
+        if (types[i].num_entries) {
+            new_types[i].entries = entries;
+            memcpy(entries, types[i].entries,
+                   types[i].num_entries * sizeof(*entries));
+            entries += types[i].num_entries;
+        }
+
+        new_types[i].level_names = NULL;
+        if (types[i].num_level_names) {
+            new_types[i].level_names = level_names;
+            memcpy(level_names, types[i].level_names,
+                   types[i].num_level_names * sizeof(*level_names));
+            level_names += types[i].num_level_names;
+        }
+    }
+
+    block->hash = hash_types(new_types, num_types);
+    return block_intern(ctx, block);
+}
+
+static struct xkb_level *
+intern_levels(struct xkb_context *ctx,
+              const struct xkb_level *levels, unsigned int num_levels)
+{
+    struct shared_block *block;
+    struct xkb_level *new_levels;
+    xkb_keysym_t *syms;
+    size_t num_syms = 0;
+
+    for (unsigned i = 0; i < num_levels; i++)
+        if (levels[i].num_syms > 1)
+            num_syms += levels[i].num_syms;
+
+    block = block_new(BLOCK_LEVELS, num_levels,
+                      num_levels * sizeof(*levels) +
+                      num_syms * sizeof(*syms));
+    if (!block)
+        return NULL;
+
+    new_levels = (struct xkb_level *) block->data;
+    syms = (xkb_keysym_t *) (new_levels + num_levels);
+
+    for (unsigned i = 0; i < num_levels; i++) {
+        new_levels[i] = levels[i];
+
+        if (levels[i].num_syms > 1) {
+            new_levels[i].u.syms = syms;
+            memcpy(syms, levels[i].u.syms,
+                   levels[i].num_syms * sizeof(*syms));
+            syms += levels[i].num_syms;
+        }
+    }
+
+    block->hash = hash_levels(new_levels, num_levels);
+    return block_intern(ctx, block);
+}
+
+static struct xkb_group *
+intern_groups(struct xkb_context *ctx,
+              const struct xkb_group *groups, unsigned int num_groups)
+{
+    struct shared_block *block;
+    struct xkb_group *new_groups;
+
+    block = block_new(BLOCK_GROUPS, num_groups,
+                      num_groups * sizeof(*groups));
+    if (!block)
+        return NULL;
+
+    new_groups = (struct xkb_group *) block->data;
+    for (unsigned i = 0; i < num_groups; i++) {
+        new_groups[i].explicit_type = groups[i].explicit_type;
+        new_groups[i].type = groups[i].type;
+        new_groups[i].levels = groups[i].levels;
+    }
+
+    block->hash = hash_groups(new_groups, num_groups);
+    return block_intern(ctx, block);
+}
+
+/* Drop the references a keymap holds through the groups of a key. */
+static void
+unref_shared_groups(struct xkb_context *ctx, const struct xkb_group *groups,
+                    unsigned int num_groups)
+{
+    if (!groups)
+        return;
+
+    for (unsigned i = 0; i < num_groups; i++)
+        block_unref(ctx, groups[i].levels);
+    block_unref(ctx, groups);
+}
+
+static struct xkb_group *
+share_groups(struct xkb_context *ctx, const struct xkb_key *key,
+             const struct xkb_key_type *old_types,
+             const struct xkb_key_type *types)
+{
+    struct xkb_group *groups, *shared = NULL;
+    xkb_layout_index_t i;
+
+    groups = calloc(key->num_groups, sizeof(*groups));
+    if (!groups)
+        return NULL;
+
+    for (i = 0; i < key->num_groups; i++) {
+        const struct xkb_group *group = &key->groups[i];
+
+        groups[i].explicit_type = group->explicit_type;
+        groups[i].type = &types[group->type - old_types];
+        groups[i].levels = intern_levels(ctx, group->levels,
+                                         group->type->num_levels);
+        if (!groups[i].levels)
+            goto out;
+    }
+
+    shared = intern_groups(ctx, groups, key->num_groups);
+
+out:
+    if (!shared)
+        for (xkb_layout_index_t j = 0; j < i; j++)
+            block_unref(ctx, groups[j].levels);
+    free(groups);
+    return shared;
+}
+
+static void
+free_key_groups(struct xkb_key *key)
+{
+    if (!key->groups)
+        return;
+
+    for (unsigned i = 0; i < key->num_groups; i++) {
+        if (key->groups[i].levels) {
+            for (unsigned j = 0; j < XkbKeyNumLevels(key, i); j++)
+                if (key->groups[i].levels[j].num_syms > 1)
+                    free(key->groups[i].levels[j].u.syms);
+            free(key->groups[i].levels);
+        }
+    }
+    free(key->groups);
+}
+
+static void
+free_types(struct xkb_key_type *types, unsigned int num_types)
+{
+    if (!types)
+        return;
+
+    for (unsigned i = 0; i < num_types; i++) {
+        free(types[i].entries);
+        free(types[i].level_names);
+    }
+    free(types);
+}
+
+/*
+ * Move the types, groups and levels of a complete keymap into shared
+ * blocks. On failure the keymap is left as it was, which is fine too.
+ */
+bool
+xkb_keymap_share_parts(struct xkb_keymap *keymap)
+{
+    struct xkb_context *ctx = keymap->ctx;
+    struct xkb_key_type *types;
+    struct xkb_group **groups;
+    struct xkb_key *key;
+
+    if (keymap->shared_parts || !keymap->keys)
+        return true;
+
+    types = intern_types(ctx, keymap->types, keymap->num_types);
+    if (!types)
+        return false;
+
+    groups = calloc(keymap->max_key_code + 1, sizeof(*groups));
+    if (!groups) {
+        block_unref(ctx, types);
+        return false;
+    }
+
+    xkb_keys_foreach(key, keymap) {
+        if (key->num_groups == 0)
+            continue;
+
+        groups[key->keycode] = share_groups(ctx, key, keymap->types, types);
+        if (!groups[key->keycode])
+            goto err;
+    }
+
+    xkb_keys_foreach(key, keymap) {
+        free_key_groups(key);
+        key->groups = groups[key->keycode];
+    }
+    free_types(keymap->types, keymap->num_types);
+    keymap->types = types;
+    keymap->shared_parts = true;
+
+    free(groups);
+    return true;
+
+err:
+    xkb_keys_foreach(key, keymap)
+        unref_shared_groups(ctx, groups[key->keycode], key->num_groups);
+    free(groups);
+    block_unref(ctx, types);
+    return false;
+}
+
+/* Free the types, groups and levels of a keymap, shared or not. */
+void
+xkb_keymap_free_parts(struct xkb_keymap *keymap)
+{
+    struct xkb_key *key;
+
+    if (keymap->shared_parts) {
+        if (keymap->keys)
+            xkb_keys_foreach(key, keymap)
+                unref_shared_groups(keymap->ctx, key->groups,
+                                    key->num_groups);
+        block_unref(keymap->ctx, keymap->types);
+    }
+    else {
+        if (keymap->keys)
+            xkb_keys_foreach(key, keymap)
+                free_key_groups(key);
+        free_types(keymap->types, keymap->num_types);
+    }
+}
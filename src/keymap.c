@@ -52,6 +52,11 @@
 
 #include "config.h"
 
+#ifdef HAVE_MEMFD_CREATE
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
 #include "keymap.h"
 #include "text.h"
 
@@ -68,30 +73,10 @@ xkb_keymap_unref(struct xkb_keymap *keymap)
     if (!keymap || --keymap->refcnt > 0)
         return;
 
-    if (keymap->keys) {
-        struct xkb_key *key;
-        xkb_keys_foreach(key, keymap) {
-            if (key->groups) {
-                for (unsigned i = 0; i < key->num_groups; i++) {
-                    if (key->groups[i].levels) {
-                        for (unsigned j = 0; j < XkbKeyNumLevels(key, i); j++)
-                            if (key->groups[i].levels[j].num_syms > 1)
-                                free(key->groups[i].levels[j].u.syms);
-                        free(key->groups[i].levels);
-                    }
-                }
-                free(key->groups);
-            }
-        }
-        free(keymap->keys);
-    }
-    if (keymap->types) {
-        for (unsigned i = 0; i < keymap->num_types; i++) {
-            free(keymap->types[i].entries);
-            free(keymap->types[i].level_names);
-        }
-        free(keymap->types);
-    }
+    xkb_keymap_cache_remove(keymap);
+
+    xkb_keymap_free_parts(keymap);
+    free(keymap->keys);
     free(keymap->sym_interprets);
     free(keymap->key_aliases);
     free(keymap->group_names);
@@ -99,6 +84,9 @@ xkb_keymap_unref(struct xkb_keymap *keymap)
     free(keymap->symbols_section_name);
     free(keymap->types_section_name);
     free(keymap->compat_section_name);
+    free(keymap->text);
+    if (keymap->fd >= 0)
+        close(keymap->fd);
     xkb_context_unref(keymap->ctx);
     free(keymap);
 }
@@ -116,6 +104,32 @@ get_keymap_format_ops(enum xkb_keymap_format format)
     return keymap_format_ops[(int) format];
 }
 
+/* "text:<format>:<SHA-256 of the buffer>" */
+#define BUFFER_CACHE_KEY_SIZE (5 + 11 + 1 + 2 * SHA256_DIGEST_SIZE + 1)
+
+/*
+ * The cache key of a keymap compiled from a buffer, so that compiling the
+ * same buffer again needn't even parse it.
+ */
+static void
+get_buffer_cache_key(char key[BUFFER_CACHE_KEY_SIZE],
+                     const char *buffer, size_t length,
+                     enum xkb_keymap_format format)
+{
+    struct sha256 sha;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    int len;
+
+    sha256_init(&sha);
+    sha256_update(&sha, buffer, length);
+    sha256_final(&sha, digest);
+
+    len = snprintf(key, BUFFER_CACHE_KEY_SIZE, "text:%d:", (int) format);
+    for (unsigned i = 0; i < SHA256_DIGEST_SIZE; i++)
+        len += snprintf(key + len, BUFFER_CACHE_KEY_SIZE - len,
+                        "%02x", digest[i]);
+}
+
 XKB_EXPORT struct xkb_keymap *
 xkb_keymap_new_from_names(struct xkb_context *ctx,
                           const struct xkb_rule_names *rmlvo_in,
@@ -132,7 +146,7 @@ xkb_keymap_new_from_names(struct xkb_context *ctx,
         return NULL;
     }
 
-    if (flags & ~(XKB_KEYMAP_COMPILE_NO_FLAGS)) {
+    if (flags & ~(XKB_KEYMAP_COMPILE_USE_CACHE)) {
         log_err_func(ctx, "unrecognized flags: %#x\n", flags);
         return NULL;
     }
@@ -152,6 +166,9 @@ xkb_keymap_new_from_names(struct xkb_context *ctx,
         return NULL;
     }
 
+    if (flags & XKB_KEYMAP_COMPILE_USE_CACHE)
+        keymap = xkb_keymap_cache_dedup(keymap);
+
     return keymap;
 }
 
@@ -173,6 +190,7 @@ xkb_keymap_new_from_buffer(struct xkb_context *ctx,
 {
     struct xkb_keymap *keymap;
     const struct xkb_keymap_format_ops *ops;
+    char cache_key[BUFFER_CACHE_KEY_SIZE];
 
     ops = get_keymap_format_ops(format);
     if (!ops || !ops->keymap_new_from_string) {
@@ -180,7 +198,7 @@ xkb_keymap_new_from_buffer(struct xkb_context *ctx,
         return NULL;
     }
 
-    if (flags & ~(XKB_KEYMAP_COMPILE_NO_FLAGS)) {
+    if (flags & ~(XKB_KEYMAP_COMPILE_USE_CACHE)) {
         log_err_func(ctx, "unrecognized flags: %#x\n", flags);
         return NULL;
     }
@@ -190,6 +208,13 @@ xkb_keymap_new_from_buffer(struct xkb_context *ctx,
         return NULL;
     }
 
+    if (flags & XKB_KEYMAP_COMPILE_USE_CACHE) {
+        get_buffer_cache_key(cache_key, buffer, length, format);
+        keymap = xkb_keymap_cache_lookup(ctx, cache_key);
+        if (keymap)
+            return keymap;
+    }
+
     keymap = xkb_keymap_new(ctx, format, flags);
     if (!keymap)
         return NULL;
@@ -199,6 +224,11 @@ xkb_keymap_new_from_buffer(struct xkb_context *ctx,
         return NULL;
     }
 
+    if (flags & XKB_KEYMAP_COMPILE_USE_CACHE) {
+        keymap = xkb_keymap_cache_dedup(keymap);
+        xkb_keymap_cache_add(keymap, cache_key);
+    }
+
     return keymap;
 }
 
@@ -217,7 +247,7 @@ xkb_keymap_new_from_file(struct xkb_context *ctx,
         return NULL;
     }
 
-    if (flags & ~(XKB_KEYMAP_COMPILE_NO_FLAGS)) {
+    if (flags & ~(XKB_KEYMAP_COMPILE_USE_CACHE)) {
         log_err_func(ctx, "unrecognized flags: %#x\n", flags);
         return NULL;
     }
@@ -236,9 +266,29 @@ xkb_keymap_new_from_file(struct xkb_context *ctx,
         return NULL;
     }
 
+    if (flags & XKB_KEYMAP_COMPILE_USE_CACHE)
+        keymap = xkb_keymap_cache_dedup(keymap);
+
     return keymap;
 }
 
+/*
+ * The serialized keymap, made once and kept on the keymap. There is only
+ * one format, so the memoized text is always in the requested one.
+ */
+static const char *
+get_text(struct xkb_keymap *keymap, const struct xkb_keymap_format_ops *ops)
+{
+    if (!keymap->text) {
+        keymap->text = ops->keymap_get_as_string(keymap);
+        if (!keymap->text)
+            return NULL;
+        keymap->text_size = strlen(keymap->text) + 1;
+    }
+
+    return keymap->text;
+}
+
 XKB_EXPORT char *
 xkb_keymap_get_as_string(struct xkb_keymap *keymap,
                          enum xkb_keymap_format format)
@@ -254,7 +304,126 @@ xkb_keymap_get_as_string(struct xkb_keymap *keymap,
         return NULL;
     }
 
-    return ops->keymap_get_as_string(keymap);
+    if (!get_text(keymap, ops))
+        return NULL;
+
+    return memdup(keymap->text, keymap->text_size, 1);
+}
+
+#ifdef HAVE_MEMFD_CREATE
+/*
+ * Make the sealed file holding the keymap text. The seals make it safe to
+ * hand out to clients, who can neither change nor truncate it under the
+ * other clients (or us).
+ */
+static int
+create_keymap_fd(struct xkb_keymap *keymap)
+{
+    const char *text = keymap->text;
+    size_t remaining = keymap->text_size;
+    int fd;
+
+    fd = memfd_create("xkb-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+        return -1;
+
+    while (remaining > 0) {
+        ssize_t ret = write(fd, text, remaining);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            goto err;
+        }
+        text += ret;
+        remaining -= ret;
+    }
+
+    if (fcntl(fd, F_ADD_SEALS,
+              F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0)
+        goto err;
+
+    return fd;
+
+err:
+    close(fd);
+    return -1;
+}
+#endif
+
+XKB_EXPORT int
+xkb_keymap_get_as_fd(struct xkb_keymap *keymap,
+                     enum xkb_keymap_format format,
+                     size_t *size_out)
+{
+#ifdef HAVE_MEMFD_CREATE
+    const struct xkb_keymap_format_ops *ops;
+    int fd;
+
+    if (format == XKB_KEYMAP_USE_ORIGINAL_FORMAT)
+        format = keymap->format;
+
+    ops = get_keymap_format_ops(format);
+    if (!ops || !ops->keymap_get_as_string) {
+        log_err_func(keymap->ctx, "unsupported keymap format: %d\n", format);
+        return -1;
+    }
+
+    if (keymap->fd < 0) {
+        if (!get_text(keymap, ops))
+            return -1;
+
+        keymap->fd = create_keymap_fd(keymap);
+        if (keymap->fd < 0) {
+            log_err_func(keymap->ctx, "couldn't create keymap file: %s\n",
+                         strerror(errno));
+            return -1;
+        }
+    }
+
+    fd = fcntl(keymap->fd, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) {
+        log_err_func(keymap->ctx, "couldn't duplicate keymap file: %s\n",
+                     strerror(errno));
+        return -1;
+    }
+
+    if (size_out)
+        *size_out = keymap->text_size;
+    return fd;
+#else
+    log_err_func1(keymap->ctx, "sealed files are not supported on this system\n");
+    return -1;
+#endif
+}
+
+XKB_EXPORT const uint8_t *
+xkb_keymap_get_fingerprint(struct xkb_keymap *keymap)
+{
+    const struct xkb_keymap_format_ops *ops;
+    struct sha256 sha;
+
+    STATIC_ASSERT(XKB_KEYMAP_FINGERPRINT_SIZE == SHA256_DIGEST_SIZE,
+                  "fingerprint size doesn't match the hash");
+
+    if (keymap->has_fingerprint)
+        return keymap->fingerprint;
+
+    /*
+     * The text is a canonical form of the compiled keymap: it only depends
+     * on the content, not on how the keymap is laid out in memory or on
+     * the atoms of the context, and is the same whichever way the keymap
+     * was compiled.
+     */
+    ops = get_keymap_format_ops(XKB_KEYMAP_FORMAT_TEXT_V1);
+    if (!get_text(keymap, ops))
+        return NULL;
+
+    sha256_init(&sha);
+    sha256_update(&sha, keymap->text, keymap->text_size);
+    sha256_final(&sha, keymap->fingerprint);
+    keymap->has_fingerprint = true;
+
+    return keymap->fingerprint;
 }
 
 /**
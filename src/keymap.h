@@ -87,6 +87,7 @@
 
 #include "utils.h"
 #include "context.h"
+#include "sha256.h"
 
 /* This limit is artificially enforced, we do not depend on it any where.
  * The reason it's still here is that the rules file format does not
@@ -397,6 +398,23 @@ struct xkb_keymap {
     char *symbols_section_name;
     char *types_section_name;
     char *compat_section_name;
+
+    /* Whether the keymap is in ctx->keymap_cache. */
+    bool cached;
+    /* Whether the types, groups and levels are shared blocks. */
+    bool shared_parts;
+
+    /*
+     * The serialized keymap, made on the first xkb_keymap_get_as_string().
+     * Keymaps are immutable, so it never goes stale.
+     */
+    char *text;
+    size_t text_size;
+    /* A sealed file with the text, made on the first xkb_keymap_get_as_fd(). */
+    int fd;
+    /* The hash of the text, made on the first xkb_keymap_get_fingerprint(). */
+    bool has_fingerprint;
+    uint8_t fingerprint[SHA256_DIGEST_SIZE];
 };
 
 #define xkb_keys_foreach(iter, keymap) \
@@ -454,6 +472,24 @@ xkb_keymap_new(struct xkb_context *ctx,
                enum xkb_keymap_format format,
                enum xkb_keymap_compile_flags flags);
 
+struct xkb_keymap *
+xkb_keymap_cache_lookup(struct xkb_context *ctx, const char *key);
+
+void
+xkb_keymap_cache_add(struct xkb_keymap *keymap, const char *key);
+
+void
+xkb_keymap_cache_remove(struct xkb_keymap *keymap);
+
+struct xkb_keymap *
+xkb_keymap_cache_dedup(struct xkb_keymap *keymap);
+
+bool
+xkb_keymap_share_parts(struct xkb_keymap *keymap);
+
+void
+xkb_keymap_free_parts(struct xkb_keymap *keymap);
+
 struct xkb_key *
 XkbKeyByName(struct xkb_keymap *keymap, xkb_atom_t name, bool use_aliases);
 
@@ -9,6 +9,11 @@
  * keysym2ucs() maps a keysym onto a Unicode value using a binary search,
  * therefore keysymtab[] must remain SORTED by keysym value.
  *
+ * The reverse mapping uses ucstab[], which is the same table sorted by
+ * Unicode value and generated from keysymtab[] by scripts/makeucstable.
+ * Remember to regenerate it (scripts/update-keysyms) when editing
+ * keysymtab[].
+ *
  * The keysym -> UTF-8 conversion will hopefully one day be provided
  * by Xlib via XmbLookupString() and should ideally not have to be
  * done in X applications. But we are not there yet.
@@ -838,6 +843,8 @@ static const struct codepair keysymtab[] = {
     { 0x20ac, 0x20ac }, /*                    EuroSign € EURO SIGN */
 };
 
+#include "ucs_tables.h"
+
 /* binary search with range check */
 static uint32_t
 bin_search(const struct codepair *table, size_t length, xkb_keysym_t keysym)
@@ -863,6 +870,29 @@ bin_search(const struct codepair *table, size_t length, xkb_keysym_t keysym)
     return 0;
 }
 
+/* binary search by Unicode value with range check */
+static xkb_keysym_t
+ucs_bin_search(const struct codepair *table, size_t length, uint32_t ucs)
+{
+    size_t first = 0;
+    size_t last = length;
+
+    if (ucs < table[0].ucs || ucs > table[length].ucs)
+        return XKB_KEY_NoSymbol;
+
+    while (first <= last) {
+        size_t mid = (first + last) / 2;
+        if (table[mid].ucs < ucs)
+            first = mid + 1;
+        else if (table[mid].ucs > ucs)
+            last = mid - 1;
+        else /* found it */
+            return table[mid].keysym;
+    }
+
+    return XKB_KEY_NoSymbol;
+}
+
 XKB_EXPORT uint32_t
 xkb_keysym_to_utf32(xkb_keysym_t keysym)
 {
@@ -900,6 +930,8 @@ xkb_keysym_to_utf32(xkb_keysym_t keysym)
 XKB_EXPORT xkb_keysym_t
 xkb_utf32_to_keysym(uint32_t ucs)
 {
+    xkb_keysym_t keysym;
+
     /* first check for Latin-1 characters (1:1 mapping) */
     if ((ucs >= 0x0020 && ucs <= 0x007e) ||
         (ucs >= 0x00a0 && ucs <= 0x00ff))
@@ -917,15 +949,28 @@ xkb_utf32_to_keysym(uint32_t ucs)
         ucs > 0x10ffff || (ucs & 0xfffe) == 0xfffe)
         return XKB_KEY_NoSymbol;
 
-    /* search main table */
-    for (size_t i = 0; i < ARRAY_SIZE(keysymtab); i++)
-        if (keysymtab[i].ucs == ucs)
-            return keysymtab[i].keysym;
+    /* search reverse table */
+    keysym = ucs_bin_search(ucstab, ARRAY_SIZE(ucstab) - 1, ucs);
+    if (keysym != XKB_KEY_NoSymbol)
+        return keysym;
 
     /* Use direct encoding if everything else fails */
     return ucs | 0x01000000;
 }
 
+XKB_EXPORT void
+xkb_utf32_to_keysyms(const uint32_t *ucs, size_t count, xkb_keysym_t *keysyms)
+{
+    for (size_t i = 0; i < count; i++) {
+        /* Latin-1 is by far the most common case; keep it inline. */
+        if ((ucs[i] >= 0x0020 && ucs[i] <= 0x007e) ||
+            (ucs[i] >= 0x00a0 && ucs[i] <= 0x00ff))
+            keysyms[i] = ucs[i];
+        else
+            keysyms[i] = xkb_utf32_to_keysym(ucs[i]);
+    }
+}
+
 /*
  * Copyright © 2012 Intel Corporation
  *
@@ -966,3 +1011,58 @@ xkb_keysym_to_utf8(xkb_keysym_t keysym, char *buffer, size_t size)
 
     return utf32_to_utf8(codepoint, buffer);
 }
+
+XKB_EXPORT int
+xkb_keysyms_to_utf8(const xkb_keysym_t *keysyms, size_t count,
+                    char *buffer, size_t size, size_t *offsets)
+{
+    size_t offset = 0;
+    /* Number of bytes written; stops growing once the buffer is full. */
+    size_t written = 0;
+    char tmp[7];
+
+    for (size_t i = 0; i < count; i++) {
+        xkb_keysym_t keysym = keysyms[i];
+        size_t len;
+
+        if (offsets)
+            offsets[i] = offset;
+
+        /* Latin-1 keysyms map 1:1 to codepoints; encode them inline. */
+        if (keysym >= 0x0020 && keysym <= 0x007e) {
+            if (written == offset && offset + 1 < size) {
+                buffer[offset] = (char) keysym;
+                written += 1;
+            }
+            offset += 1;
+            continue;
+        }
+        if (keysym >= 0x00a0 && keysym <= 0x00ff) {
+            if (written == offset && offset + 2 < size) {
+                buffer[offset] = (char) (0xc0 | (keysym >> 6));
+                buffer[offset + 1] = (char) (0x80 | (keysym & 0x3f));
+                written += 2;
+            }
+            offset += 2;
+            continue;
+        }
+
+        len = (size_t) xkb_keysym_to_utf8(keysym, tmp, sizeof(tmp));
+        if (len == 0)
+            continue;
+
+        /* Don't count the terminating NUL byte. */
+        len--;
+        /* Make sure not to truncate in the middle of a UTF-8 sequence. */
+        if (written == offset && offset + len < size) {
+            memcpy(buffer + offset, tmp, len);
+            written += len;
+        }
+        offset += len;
+    }
+
+    if (size > 0)
+        buffer[written] = '\0';
+
+    return (int) offset;
+}
@@ -30,6 +30,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 
 #include "xkbcommon/xkbregistry.h"
 #include "utils.h"
@@ -61,6 +62,22 @@ struct rxkb_iso3166_code {
     char *code;
 };
 
+/* An open addressing hash table of items, keyed by their names. */
+struct name_index {
+    void **slots;
+    uint32_t size;
+};
+
+/* A word in the description of a layout, see build_search_index(). */
+struct search_token {
+    /* The word, in rxkb_context::search_words. */
+    const char *word;
+    /* Offset of the word, while rxkb_context::search_words is built. */
+    uint32_t offset;
+    /* Index in rxkb_context::layout_array. */
+    uint32_t layout;
+};
+
 enum context_state {
     CONTEXT_NEW,
     CONTEXT_PARSED,
@@ -72,6 +89,8 @@ struct rxkb_context {
     enum context_state context_state;
 
     bool load_extra_rules_files;
+    bool use_cache;
+    bool validate;
 
     struct list models;         /* list of struct rxkb_models */
     struct list layouts;        /* list of struct rxkb_layouts */
@@ -79,6 +98,15 @@ struct rxkb_context {
 
     darray(char *) includes;
 
+    /* Lookup and search indices, see build_indices(). */
+    struct name_index model_index;
+    struct name_index layout_index;
+    struct name_index option_group_index;
+    struct name_index option_index;
+    struct rxkb_layout **layout_array;
+    uint32_t num_layouts;
+    darray(struct search_token) search_tokens;
+    darray_char search_words;
 
     ATTR_PRINTF(3, 0) void (*log_fn)(struct rxkb_context *ctx,
                                      enum rxkb_log_level level,
@@ -407,12 +435,11 @@ DECLARE_TYPED_GETTER_FOR_TYPE(rxkb_option_group, popularity, enum rxkb_popularit
 DECLARE_FIRST_NEXT_FOR_TYPE(rxkb_option_group, rxkb_context, option_groups);
 
 static void
-rxkb_context_destroy(struct rxkb_context *ctx)
+rxkb_context_free_items(struct rxkb_context *ctx)
 {
     struct rxkb_model *m, *mtmp;
     struct rxkb_layout *l, *ltmp;
     struct rxkb_option_group *og, *ogtmp;
-    char **path;
 
     list_for_each_safe(m, mtmp, &ctx->models, base.link)
         rxkb_model_unref(m);
@@ -425,6 +452,22 @@ rxkb_context_destroy(struct rxkb_context *ctx)
     list_for_each_safe(og, ogtmp, &ctx->option_groups, base.link)
         rxkb_option_group_unref(og);
     assert(list_empty(&ctx->option_groups));
+}
+
+static void
+rxkb_context_destroy(struct rxkb_context *ctx)
+{
+    char **path;
+
+    rxkb_context_free_items(ctx);
+
+    free(ctx->model_index.slots);
+    free(ctx->layout_index.slots);
+    free(ctx->option_group_index.slots);
+    free(ctx->option_index.slots);
+    free(ctx->layout_array);
+    darray_free(ctx->search_tokens);
+    darray_free(ctx->search_words);
 
     darray_foreach(path, ctx->includes)
         free(*path);
@@ -508,6 +551,8 @@ rxkb_context_new(enum rxkb_context_flags flags)
 
     ctx->context_state = CONTEXT_NEW;
     ctx->load_extra_rules_files = flags & RXKB_CONTEXT_LOAD_EXOTIC_RULES;
+    ctx->use_cache = flags & RXKB_CONTEXT_USE_CACHE;
+    ctx->validate = !(flags & RXKB_CONTEXT_NO_VALIDATION);
     ctx->log_fn = default_log_fn;
     ctx->log_level = RXKB_LOG_LEVEL_ERROR;
 
@@ -634,6 +679,919 @@ rxkb_context_include_path_append_default(struct rxkb_context *ctx)
     return ret;
 }
 
+/*
+ * A cache file holds the items of a parsed context:
+ *
+ *      struct cache_header
+ *      key                   (NUL-terminated)
+ *      num_files times:
+ *          struct cache_file
+ *      strings               (char[strings_size])
+ *      words                 (uint32_t[num_words])
+ *
+ * The key identifies the ruleset, the include paths and the flags which
+ * determine the files to parse.  The files are the rules files the
+ * context would parse, in order, whether they exist or not; the cache
+ * is stale once any of them changes.
+ *
+ * Strings are stored once each and referred to by their offset in the
+ * strings section plus one, 0 being NULL.  The words describe the items,
+ * in the order they are listed by the context:
+ *
+ *      model:  name, vendor, description, popularity
+ *      layout: name, brief, description, variant, popularity,
+ *              num_iso639, num_iso3166, iso639 codes, iso3166 codes
+ *      group:  name, description, popularity, allow_multiple, num_options,
+ *              num_options times:
+ *                  name, brief, description, popularity
+ *
+ * Everything is in host byte order.  The header identifies the format,
+ * and a cache file written by a different build is simply ignored.
+ */
+
+/* "RXKB" */
+#define CACHE_MAGIC 0x424b5852
+#define CACHE_FORMAT_VERSION 2
+
+struct cache_header {
+    uint32_t magic;
+    uint32_t format_version;
+    char lib_version[16];
+    uint32_t key_size;
+    uint32_t num_files;
+    uint32_t strings_size;
+    uint32_t num_words;
+    uint32_t num_models;
+    uint32_t num_layouts;
+    uint32_t num_option_groups;
+    uint32_t reserved;
+};
+
+struct cache_file {
+    int64_t mtime_sec;
+    uint32_t mtime_nsec;
+    uint32_t exists;
+    uint64_t size;
+};
+
+struct cache_reader {
+    const char *strings;
+    uint32_t strings_size;
+    uint32_t *words;
+    uint32_t num_words;
+    uint32_t pos;
+};
+
+struct cache_writer {
+    darray(char) strings;
+    darray(uint32_t) words;
+    /* Open addressing hash table of string references, for deduplication. */
+    uint32_t *refs;
+    uint32_t refs_size;
+};
+
+static uint64_t
+hash_key(const char *key)
+{
+    return fnv1a_64(FNV1A_64_INIT, key, strlen(key));
+}
+
+static char *
+get_cache_key(struct rxkb_context *ctx, const char *ruleset)
+{
+    char **path;
+    char *key, *tmp;
+
+    key = asprintf_safe("%s\n%d\n%d", ruleset, ctx->load_extra_rules_files,
+                        ctx->validate);
+    darray_foreach(path, ctx->includes) {
+        if (!key)
+            return NULL;
+        tmp = asprintf_safe("%s\n%s", key, *path);
+        free(key);
+        key = tmp;
+    }
+
+    return key;
+}
+
+static char *
+get_cache_file_path(const char *key)
+{
+    char name[64];
+
+    snprintf(name, sizeof(name), "registry-%016" PRIx64 ".cache",
+             hash_key(key));
+    return get_xdg_cache_file_path(name);
+}
+
+/*
+ * Fills @files with the state of the rules files rxkb_context_parse()
+ * would parse, in the same order.  Returns the number of files, or
+ * -1 if @max is too small.
+ */
+static int
+get_cache_files(struct rxkb_context *ctx, const char *ruleset,
+                struct cache_file *files, int max)
+{
+    char **path;
+    int n = 0;
+
+    darray_foreach_reverse(path, ctx->includes) {
+        for (int extras = 0; extras <= ctx->load_extra_rules_files; extras++) {
+            char rules[PATH_MAX];
+            struct stat st;
+
+            if (n >= max)
+                return -1;
+
+            memset(&files[n], 0, sizeof(files[n]));
+            if (snprintf_safe(rules, sizeof(rules),
+                              extras ? "%s/rules/%s.extras.xml" :
+                                       "%s/rules/%s.xml",
+                              *path, ruleset) &&
+                stat(rules, &st) == 0) {
+                files[n].exists = 1;
+                get_mtime(&st, &files[n].mtime_sec, &files[n].mtime_nsec);
+                files[n].size = st.st_size;
+            }
+            n++;
+        }
+    }
+
+    return n;
+}
+
+static bool
+read_word(struct cache_reader *r, uint32_t *out)
+{
+    if (r->pos >= r->num_words)
+        return false;
+    *out = r->words[r->pos++];
+    return true;
+}
+
+static bool
+read_string(struct cache_reader *r, char **out)
+{
+    uint32_t ref;
+
+    *out = NULL;
+    if (!read_word(r, &ref) || ref > r->strings_size)
+        return false;
+    if (ref == 0)
+        return true;
+    *out = strdup(r->strings + ref - 1);
+    return *out != NULL;
+}
+
+static bool
+read_popularity(struct cache_reader *r, enum rxkb_popularity *out)
+{
+    uint32_t popularity;
+
+    if (!read_word(r, &popularity) ||
+        (popularity != RXKB_POPULARITY_STANDARD &&
+         popularity != RXKB_POPULARITY_EXOTIC))
+        return false;
+    *out = popularity;
+    return true;
+}
+
+static bool
+read_layout(struct rxkb_context *ctx, struct cache_reader *r)
+{
+    struct rxkb_layout *l;
+    uint32_t num_iso639, num_iso3166;
+
+    l = rxkb_layout_create(&ctx->base);
+    if (!l)
+        return false;
+    list_init(&l->iso639s);
+    list_init(&l->iso3166s);
+    list_append(&ctx->layouts, &l->base.link);
+
+    if (!read_string(r, &l->name) || !l->name ||
+        !read_string(r, &l->brief) ||
+        !read_string(r, &l->description) ||
+        !read_string(r, &l->variant) ||
+        !read_popularity(r, &l->popularity) ||
+        !read_word(r, &num_iso639) ||
+        !read_word(r, &num_iso3166))
+        return false;
+
+    for (uint32_t i = 0; i < num_iso639; i++) {
+        struct rxkb_iso639_code *code = rxkb_iso639_code_create(&l->base);
+        if (!code)
+            return false;
+        list_append(&l->iso639s, &code->base.link);
+        if (!read_string(r, &code->code))
+            return false;
+    }
+
+    for (uint32_t i = 0; i < num_iso3166; i++) {
+        struct rxkb_iso3166_code *code = rxkb_iso3166_code_create(&l->base);
+        if (!code)
+            return false;
+        list_append(&l->iso3166s, &code->base.link);
+        if (!read_string(r, &code->code))
+            return false;
+    }
+
+    return true;
+}
+
+static bool
+read_option_group(struct rxkb_context *ctx, struct cache_reader *r)
+{
+    struct rxkb_option_group *g;
+    uint32_t allow_multiple, num_options;
+
+    g = rxkb_option_group_create(&ctx->base);
+    if (!g)
+        return false;
+    list_init(&g->options);
+    list_append(&ctx->option_groups, &g->base.link);
+
+    if (!read_string(r, &g->name) || !g->name ||
+        !read_string(r, &g->description) ||
+        !read_popularity(r, &g->popularity) ||
+        !read_word(r, &allow_multiple) ||
+        !read_word(r, &num_options))
+        return false;
+    g->allow_multiple = allow_multiple;
+
+    for (uint32_t i = 0; i < num_options; i++) {
+        struct rxkb_option *o = rxkb_option_create(&g->base);
+        if (!o)
+            return false;
+        list_append(&g->options, &o->base.link);
+        if (!read_string(r, &o->name) || !o->name ||
+            !read_string(r, &o->brief) ||
+            !read_string(r, &o->description) ||
+            !read_popularity(r, &o->popularity))
+            return false;
+    }
+
+    return true;
+}
+
+static bool
+read_items(struct rxkb_context *ctx, const struct cache_header *header,
+           struct cache_reader *r)
+{
+    for (uint32_t i = 0; i < header->num_models; i++) {
+        struct rxkb_model *m = rxkb_model_create(&ctx->base);
+        if (!m)
+            return false;
+        list_append(&ctx->models, &m->base.link);
+        if (!read_string(r, &m->name) || !m->name ||
+            !read_string(r, &m->vendor) ||
+            !read_string(r, &m->description) ||
+            !read_popularity(r, &m->popularity))
+            return false;
+    }
+
+    for (uint32_t i = 0; i < header->num_layouts; i++)
+        if (!read_layout(ctx, r))
+            return false;
+
+    for (uint32_t i = 0; i < header->num_option_groups; i++)
+        if (!read_option_group(ctx, r))
+            return false;
+
+    return r->pos == r->num_words;
+}
+
+static bool
+load_cache_string(struct rxkb_context *ctx, const char *key,
+                  const struct cache_file *files, int num_files,
+                  const char *string, size_t size)
+{
+    struct cache_header header;
+    struct cache_reader reader;
+    size_t offset;
+
+    if (size < sizeof(header))
+        return false;
+    memcpy(&header, string, sizeof(header));
+    if (header.magic != CACHE_MAGIC ||
+        header.format_version != CACHE_FORMAT_VERSION ||
+        strncmp(header.lib_version, LIBXKBCOMMON_VERSION,
+                sizeof(header.lib_version)) != 0 ||
+        header.key_size != strlen(key) + 1 ||
+        header.num_files != (uint32_t) num_files)
+        return false;
+    offset = sizeof(header);
+
+    if (size - offset < header.key_size ||
+        memcmp(string + offset, key, header.key_size) != 0)
+        return false;
+    offset += header.key_size;
+
+    for (int i = 0; i < num_files; i++) {
+        struct cache_file file;
+
+        if (size - offset < sizeof(file))
+            return false;
+        memcpy(&file, string + offset, sizeof(file));
+        offset += sizeof(file);
+
+        if (file.exists != files[i].exists ||
+            file.mtime_sec != files[i].mtime_sec ||
+            file.mtime_nsec != files[i].mtime_nsec ||
+            file.size != files[i].size)
+            return false;
+    }
+
+    if (size - offset < header.strings_size ||
+        (header.strings_size > 0 &&
+         string[offset + header.strings_size - 1] != '\0'))
+        return false;
+    reader.strings = string + offset;
+    reader.strings_size = header.strings_size;
+    offset += header.strings_size;
+
+    if ((size - offset) / sizeof(uint32_t) != header.num_words)
+        return false;
+    /* The words section need not be aligned. */
+    reader.words = calloc(header.num_words + 1, sizeof(uint32_t));
+    if (!reader.words)
+        return false;
+    memcpy(reader.words, string + offset,
+           header.num_words * sizeof(uint32_t));
+    reader.num_words = header.num_words;
+    reader.pos = 0;
+
+    if (!read_items(ctx, &header, &reader)) {
+        free(reader.words);
+        rxkb_context_free_items(ctx);
+        return false;
+    }
+
+    free(reader.words);
+    return true;
+}
+
+static bool
+load_cache(struct rxkb_context *ctx, const char *ruleset)
+{
+    struct cache_file files[64];
+    int num_files;
+    char *key, *cache_path;
+    char *string;
+    size_t size;
+    FILE *file;
+    bool ok = false;
+
+    num_files = get_cache_files(ctx, ruleset, files, ARRAY_SIZE(files));
+    if (num_files < 0)
+        return false;
+
+    key = get_cache_key(ctx, ruleset);
+    if (!key)
+        return false;
+
+    cache_path = get_cache_file_path(key);
+    if (!cache_path)
+        goto err_key;
+
+    file = fopen(cache_path, "rb");
+    if (!file)
+        goto err_path;
+
+    ok = map_file(file, &string, &size);
+    fclose(file);
+    if (!ok)
+        goto err_path;
+
+    ok = load_cache_string(ctx, key, files, num_files, string, size);
+    unmap_file(string, size);
+    if (ok)
+        log_dbg(ctx, "Loaded ruleset %s from cache file %s\n",
+                ruleset, cache_path);
+    else
+        log_dbg(ctx, "Ignoring stale or invalid cache file %s\n", cache_path);
+
+err_path:
+    free(cache_path);
+err_key:
+    free(key);
+    return ok;
+}
+
+static void
+write_word(struct cache_writer *w, uint32_t word)
+{
+    darray_append(w->words, word);
+}
+
+static void
+write_string(struct cache_writer *w, const char *str)
+{
+    uint32_t i, ref;
+
+    if (!str) {
+        write_word(w, 0);
+        return;
+    }
+
+    /* The table is sized for the worst case, so it never fills up. */
+    for (i = hash_key(str) & (w->refs_size - 1); w->refs[i] != 0;
+         i = (i + 1) & (w->refs_size - 1)) {
+        if (streq(&darray_item(w->strings, w->refs[i] - 1), str)) {
+            write_word(w, w->refs[i]);
+            return;
+        }
+    }
+
+    ref = darray_size(w->strings) + 1;
+    darray_append_string(w->strings, str);
+    darray_append(w->strings, '\0');
+    w->refs[i] = ref;
+    write_word(w, ref);
+}
+
+/* Returns an upper bound of the number of strings of the items. */
+static uint32_t
+count_strings(struct rxkb_context *ctx)
+{
+    struct rxkb_model *m;
+    struct rxkb_layout *l;
+    struct rxkb_option_group *g;
+    uint32_t count = 0;
+
+    list_for_each(m, &ctx->models, base.link)
+        count += 3;
+    list_for_each(l, &ctx->layouts, base.link)
+        count += 4 + list_length(&l->iso639s) + list_length(&l->iso3166s);
+    list_for_each(g, &ctx->option_groups, base.link)
+        count += 2 + 3 * list_length(&g->options);
+
+    return count;
+}
+
+static void
+write_items(struct rxkb_context *ctx, struct cache_writer *w,
+            struct cache_header *header)
+{
+    struct rxkb_model *m;
+    struct rxkb_layout *l;
+    struct rxkb_option_group *g;
+
+    list_for_each(m, &ctx->models, base.link) {
+        write_string(w, m->name);
+        write_string(w, m->vendor);
+        write_string(w, m->description);
+        write_word(w, m->popularity);
+        header->num_models++;
+    }
+
+    list_for_each(l, &ctx->layouts, base.link) {
+        struct rxkb_iso639_code *iso639;
+        struct rxkb_iso3166_code *iso3166;
+
+        write_string(w, l->name);
+        write_string(w, l->brief);
+        write_string(w, l->description);
+        write_string(w, l->variant);
+        write_word(w, l->popularity);
+        write_word(w, list_length(&l->iso639s));
+        write_word(w, list_length(&l->iso3166s));
+        list_for_each(iso639, &l->iso639s, base.link)
+            write_string(w, iso639->code);
+        list_for_each(iso3166, &l->iso3166s, base.link)
+            write_string(w, iso3166->code);
+        header->num_layouts++;
+    }
+
+    list_for_each(g, &ctx->option_groups, base.link) {
+        struct rxkb_option *o;
+
+        write_string(w, g->name);
+        write_string(w, g->description);
+        write_word(w, g->popularity);
+        write_word(w, g->allow_multiple);
+        write_word(w, list_length(&g->options));
+        list_for_each(o, &g->options, base.link) {
+            write_string(w, o->name);
+            write_string(w, o->brief);
+            write_string(w, o->description);
+            write_word(w, o->popularity);
+        }
+        header->num_option_groups++;
+    }
+}
+
+static void
+save_cache(struct rxkb_context *ctx, const char *ruleset)
+{
+    struct cache_file files[64];
+    struct cache_header header;
+    struct cache_writer writer;
+    int num_files;
+    char *key, *cache_path, *tmp_path;
+    FILE *file;
+    int fd;
+    bool ok;
+
+    num_files = get_cache_files(ctx, ruleset, files, ARRAY_SIZE(files));
+    if (num_files < 0)
+        return;
+
+    key = get_cache_key(ctx, ruleset);
+    if (!key)
+        return;
+
+    cache_path = get_cache_file_path(key);
+    if (!cache_path)
+        goto err_key;
+
+    tmp_path = asprintf_safe("%s.XXXXXX", cache_path);
+    if (!tmp_path)
+        goto err_path;
+
+    if (!make_parent_dirs(tmp_path))
+        goto err_tmp;
+
+    memset(&header, 0, sizeof(header));
+    darray_init(writer.strings);
+    darray_init(writer.words);
+    writer.refs_size = 1u << msb_pos(2 * count_strings(ctx));
+    writer.refs = calloc(writer.refs_size, sizeof(*writer.refs));
+    if (!writer.refs)
+        goto err_writer;
+    write_items(ctx, &writer, &header);
+
+    header.magic = CACHE_MAGIC;
+    header.format_version = CACHE_FORMAT_VERSION;
+    strncpy(header.lib_version, LIBXKBCOMMON_VERSION,
+            sizeof(header.lib_version));
+    header.key_size = strlen(key) + 1;
+    header.num_files = num_files;
+    header.strings_size = darray_size(writer.strings);
+    header.num_words = darray_size(writer.words);
+
+    /* Write to a temporary file, so readers never see a partial file. */
+    fd = mkstemp(tmp_path);
+    if (fd < 0)
+        goto err_writer;
+
+    file = fdopen(fd, "wb");
+    if (!file) {
+        close(fd);
+        unlink(tmp_path);
+        goto err_writer;
+    }
+
+    ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+         fwrite(key, header.key_size, 1, file) == 1 &&
+         fwrite(files, sizeof(*files), num_files, file) == (size_t) num_files &&
+         fwrite(writer.strings.item, 1, header.strings_size, file) ==
+            header.strings_size &&
+         fwrite(writer.words.item, sizeof(uint32_t), header.num_words, file) ==
+            header.num_words;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmp_path, cache_path) != 0) {
+        log_dbg(ctx, "Failed to write cache file %s\n", cache_path);
+        unlink(tmp_path);
+        goto err_writer;
+    }
+
+    log_dbg(ctx, "Saved ruleset %s to cache file %s\n", ruleset, cache_path);
+
+err_writer:
+    free(writer.refs);
+    darray_free(writer.strings);
+    darray_free(writer.words);
+err_tmp:
+    free(tmp_path);
+err_path:
+    free(cache_path);
+err_key:
+    free(key);
+}
+
+/*
+ * Once a context is parsed, its items are never modified, so the indices
+ * are built once, after parsing.  The name indices map names to the first
+ * item with that name, which is the one a linear search would find.
+ */
+
+typedef bool (*item_matches_t)(const void *item, const char *name,
+                               const char *variant);
+
+static bool
+model_matches(const void *item, const char *name, const char *variant)
+{
+    return streq(((const struct rxkb_model *) item)->name, name);
+}
+
+static bool
+layout_matches(const void *item, const char *name, const char *variant)
+{
+    const struct rxkb_layout *l = item;
+    return streq(l->name, name) && streq_null(l->variant, variant);
+}
+
+static bool
+option_group_matches(const void *item, const char *name, const char *variant)
+{
+    return streq(((const struct rxkb_option_group *) item)->name, name);
+}
+
+static bool
+option_matches(const void *item, const char *name, const char *variant)
+{
+    return streq(((const struct rxkb_option *) item)->name, name);
+}
+
+static uint64_t
+hash_name(const char *name, const char *variant)
+{
+    uint64_t hash = hash_key(name);
+
+    /* Separate the name from the variant, and NULL from "". */
+    if (variant)
+        hash = fnv1a_64(fnv1a_64(hash, "\x01", 1), variant, strlen(variant));
+    return hash;
+}
+
+/* Returns the slot of the item with the given name, or an empty slot. */
+static void **
+name_index_find(const struct name_index *index, item_matches_t matches,
+                const char *name, const char *variant)
+{
+    uint32_t mask = index->size - 1;
+
+    if (index->size == 0)
+        return NULL;
+
+    for (uint32_t i = hash_name(name, variant) & mask; ;
+         i = (i + 1) & mask) {
+        void **slot = &index->slots[i];
+        if (!*slot || matches(*slot, name, variant))
+            return slot;
+    }
+}
+
+static bool
+name_index_init(struct name_index *index, uint32_t count)
+{
+    /* At most half full. */
+    index->size = 1u << msb_pos(2 * count);
+    index->slots = calloc(index->size, sizeof(*index->slots));
+    return index->slots != NULL;
+}
+
+static void
+name_index_add(struct name_index *index, item_matches_t matches,
+               void *item, const char *name, const char *variant)
+{
+    void **slot = name_index_find(index, matches, name, variant);
+
+    if (!*slot)
+        *slot = item;
+}
+
+/*
+ * Adds the words of @str to the search index, for the layout @layout.
+ * Words are runs of ASCII letters and digits, and of non-ASCII bytes,
+ * lowercased.
+ */
+static void
+add_search_words(struct rxkb_context *ctx, uint32_t layout, const char *str)
+{
+    if (!str)
+        return;
+
+    while (*str) {
+        struct search_token token;
+
+        while (*str && !is_alnum(*str) && (unsigned char) *str < 0x80)
+            str++;
+        if (!*str)
+            break;
+
+        token.word = NULL;
+        token.offset = darray_size(ctx->search_words);
+        token.layout = layout;
+        for (; is_alnum(*str) || (unsigned char) *str >= 0x80; str++)
+            darray_append(ctx->search_words, to_lower(*str));
+        darray_append(ctx->search_words, '\0');
+        darray_append(ctx->search_tokens, token);
+    }
+}
+
+static int
+cmp_search_tokens(const void *a, const void *b)
+{
+    const struct search_token *ta = a, *tb = b;
+    int ret = strcmp(ta->word, tb->word);
+
+    if (ret != 0)
+        return ret;
+    return ta->layout < tb->layout ? -1 : ta->layout > tb->layout;
+}
+
+static void
+build_search_index(struct rxkb_context *ctx)
+{
+    struct search_token *token;
+
+    for (uint32_t i = 0; i < ctx->num_layouts; i++) {
+        struct rxkb_layout *l = ctx->layout_array[i];
+        struct rxkb_iso639_code *iso639;
+        struct rxkb_iso3166_code *iso3166;
+
+        add_search_words(ctx, i, l->name);
+        add_search_words(ctx, i, l->variant);
+        add_search_words(ctx, i, l->brief);
+        add_search_words(ctx, i, l->description);
+        list_for_each(iso639, &l->iso639s, base.link)
+            add_search_words(ctx, i, iso639->code);
+        list_for_each(iso3166, &l->iso3166s, base.link)
+            add_search_words(ctx, i, iso3166->code);
+    }
+
+    darray_foreach(token, ctx->search_tokens)
+        token->word = &darray_item(ctx->search_words, token->offset);
+
+    /* Sorted by word, for prefix searches. The array is NULL if empty. */
+    if (!darray_empty(ctx->search_tokens))
+        qsort(ctx->search_tokens.item, darray_size(ctx->search_tokens),
+              sizeof(struct search_token), cmp_search_tokens);
+}
+
+static bool
+build_indices(struct rxkb_context *ctx)
+{
+    struct rxkb_model *m;
+    struct rxkb_layout *l;
+    struct rxkb_option_group *g;
+    struct rxkb_option *o;
+    uint32_t num_options = 0;
+
+    list_for_each(g, &ctx->option_groups, base.link)
+        num_options += list_length(&g->options);
+    ctx->num_layouts = list_length(&ctx->layouts);
+
+    ctx->layout_array = calloc(ctx->num_layouts + 1,
+                               sizeof(*ctx->layout_array));
+    if (!ctx->layout_array ||
+        !name_index_init(&ctx->model_index, list_length(&ctx->models)) ||
+        !name_index_init(&ctx->layout_index, ctx->num_layouts) ||
+        !name_index_init(&ctx->option_group_index,
+                         list_length(&ctx->option_groups)) ||
+        !name_index_init(&ctx->option_index, num_options))
+        return false;
+
+    list_for_each(m, &ctx->models, base.link)
+        name_index_add(&ctx->model_index, model_matches, m, m->name, NULL);
+
+    ctx->num_layouts = 0;
+    list_for_each(l, &ctx->layouts, base.link) {
+        name_index_add(&ctx->layout_index, layout_matches, l,
+                       l->name, l->variant);
+        ctx->layout_array[ctx->num_layouts++] = l;
+    }
+
+    list_for_each(g, &ctx->option_groups, base.link) {
+        name_index_add(&ctx->option_group_index, option_group_matches, g,
+                       g->name, NULL);
+        list_for_each(o, &g->options, base.link)
+            name_index_add(&ctx->option_index, option_matches, o,
+                           o->name, NULL);
+    }
+
+    build_search_index(ctx);
+    return true;
+}
+
+static void *
+find_item(struct rxkb_context *ctx, const struct name_index *index,
+          item_matches_t matches, const char *name, const char *variant)
+{
+    void **slot;
+
+    if (ctx->context_state != CONTEXT_PARSED || !name)
+        return NULL;
+
+    slot = name_index_find(index, matches, name, variant);
+    return slot ? *slot : NULL;
+}
+
+XKB_EXPORT struct rxkb_model *
+rxkb_model_find(struct rxkb_context *ctx, const char *name)
+{
+    return find_item(ctx, &ctx->model_index, model_matches, name, NULL);
+}
+
+XKB_EXPORT struct rxkb_layout *
+rxkb_layout_find(struct rxkb_context *ctx, const char *name,
+                 const char *variant)
+{
+    return find_item(ctx, &ctx->layout_index, layout_matches, name, variant);
+}
+
+XKB_EXPORT struct rxkb_option_group *
+rxkb_option_group_find(struct rxkb_context *ctx, const char *name)
+{
+    return find_item(ctx, &ctx->option_group_index, option_group_matches,
+                     name, NULL);
+}
+
+XKB_EXPORT struct rxkb_option *
+rxkb_option_find(struct rxkb_context *ctx, const char *name)
+{
+    return find_item(ctx, &ctx->option_index, option_matches, name, NULL);
+}
+
+/* Returns the index of the first token whose word is not less than @word. */
+static size_t
+search_lower_bound(struct rxkb_context *ctx, const char *word)
+{
+    size_t lo = 0, hi = darray_size(ctx->search_tokens);
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const struct search_token *token =
+            &darray_item(ctx->search_tokens, mid);
+
+        if (strcmp(token->word, word) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+XKB_EXPORT size_t
+rxkb_layout_search(struct rxkb_context *ctx, const char *query,
+                   struct rxkb_layout **layouts, size_t max_layouts)
+{
+    darray_char words = darray_new();
+    uint32_t *matched;
+    uint32_t num_words = 0;
+    size_t count = 0;
+    const char *word;
+
+    if (ctx->context_state != CONTEXT_PARSED)
+        return 0;
+
+    matched = calloc(ctx->num_layouts + 1, sizeof(*matched));
+    if (!matched)
+        return 0;
+
+    /* Split the query into words, the same way as the descriptions. */
+    for (const char *q = query; *q; ) {
+        while (*q && !is_alnum(*q) && (unsigned char) *q < 0x80)
+            q++;
+        if (!*q)
+            break;
+        for (; is_alnum(*q) || (unsigned char) *q >= 0x80; q++)
+            darray_append(words, to_lower(*q));
+        darray_append(words, '\0');
+        num_words++;
+    }
+
+    /*
+     * A layout matches if each word of the query is a prefix of one of
+     * its words.  matched[i] is the number of query words matched so far
+     * by layout i.
+     */
+    word = words.item;
+    for (uint32_t n = 0; n < num_words; n++) {
+        size_t len = strlen(word);
+
+        for (size_t i = search_lower_bound(ctx, word);
+             i < darray_size(ctx->search_tokens); i++) {
+            const struct search_token *token =
+                &darray_item(ctx->search_tokens, i);
+
+            if (strncmp(token->word, word, len) != 0)
+                break;
+            if (matched[token->layout] == n)
+                matched[token->layout] = n + 1;
+        }
+
+        word += len + 1;
+    }
+
+    for (uint32_t i = 0; i < ctx->num_layouts; i++) {
+        if (matched[i] == num_words) {
+            if (count < max_layouts)
+                layouts[count] = ctx->layout_array[i];
+            count++;
+        }
+    }
+
+    free(matched);
+    darray_free(words);
+    return count;
+}
+
 XKB_EXPORT bool
 rxkb_context_parse_default_ruleset(struct rxkb_context *ctx)
 {
@@ -651,6 +1609,11 @@ rxkb_context_parse(struct rxkb_context *ctx, const char *ruleset)
         return false;
     }
 
+    if (ctx->use_cache && load_cache(ctx, ruleset)) {
+        success = true;
+        goto out;
+    }
+
     darray_foreach_reverse(path, ctx->includes) {
         char rules[PATH_MAX];
 
@@ -670,6 +1633,13 @@ rxkb_context_parse(struct rxkb_context *ctx, const char *ruleset)
         }
     }
 
+    if (success && ctx->use_cache)
+        save_cache(ctx, ruleset);
+
+out:
+    if (success && !build_indices(ctx))
+        success = false;
+
     ctx->context_state = success ? CONTEXT_PARSED : CONTEXT_FAILED;
 
     return success;
@@ -688,226 +1658,393 @@ rxkb_context_get_user_data(struct rxkb_context *ctx)
     return ctx->userdata;
 }
 
+/*
+ * The rules XML files are parsed with the libxml2 streaming reader,
+ * straight into the context's items, without building a document tree.
+ *
+ * Unless RXKB_CONTEXT_NO_VALIDATION is set, the document is instead read
+ * into a tree and validated against the DTD first, and the reader walks
+ * the tree.  Either way, the reader skips elements it does not know, as
+ * well as anything in an item before its configItem.  A document which
+ * turns out not to be well-formed is rejected as a whole: the items
+ * already added from it are removed.
+ */
+
+struct xml_parser {
+    struct rxkb_context *ctx;
+    xmlTextReaderPtr reader;
+    enum rxkb_popularity popularity;
+};
+
+typedef darray(char *) darray_string;
+
+struct config_item {
+    char *name;
+    char *description;
+    char *brief;
+    char *vendor;
+    darray_string iso639s;
+    darray_string iso3166s;
+};
+
 static inline bool
-is_node(xmlNode *node, const char *name)
+is_node(xmlTextReaderPtr reader, const char *name)
 {
-    return node->type == XML_ELEMENT_NODE &&
-        xmlStrEqual(node->name, (const xmlChar*)name);
+    return xmlStrEqual(xmlTextReaderConstName(reader), (const xmlChar *) name);
 }
 
-/* return a copy of the text content from the first text node of this node */
-static char *
-extract_text(xmlNode *node)
+/* Works for the tree walker too, unlike xmlTextReaderGetParserLineNumber(). */
+static long
+get_line(struct xml_parser *p)
+{
+    xmlNodePtr node = xmlTextReaderCurrentNode(p->reader);
+
+    return node ? xmlGetLineNo(node) : -1;
+}
+
+/*
+ * Skips the current element, up to its end.  Returns false on error.
+ */
+static bool
+skip_element(struct xml_parser *p)
 {
-    xmlNode *n;
+    int depth = xmlTextReaderDepth(p->reader);
+    int ret;
 
-    for (n = node->children; n; n = n->next) {
-        if (n->type == XML_TEXT_NODE)
-            return (char *)xmlStrdup(n->content);
+    if (xmlTextReaderIsEmptyElement(p->reader))
+        return true;
+
+    while ((ret = xmlTextReaderRead(p->reader)) == 1) {
+        if (xmlTextReaderNodeType(p->reader) == XML_READER_TYPE_END_ELEMENT &&
+            xmlTextReaderDepth(p->reader) == depth)
+            return true;
     }
-    return NULL;
+
+    return false;
+}
+
+/*
+ * Advances to the next child element of the current element, skipping
+ * anything else.  Returns 1 if there is one, 0 at the end of the current
+ * element, and -1 on error.  Must not be called for an empty element,
+ * e.g. <foo/>.
+ */
+static int
+next_child(struct xml_parser *p)
+{
+    int ret;
+
+    while ((ret = xmlTextReaderRead(p->reader)) == 1) {
+        switch (xmlTextReaderNodeType(p->reader)) {
+        case XML_READER_TYPE_ELEMENT:
+            return 1;
+        case XML_READER_TYPE_END_ELEMENT:
+            return 0;
+        default:
+            continue;
+        }
+    }
+
+    return -1;
 }
 
+/* Skips the remaining children of the current element. */
 static bool
-parse_config_item(struct rxkb_context *ctx,
-                  xmlNode *parent,
-                  char **name,
-                  char **description,
-                  char **brief,
-                  char **vendor)
-{
-    xmlNode *node = NULL;
-    xmlNode *ci = NULL;
-
-    for (ci = parent->children; ci; ci = ci->next) {
-        if (is_node(ci, "configItem")) {
-            *name = NULL;
-            *description = NULL;
-            *brief = NULL;
-            *vendor = NULL;
-
-            for (node = ci->children; node; node = node->next) {
-                if (is_node(node, "name"))
-                    *name = extract_text(node);
-                else if (is_node(node, "description"))
-                    *description = extract_text(node);
-                else if (is_node(node, "shortDescription"))
-                    *brief = extract_text(node);
-                else if (is_node(node, "vendor"))
-                    *vendor = extract_text(node);
-                /* Note: the DTD allows for vendor + brief but models only use
-                 * vendor and everything else only uses shortDescription */
-            }
+skip_children(struct xml_parser *p)
+{
+    int ret;
 
-            if (!*name || !strlen(*name))  {
-                log_err(ctx, "xml:%d: missing required element 'name'\n",
-                        ci->line);
-                return false;
-            }
+    while ((ret = next_child(p)) == 1) {
+        if (!skip_element(p))
+            return false;
+    }
+
+    return ret == 0;
+}
 
-            return true; /* only one configItem allowed in the dtd */
+/*
+ * Replaces @text with a copy of the first text of the current element,
+ * or NULL.
+ */
+static bool
+read_text(struct xml_parser *p, char **text)
+{
+    int ret;
+
+    free(*text);
+    *text = NULL;
+    if (xmlTextReaderIsEmptyElement(p->reader))
+        return true;
+
+    while ((ret = xmlTextReaderRead(p->reader)) == 1) {
+        switch (xmlTextReaderNodeType(p->reader)) {
+        case XML_READER_TYPE_END_ELEMENT:
+            return true;
+        case XML_READER_TYPE_ELEMENT:
+            if (!skip_element(p))
+                return false;
+            continue;
+        case XML_READER_TYPE_TEXT:
+        case XML_READER_TYPE_WHITESPACE:
+        case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+            if (!*text)
+                *text = strdup((const char *)
+                               xmlTextReaderConstValue(p->reader));
+            continue;
+        default:
+            continue;
         }
     }
 
     return false;
 }
 
-static void
-parse_model(struct rxkb_context *ctx, xmlNode *model,
-            enum rxkb_popularity popularity)
+/* Appends the texts of the @child elements of the current element. */
+static bool
+read_code_list(struct xml_parser *p, const char *child, darray_string *codes)
 {
-    char *name, *description, *brief, *vendor;
+    int ret;
 
-    if (parse_config_item(ctx, model, &name, &description, &brief, &vendor)) {
-        struct rxkb_model *m;
+    if (xmlTextReaderIsEmptyElement(p->reader))
+        return true;
 
-        list_for_each(m, &ctx->models, base.link) {
-            if (streq(m->name, name)) {
-                free(name);
-                free(description);
-                free(brief);
-                free(vendor);
-                return;
-            }
-        }
+    while ((ret = next_child(p)) == 1) {
+        char *code = NULL;
 
-        /* new model */
-        m = rxkb_model_create(&ctx->base);
-        m->name = name;
-        m->description = description;
-        m->vendor = vendor;
-        m->popularity = popularity;
-        list_append(&ctx->models, &m->base.link);
+        if (!is_node(p->reader, child)) {
+            if (!skip_element(p))
+                return false;
+            continue;
+        }
+        if (!read_text(p, &code))
+            return false;
+        darray_append(*codes, code);
     }
+
+    return ret == 0;
 }
 
 static void
-parse_model_list(struct rxkb_context *ctx, xmlNode *model_list,
-                enum rxkb_popularity popularity)
+config_item_free(struct config_item *item)
 {
-    xmlNode *node = NULL;
+    char **code;
+
+    free(item->name);
+    free(item->description);
+    free(item->brief);
+    free(item->vendor);
+    darray_foreach(code, item->iso639s)
+        free(*code);
+    darray_free(item->iso639s);
+    darray_foreach(code, item->iso3166s)
+        free(*code);
+    darray_free(item->iso3166s);
+}
 
-    for (node = model_list->children; node; node = node->next) {
-        if (is_node(node, "model"))
-            parse_model(ctx, node, popularity);
+static bool
+read_config_item(struct xml_parser *p, struct config_item *item)
+{
+    int ret;
+
+    if (xmlTextReaderIsEmptyElement(p->reader))
+        return true;
+
+    while ((ret = next_child(p)) == 1) {
+        bool ok;
+
+        if (is_node(p->reader, "name"))
+            ok = read_text(p, &item->name);
+        else if (is_node(p->reader, "description"))
+            ok = read_text(p, &item->description);
+        else if (is_node(p->reader, "shortDescription"))
+            ok = read_text(p, &item->brief);
+        else if (is_node(p->reader, "vendor"))
+            ok = read_text(p, &item->vendor);
+        else if (is_node(p->reader, "countryList"))
+            ok = read_code_list(p, "iso3166Id", &item->iso3166s);
+        else if (is_node(p->reader, "languageList"))
+            ok = read_code_list(p, "iso639Id", &item->iso639s);
+        else
+            ok = skip_element(p);
+        if (!ok)
+            return false;
     }
+
+    return ret == 0;
 }
 
-static void
-parse_language_list(xmlNode *language_list, struct rxkb_layout *layout)
+/*
+ * Reads the first configItem child of the current element.  Returns 1 if
+ * the item is usable, 0 if the item, and with it the whole element, is to
+ * be skipped, and -1 on error.  The rest of the element is only left to
+ * the caller if 1 is returned.
+ */
+static int
+read_first_config_item(struct xml_parser *p, struct config_item *item)
 {
-    xmlNode *node = NULL;
-    struct rxkb_iso639_code *code;
+    long line;
+    int ret;
 
-    for (node = language_list->children; node; node = node->next) {
-        if (is_node(node, "iso639Id")) {
-            char *str = extract_text(node);
-            struct rxkb_object *parent;
+    memset(item, 0, sizeof(*item));
+    darray_init(item->iso639s);
+    darray_init(item->iso3166s);
 
-            parent = &layout->base;
-            code = rxkb_iso639_code_create(parent);
-            code->code = str;
-            list_append(&layout->iso639s, &code->base.link);
-        }
+    if (xmlTextReaderIsEmptyElement(p->reader))
+        return 0;
+
+    while ((ret = next_child(p)) == 1 &&
+           !is_node(p->reader, "configItem")) {
+        if (!skip_element(p))
+            return -1;
     }
+    if (ret != 1)
+        return ret;
+
+    line = get_line(p);
+    if (!read_config_item(p, item)) {
+        config_item_free(item);
+        return -1;
+    }
+
+    if (!item->name || !strlen(item->name)) {
+        log_err(p->ctx, "xml:%ld: missing required element 'name'\n", line);
+        config_item_free(item);
+        return skip_children(p) ? 0 : -1;
+    }
+
+    return 1;
 }
 
 static void
-parse_country_list(xmlNode *country_list, struct rxkb_layout *layout)
+add_codes(struct rxkb_layout *l, struct config_item *item)
 {
-    xmlNode *node = NULL;
-    struct rxkb_iso3166_code *code;
+    char **str;
 
-    for (node = country_list->children; node; node = node->next) {
-        if (is_node(node, "iso3166Id")) {
-            char *str = extract_text(node);
-            struct rxkb_object *parent;
+    darray_foreach(str, item->iso639s) {
+        struct rxkb_iso639_code *code = rxkb_iso639_code_create(&l->base);
+        code->code = *str;
+        list_append(&l->iso639s, &code->base.link);
+    }
+    darray_free(item->iso639s);
 
-            parent = &layout->base;
-            code = rxkb_iso3166_code_create(parent);
-            code->code = str;
-            list_append(&layout->iso3166s, &code->base.link);
-        }
+    darray_foreach(str, item->iso3166s) {
+        struct rxkb_iso3166_code *code = rxkb_iso3166_code_create(&l->base);
+        code->code = *str;
+        list_append(&l->iso3166s, &code->base.link);
     }
+    darray_free(item->iso3166s);
 }
 
-static void
-parse_variant(struct rxkb_context *ctx, struct rxkb_layout *l,
-              xmlNode *variant, enum rxkb_popularity popularity)
+static bool
+parse_model(struct xml_parser *p)
 {
-    xmlNode *ci;
-    char *name, *description, *brief, *vendor;
+    struct rxkb_context *ctx = p->ctx;
+    struct config_item item;
+    struct rxkb_model *m;
+    bool exists = false;
+    int ret;
 
-    if (parse_config_item(ctx, variant, &name, &description, &brief, &vendor)) {
-        struct rxkb_layout *v;
-        bool exists = false;
+    ret = read_first_config_item(p, &item);
+    if (ret <= 0)
+        return ret == 0;
 
-        list_for_each(v, &ctx->layouts, base.link) {
-            if (streq(v->name, name) && streq(v->name, l->name)) {
-                exists = true;
-                break;
-            }
+    list_for_each(m, &ctx->models, base.link) {
+        if (streq(m->name, item.name)) {
+            exists = true;
+            break;
         }
+    }
 
-        if (!exists) {
-            v = rxkb_layout_create(&ctx->base);
-            list_init(&v->iso639s);
-            list_init(&v->iso3166s);
-            v->name = strdup(l->name);
-            v->variant = name;
-            v->description = description;
-            v->brief = brief;
-            v->popularity = popularity;
-            list_append(&ctx->layouts, &v->base.link);
-
-            for (ci = variant->children; ci; ci = ci->next) {
-                xmlNode *node;
-
-                if (!is_node(ci, "configItem"))
-                    continue;
-
-                for (node = ci->children; node; node = node->next) {
-                    if (is_node(node, "languageList"))
-                        parse_language_list(node, v);
-                    if (is_node(node, "countryList"))
-                        parse_country_list(node, v);
-                }
-            }
-        } else {
-            free(name);
-            free(description);
-            free(brief);
-            free(vendor);
+    if (!exists) {
+        /* new model */
+        m = rxkb_model_create(&ctx->base);
+        m->name = item.name;
+        m->description = item.description;
+        m->vendor = item.vendor;
+        m->popularity = p->popularity;
+        list_append(&ctx->models, &m->base.link);
+        item.name = item.description = item.vendor = NULL;
+    }
+    config_item_free(&item);
+
+    return skip_children(p);
+}
+
+static bool
+parse_variant(struct xml_parser *p, struct rxkb_layout *l)
+{
+    struct rxkb_context *ctx = p->ctx;
+    struct config_item item;
+    struct rxkb_layout *v;
+    bool exists = false;
+    int ret;
+
+    ret = read_first_config_item(p, &item);
+    if (ret <= 0)
+        return ret == 0;
+
+    list_for_each(v, &ctx->layouts, base.link) {
+        if (streq(v->name, item.name) && streq(v->name, l->name)) {
+            exists = true;
+            break;
         }
     }
+
+    if (!exists) {
+        v = rxkb_layout_create(&ctx->base);
+        list_init(&v->iso639s);
+        list_init(&v->iso3166s);
+        v->name = strdup(l->name);
+        v->variant = item.name;
+        v->description = item.description;
+        v->brief = item.brief;
+        v->popularity = p->popularity;
+        list_append(&ctx->layouts, &v->base.link);
+        add_codes(v, &item);
+        item.name = item.description = item.brief = NULL;
+    }
+    config_item_free(&item);
+
+    return skip_children(p);
 }
 
-static void
-parse_variant_list(struct rxkb_context *ctx, struct rxkb_layout *l,
-                   xmlNode *variant_list, enum rxkb_popularity popularity)
+static bool
+parse_variant_list(struct xml_parser *p, struct rxkb_layout *l)
 {
-    xmlNode *node = NULL;
+    int ret;
+
+    if (xmlTextReaderIsEmptyElement(p->reader))
+        return true;
+
+    while ((ret = next_child(p)) == 1) {
+        bool ok;
 
-    for (node = variant_list->children; node; node = node->next) {
-        if (is_node(node, "variant"))
-            parse_variant(ctx, l, node, popularity);
+        if (is_node(p->reader, "variant"))
+            ok = parse_variant(p, l);
+        else
+            ok = skip_element(p);
+        if (!ok)
+            return false;
     }
+
+    return ret == 0;
 }
 
-static void
-parse_layout(struct rxkb_context *ctx, xmlNode *layout,
-             enum rxkb_popularity popularity)
+static bool
+parse_layout(struct xml_parser *p)
 {
-    char *name, *description, *brief, *vendor;
+    struct rxkb_context *ctx = p->ctx;
+    struct config_item item;
     struct rxkb_layout *l;
-    xmlNode *node = NULL;
     bool exists = false;
+    int ret;
 
-    if (!parse_config_item(ctx, layout, &name, &description, &brief, &vendor))
-        return;
+    ret = read_first_config_item(p, &item);
+    if (ret <= 0)
+        return ret == 0;
 
     list_for_each(l, &ctx->layouts, base.link) {
-        if (streq(l->name, name) && l->variant == NULL) {
+        if (streq(l->name, item.name) && l->variant == NULL) {
             exists = true;
             break;
         }
@@ -917,89 +2054,85 @@ parse_layout(struct rxkb_context *ctx, xmlNode *layout,
         l = rxkb_layout_create(&ctx->base);
         list_init(&l->iso639s);
         list_init(&l->iso3166s);
-        l->name = name;
+        l->name = item.name;
         l->variant = NULL;
-        l->description = description;
-        l->brief = brief;
-        l->popularity = popularity;
+        l->description = item.description;
+        l->brief = item.brief;
+        l->popularity = p->popularity;
         list_append(&ctx->layouts, &l->base.link);
-    } else {
-        free(name);
-        free(description);
-        free(brief);
-        free(vendor);
+        add_codes(l, &item);
+        item.name = item.description = item.brief = NULL;
     }
+    config_item_free(&item);
 
-    for (node = layout->children; node; node = node->next) {
-        if (is_node(node, "variantList")) {
-            parse_variant_list(ctx, l, node, popularity);
-        }
-        if (!exists && is_node(node, "configItem")) {
-            xmlNode *ll;
-            for (ll = node->children; ll; ll = ll->next) {
-                if (is_node(ll, "languageList"))
-                    parse_language_list(ll, l);
-                if (is_node(ll, "countryList"))
-                    parse_country_list(ll, l);
-            }
-        }
-    }
-}
-
-static void
-parse_layout_list(struct rxkb_context *ctx, xmlNode *layout_list,
-                  enum rxkb_popularity popularity)
-{
-    xmlNode *node = NULL;
+    while ((ret = next_child(p)) == 1) {
+        bool ok;
 
-    for (node = layout_list->children; node; node = node->next) {
-        if (is_node(node, "layout"))
-            parse_layout(ctx, node, popularity);
+        if (is_node(p->reader, "variantList"))
+            ok = parse_variant_list(p, l);
+        else
+            ok = skip_element(p);
+        if (!ok)
+            return false;
     }
+
+    return ret == 0;
 }
 
-static void
-parse_option(struct rxkb_context *ctx, struct rxkb_option_group *group,
-             xmlNode *option, enum rxkb_popularity popularity)
+static bool
+parse_option(struct xml_parser *p, struct rxkb_option_group *group)
 {
-    char *name, *description, *brief, *vendor;
+    struct config_item item;
+    struct rxkb_option *o;
+    bool exists = false;
+    int ret;
 
-    if (parse_config_item(ctx, option, &name, &description, &brief, &vendor)) {
-        struct rxkb_option *o;
+    ret = read_first_config_item(p, &item);
+    if (ret <= 0)
+        return ret == 0;
 
-        list_for_each(o, &group->options, base.link) {
-            if (streq(o->name, name)) {
-                free(name);
-                free(description);
-                free(brief);
-                free(vendor);
-                return;
-            }
+    list_for_each(o, &group->options, base.link) {
+        if (streq(o->name, item.name)) {
+            exists = true;
+            break;
         }
+    }
 
+    if (!exists) {
         o = rxkb_option_create(&group->base);
-        o->name = name;
-        o->description = description;
-        o->popularity = popularity;
+        o->name = item.name;
+        o->description = item.description;
+        o->popularity = p->popularity;
         list_append(&group->options, &o->base.link);
+        item.name = item.description = NULL;
     }
+    config_item_free(&item);
+
+    return skip_children(p);
 }
 
-static void
-parse_group(struct rxkb_context *ctx, xmlNode *group,
-            enum rxkb_popularity popularity)
+static bool
+parse_group(struct xml_parser *p)
 {
-    char *name, *description, *brief, *vendor;
+    struct rxkb_context *ctx = p->ctx;
+    struct config_item item;
     struct rxkb_option_group *g;
-    xmlNode *node = NULL;
     xmlChar *multiple;
     bool exists = false;
+    int ret;
 
-    if (!parse_config_item(ctx, group, &name, &description, &brief, &vendor))
-        return;
+    /* The attribute must be read while on the group element. */
+    multiple = xmlTextReaderGetAttribute(
+        p->reader, (const xmlChar *) "allowMultipleSelection");
+
+    ret = read_first_config_item(p, &item);
+    if (ret <= 0) {
+        xmlFree(multiple);
+        return ret == 0;
+    }
 
     list_for_each(g, &ctx->option_groups, base.link) {
-        if (streq(g->name, name)) {
+        if (streq(g->name, item.name)) {
             exists = true;
             break;
         }
@@ -1007,55 +2140,141 @@ parse_group(struct rxkb_context *ctx, xmlNode *group,
 
     if (!exists) {
         g = rxkb_option_group_create(&ctx->base);
-        g->name = name;
-        g->description = description;
-        g->popularity = popularity;
-
-        multiple = xmlGetProp(group, (const xmlChar*)"allowMultipleSelection");
-        if (multiple && xmlStrEqual(multiple, (const xmlChar*)"true"))
+        g->name = item.name;
+        g->description = item.description;
+        g->popularity = p->popularity;
+        if (multiple && xmlStrEqual(multiple, (const xmlChar *) "true"))
             g->allow_multiple = true;
-        xmlFree(multiple);
-
         list_init(&g->options);
         list_append(&ctx->option_groups, &g->base.link);
-    } else {
-        free(name);
-        free(description);
-        free(brief);
-        free(vendor);
+        item.name = item.description = NULL;
+    }
+    xmlFree(multiple);
+    config_item_free(&item);
+
+    while ((ret = next_child(p)) == 1) {
+        bool ok;
+
+        if (is_node(p->reader, "option"))
+            ok = parse_option(p, g);
+        else
+            ok = skip_element(p);
+        if (!ok)
+            return false;
     }
 
-    for (node = group->children; node; node = node->next) {
-        if (is_node(node, "option"))
-            parse_option(ctx, g, node, popularity);
+    return ret == 0;
+}
+
+/* Parses the @child elements of a list with @parse_child. */
+static bool
+parse_list(struct xml_parser *p, const char *child,
+           bool (*parse_child)(struct xml_parser *p))
+{
+    int ret;
+
+    if (xmlTextReaderIsEmptyElement(p->reader))
+        return true;
+
+    while ((ret = next_child(p)) == 1) {
+        bool ok;
+
+        if (is_node(p->reader, child))
+            ok = parse_child(p);
+        else
+            ok = skip_element(p);
+        if (!ok)
+            return false;
     }
+
+    return ret == 0;
 }
 
-static void
-parse_option_list(struct rxkb_context *ctx, xmlNode *option_list,
-                  enum rxkb_popularity popularity)
+static bool
+parse_rules_xml(struct xml_parser *p)
 {
-    xmlNode *node = NULL;
+    int ret;
+
+    /* Skip the prolog, up to the root element. */
+    while ((ret = xmlTextReaderRead(p->reader)) == 1 &&
+           xmlTextReaderNodeType(p->reader) != XML_READER_TYPE_ELEMENT)
+        ;
+    if (ret != 1)
+        return false;
 
-    for (node = option_list->children; node; node = node->next) {
-        if (is_node(node, "group"))
-            parse_group(ctx, node, popularity);
+    if (!xmlTextReaderIsEmptyElement(p->reader)) {
+        while ((ret = next_child(p)) == 1) {
+            bool ok;
+
+            if (is_node(p->reader, "modelList"))
+                ok = parse_list(p, "model", parse_model);
+            else if (is_node(p->reader, "layoutList"))
+                ok = parse_list(p, "layout", parse_layout);
+            else if (is_node(p->reader, "optionList"))
+                ok = parse_list(p, "group", parse_group);
+            else
+                ok = skip_element(p);
+            if (!ok)
+                return false;
+        }
+        if (ret < 0)
+            return false;
     }
+
+    /* Read up to the end, to catch errors in the rest of the document. */
+    while ((ret = xmlTextReaderRead(p->reader)) == 1)
+        ;
+
+    return ret == 0;
+}
+
+/*
+ * The items of the context before parsing a file, so that they can be
+ * restored if the file turns out to be invalid.  Parsing only ever appends
+ * items, to the context and to existing option groups.
+ */
+struct items_mark {
+    struct list *last_model;
+    struct list *last_layout;
+    struct list *last_option_group;
+    darray(struct list *) last_options;
+};
+
+static void
+mark_items(struct rxkb_context *ctx, struct items_mark *mark)
+{
+    struct rxkb_option_group *g;
+
+    mark->last_model = ctx->models.prev;
+    mark->last_layout = ctx->layouts.prev;
+    mark->last_option_group = ctx->option_groups.prev;
+    darray_init(mark->last_options);
+    list_for_each(g, &ctx->option_groups, base.link)
+        darray_append(mark->last_options, g->options.prev);
 }
 
 static void
-parse_rules_xml(struct rxkb_context *ctx, xmlNode *root,
-                enum rxkb_popularity popularity)
+restore_items(struct rxkb_context *ctx, struct items_mark *mark)
 {
-    xmlNode *node = NULL;
+    struct rxkb_model *m = NULL;
+    struct rxkb_layout *l = NULL;
+    struct rxkb_option_group *g = NULL;
+    struct rxkb_option *o = NULL;
+    unsigned i = 0;
+
+    while (ctx->models.prev != mark->last_model)
+        rxkb_model_unref(list_last_entry(&ctx->models, m, base.link));
+    while (ctx->layouts.prev != mark->last_layout)
+        rxkb_layout_unref(list_last_entry(&ctx->layouts, l, base.link));
+    while (ctx->option_groups.prev != mark->last_option_group)
+        rxkb_option_group_unref(list_last_entry(&ctx->option_groups, g,
+                                                base.link));
+
+    list_for_each(g, &ctx->option_groups, base.link) {
+        struct list *last_option = darray_item(mark->last_options, i++);
 
-    for (node = root->children; node; node = node->next) {
-        if (is_node(node, "modelList"))
-            parse_model_list(ctx, node, popularity);
-        else if (is_node(node, "layoutList"))
-            parse_layout_list(ctx, node, popularity);
-        else if (is_node(node, "optionList"))
-            parse_option_list(ctx, node, popularity);
+        while (g->options.prev != last_option)
+            rxkb_option_unref(list_last_entry(&g->options, o, base.link));
     }
 }
 
@@ -1167,9 +2386,10 @@ static bool
 parse(struct rxkb_context *ctx, const char *path,
       enum rxkb_popularity popularity)
 {
-    bool success = false;
+    struct xml_parser parser;
+    struct items_mark mark;
     xmlDoc *doc = NULL;
-    xmlNode *root = NULL;
+    bool success;
 
     if (!check_eaccess(path, R_OK))
         return false;
@@ -1178,20 +2398,39 @@ parse(struct rxkb_context *ctx, const char *path,
 
     xmlSetGenericErrorFunc(ctx, xml_error_func);
 
-    doc = xmlParseFile(path);
-    if (!doc)
-        return false;
+    parser.ctx = ctx;
+    parser.popularity = popularity;
+    if (ctx->validate) {
+        doc = xmlParseFile(path);
+        if (!doc)
+            return false;
+
+        if (!validate(ctx, doc)) {
+            log_err(ctx, "XML error: failed to validate document at %s\n",
+                    path);
+            xmlFreeDoc(doc);
+            return false;
+        }
 
-    if (!validate(ctx, doc)) {
-        log_err(ctx, "XML error: failed to validate document at %s\n", path);
-        goto error;
+        parser.reader = xmlReaderWalker(doc);
+    }
+    else {
+        parser.reader = xmlReaderForFile(path, NULL, 0);
+    }
+    if (!parser.reader) {
+        xmlFreeDoc(doc);
+        return false;
     }
 
-    root = xmlDocGetRootElement(doc);
-    parse_rules_xml(ctx, root, popularity);
+    mark_items(ctx, &mark);
+    success = parse_rules_xml(&parser);
+    if (!success) {
+        log_err(ctx, "XML error: failed to parse document at %s\n", path);
+        restore_items(ctx, &mark);
+    }
+    darray_free(mark.last_options);
 
-    success = true;
-error:
+    xmlFreeTextReader(parser.reader);
     xmlFreeDoc(doc);
     xmlCleanupParser();
 
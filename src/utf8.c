@@ -29,6 +29,7 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <inttypes.h>
+#include <string.h>
 
 #include "utf8.h"
 
@@ -69,72 +70,120 @@ utf32_to_utf8(uint32_t unichar, char *buffer)
     return length + 1;
 }
 
+/* Whether all of the 8 bytes starting at s are ASCII. */
+static inline bool
+is_ascii_word(const uint8_t *s)
+{
+    uint64_t word;
+
+    memcpy(&word, s, sizeof(word));
+    return (word & UINT64_C(0x8080808080808080)) == 0;
+}
+
+/*
+ * Decode the UTF-8 sequence starting at s[*i], advancing *i past it.
+ * Returns false if it is not a valid sequence.
+ *
+ * This beauty is from:
+ *  The Unicode Standard Version 6.2 - Core Specification, Table 3.7
+ *  https://www.unicode.org/versions/Unicode6.2.0/ch03.pdf#G7404
+ */
+static inline bool
+decode_one(const uint8_t *s, size_t len, size_t *i, uint32_t *cp)
+{
+    size_t tail_bytes;
+    uint8_t second_min = 0x80, second_max = 0xBF;
+    uint32_t c = s[*i];
+
+    if (c <= 0x7F) {
+        *cp = c;
+        *i += 1;
+        return true;
+    }
+    else if (c >= 0xC2 && c <= 0xDF) {
+        tail_bytes = 1;
+        c &= 0x1F;
+    }
+    else if (c >= 0xE0 && c <= 0xEF) {
+        tail_bytes = 2;
+        if (c == 0xE0)
+            second_min = 0xA0;
+        else if (c == 0xED)
+            second_max = 0x9F;
+        c &= 0x0F;
+    }
+    else if (c >= 0xF0 && c <= 0xF4) {
+        tail_bytes = 3;
+        if (c == 0xF0)
+            second_min = 0x90;
+        else if (c == 0xF4)
+            second_max = 0x8F;
+        c &= 0x07;
+    }
+    else {
+        return false;
+    }
+
+    if (len - *i <= tail_bytes)
+        return false;
+    if (s[*i + 1] < second_min || s[*i + 1] > second_max)
+        return false;
+
+    for (size_t j = 1; j <= tail_bytes; j++) {
+        if (s[*i + j] < 0x80 || s[*i + j] > 0xBF)
+            return false;
+        c = (c << 6) | (s[*i + j] & 0x3F);
+    }
+
+    *cp = c;
+    *i += tail_bytes + 1;
+    return true;
+}
+
+/*
+ * Runs of ASCII, which make up most of the strings we see, are skipped
+ * 8 bytes at a time.
+ */
 bool
 is_valid_utf8(const char *ss, size_t len)
 {
     size_t i = 0;
-    size_t tail_bytes = 0;
+    uint32_t cp;
     const uint8_t *s = (const uint8_t *) ss;
 
-    /* This beauty is from:
-     *  The Unicode Standard Version 6.2 - Core Specification, Table 3.7
-     *  https://www.unicode.org/versions/Unicode6.2.0/ch03.pdf#G7404
-     * We can optimize if needed. */
-    while (i < len)
-    {
-        if (s[i] <= 0x7F) {
-            tail_bytes = 0;
-        }
-        else if (s[i] >= 0xC2 && s[i] <= 0xDF) {
-            tail_bytes = 1;
-        }
-        else if (s[i] == 0xE0) {
-            i++;
-            if (i >= len || !(s[i] >= 0xA0 && s[i] <= 0xBF))
-                return false;
-            tail_bytes = 1;
-        }
-        else if (s[i] >= 0xE1 && s[i] <= 0xEC) {
-            tail_bytes = 2;
-        }
-        else if (s[i] == 0xED) {
-            i++;
-            if (i >= len || !(s[i] >= 0x80 && s[i] <= 0x9F))
-                return false;
-            tail_bytes = 1;
-        }
-        else if (s[i] >= 0xEE && s[i] <= 0xEF) {
-            tail_bytes = 2;
-        }
-        else if (s[i] == 0xF0) {
-            i++;
-            if (i >= len || !(s[i] >= 0x90 && s[i] <= 0xBF))
-                return false;
-            tail_bytes = 2;
-        }
-        else if (s[i] >= 0xF1 && s[i] <= 0xF3) {
-            tail_bytes = 3;
-        }
-        else if (s[i] == 0xF4) {
-            i++;
-            if (i >= len || !(s[i] >= 0x80 && s[i] <= 0x8F))
-                return false;
-            tail_bytes = 2;
-        }
-        else {
+    while (i < len) {
+        while (i + 8 <= len && is_ascii_word(s + i))
+            i += 8;
+        if (i >= len)
+            break;
+
+        if (!decode_one(s, len, &i, &cp))
             return false;
-        }
+    }
+
+    return true;
+}
 
-        i++;
+bool
+utf8_to_utf32(const char *ss, size_t len, uint32_t *out, size_t *count)
+{
+    size_t i = 0, n = 0;
+    const uint8_t *s = (const uint8_t *) ss;
 
-        while (i < len && tail_bytes > 0 && s[i] >= 0x80 && s[i] <= 0xBF) {
-            i++;
-            tail_bytes--;
+    while (i < len) {
+        while (i + 8 <= len && is_ascii_word(s + i)) {
+            for (size_t j = 0; j < 8; j++)
+                out[n++] = s[i + j];
+            i += 8;
         }
+        if (i >= len)
+            break;
 
-        if (tail_bytes != 0)
+        if (!decode_one(s, len, &i, &out[n]))
             return false;
+        n++;
     }
 
+    *count = n;
     return true;
 }
@@ -33,4 +33,11 @@ utf32_to_utf8(uint32_t unichar, char *buffer);
 bool
 is_valid_utf8(const char *ss, size_t len);
 
+/*
+ * Decode a UTF-8 string into UTF-32.  out must have room for len
+ * codepoints.  Returns false if the string is not valid UTF-8.
+ */
+bool
+utf8_to_utf32(const char *ss, size_t len, uint32_t *out, size_t *count);
+
 #endif
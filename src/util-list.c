@@ -87,6 +87,22 @@ list_empty(const struct list *list)
 	return list->next == list;
 }
 
+int
+list_length(const struct list *list)
+{
+	struct list *e;
+	int count;
+
+	count = 0;
+	e = list->next;
+	while (e != list) {
+		e = e->next;
+		count++;
+	}
+
+	return count;
+}
+
 bool
 list_is_last(const struct list *list, const struct list *elm)
 {
@@ -45,6 +45,7 @@ void list_insert(struct list *list, struct list *elm);
 void list_append(struct list *list, struct list *elm);
 void list_remove(struct list *elm);
 bool list_empty(const struct list *list);
+int list_length(const struct list *list);
 bool list_is_last(const struct list *list, const struct list *elm);
 
 #define container_of(ptr, type, member)					\
@@ -23,6 +23,13 @@
 
 #include "config.h"
 
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#endif
+
 #include "utils.h"
 
 #ifdef HAVE_MMAP
@@ -30,8 +37,6 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
-#include <sys/stat.h>
-#include <sys/types.h>
 
 bool
 map_file(FILE *file, char **string_out, size_t *size_out)
@@ -111,6 +116,56 @@ unmap_file(char *str, size_t size)
 
 #endif
 
+/* The modification time with nanoseconds, where the system has them. */
+void
+get_mtime(const struct stat *st, int64_t *sec, uint32_t *nsec)
+{
+#if defined(HAVE_STAT_ST_MTIM)
+    *sec = st->st_mtim.tv_sec;
+    *nsec = st->st_mtim.tv_nsec;
+#elif defined(HAVE_STAT_ST_MTIMESPEC)
+    *sec = st->st_mtimespec.tv_sec;
+    *nsec = st->st_mtimespec.tv_nsec;
+#else
+    *sec = st->st_mtime;
+    *nsec = 0;
+#endif
+}
+
+/*
+ * Returns $XDG_CACHE_HOME/xkbcommon/@name, or ~/.cache/xkbcommon/@name
+ * if XDG_CACHE_HOME is not an absolute path.
+ */
+char *
+get_xdg_cache_file_path(const char *name)
+{
+    const char *xdg_cache_home, *home;
+
+    xdg_cache_home = secure_getenv("XDG_CACHE_HOME");
+    if (xdg_cache_home && xdg_cache_home[0] == '/')
+        return asprintf_safe("%s/xkbcommon/%s", xdg_cache_home, name);
+
+    home = secure_getenv("HOME");
+    if (!home)
+        return NULL;
+    return asprintf_safe("%s/.cache/xkbcommon/%s", home, name);
+}
+
+/* Like `mkdir -p`, for the directory containing @path. */
+bool
+make_parent_dirs(char *path)
+{
+    for (char *p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+        *p = '\0';
+        if (mkdir(path, 0700) != 0 && errno != EEXIST) {
+            *p = '/';
+            return false;
+        }
+        *p = '/';
+    }
+    return true;
+}
+
 // ASCII lower-case map.
 static const unsigned char lower_map[] = {
     0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
@@ -214,12 +214,51 @@ one_bit_set(uint32_t x)
     return x && (x & (x - 1)) == 0;
 }
 
+/* FNV-1a, continued from @hash; start from FNV1A_32_INIT. */
+#define FNV1A_32_INIT 2166136261u
+
+static inline uint32_t
+fnv1a_32(uint32_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* 64-bit FNV-1a, continued from @hash; start from FNV1A_64_INIT. */
+#define FNV1A_64_INIT UINT64_C(14695981039346656037)
+
+static inline uint64_t
+fnv1a_64(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
 bool
 map_file(FILE *file, char **string_out, size_t *size_out);
 
 void
 unmap_file(char *string, size_t size);
 
+struct stat;
+
+void
+get_mtime(const struct stat *st, int64_t *sec, uint32_t *nsec);
+
+char *
+get_xdg_cache_file_path(const char *name);
+
+bool
+make_parent_dirs(char *path);
+
 static inline bool
 check_eaccess(const char *path, int mode)
 {
@@ -55,6 +55,13 @@
 /* XkbAllIndicatorsMask. */
 #define ALL_INDICATORS_MASK 0xffffffff
 
+#define ALL_CHANGES \
+    (XKB_X11_KEYMAP_CHANGED_MAP | \
+     XKB_X11_KEYMAP_CHANGED_INDICATOR_MAP | \
+     XKB_X11_KEYMAP_CHANGED_COMPAT_MAP | \
+     XKB_X11_KEYMAP_CHANGED_NAMES | \
+     XKB_X11_KEYMAP_CHANGED_CONTROLS)
+
 /* Some macros. Not very nice but it'd be worse without them. */
 
 /*
@@ -644,27 +651,33 @@ fail:
     return false;
 }
 
+static const xcb_xkb_map_part_t get_map_required_components =
+    (XCB_XKB_MAP_PART_KEY_TYPES |
+     XCB_XKB_MAP_PART_KEY_SYMS |
+     XCB_XKB_MAP_PART_MODIFIER_MAP |
+     XCB_XKB_MAP_PART_EXPLICIT_COMPONENTS |
+     XCB_XKB_MAP_PART_KEY_ACTIONS |
+     XCB_XKB_MAP_PART_VIRTUAL_MODS |
+     XCB_XKB_MAP_PART_VIRTUAL_MOD_MAP);
+
+static xcb_xkb_get_map_cookie_t
+send_map_request(xcb_connection_t *conn, uint16_t device_id)
+{
+    return xcb_xkb_get_map(conn, device_id, get_map_required_components,
+                           0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+}
+
 static bool
-get_map(struct xkb_keymap *keymap, xcb_connection_t *conn, uint16_t device_id)
+get_map(struct xkb_keymap *keymap, xcb_connection_t *conn,
+        xcb_xkb_get_map_cookie_t cookie)
 {
-    static const xcb_xkb_map_part_t required_components =
-        (XCB_XKB_MAP_PART_KEY_TYPES |
-         XCB_XKB_MAP_PART_KEY_SYMS |
-         XCB_XKB_MAP_PART_MODIFIER_MAP |
-         XCB_XKB_MAP_PART_EXPLICIT_COMPONENTS |
-         XCB_XKB_MAP_PART_KEY_ACTIONS |
-         XCB_XKB_MAP_PART_VIRTUAL_MODS |
-         XCB_XKB_MAP_PART_VIRTUAL_MOD_MAP);
-
-    xcb_xkb_get_map_cookie_t cookie =
-        xcb_xkb_get_map(conn, device_id, required_components,
-                        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
     xcb_xkb_get_map_reply_t *reply = xcb_xkb_get_map_reply(conn, cookie, NULL);
     xcb_xkb_get_map_map_t map;
 
     FAIL_IF_BAD_REPLY(reply, "XkbGetMap");
 
-    if ((reply->present & required_components) != required_components)
+    if ((reply->present & get_map_required_components) !=
+        get_map_required_components)
         goto fail;
 
     xcb_xkb_get_map_map_unpack(xcb_xkb_get_map_map(reply),
@@ -747,12 +760,16 @@ get_indicators(struct xkb_keymap *keymap, xcb_connection_t *conn,
     return true;
 }
 
+static xcb_xkb_get_indicator_map_cookie_t
+send_indicator_map_request(xcb_connection_t *conn, uint16_t device_id)
+{
+    return xcb_xkb_get_indicator_map(conn, device_id, ALL_INDICATORS_MASK);
+}
+
 static bool
 get_indicator_map(struct xkb_keymap *keymap, xcb_connection_t *conn,
-                  uint16_t device_id)
+                  xcb_xkb_get_indicator_map_cookie_t cookie)
 {
-    xcb_xkb_get_indicator_map_cookie_t cookie =
-        xcb_xkb_get_indicator_map(conn, device_id, ALL_INDICATORS_MASK);
     xcb_xkb_get_indicator_map_reply_t *reply =
         xcb_xkb_get_indicator_map_reply(conn, cookie, NULL);
 
@@ -829,12 +846,16 @@ fail:
     return false;
 }
 
+static xcb_xkb_get_compat_map_cookie_t
+send_compat_map_request(xcb_connection_t *conn, uint16_t device_id)
+{
+    return xcb_xkb_get_compat_map(conn, device_id, 0, true, 0, 0);
+}
+
 static bool
 get_compat_map(struct xkb_keymap *keymap, xcb_connection_t *conn,
-               uint16_t device_id)
+               xcb_xkb_get_compat_map_cookie_t cookie)
 {
-    xcb_xkb_get_compat_map_cookie_t cookie =
-        xcb_xkb_get_compat_map(conn, device_id, 0, true, 0, 0);
     xcb_xkb_get_compat_map_reply_t *reply =
         xcb_xkb_get_compat_map_reply(conn, cookie, NULL);
 
@@ -852,7 +873,7 @@ fail:
 }
 
 static bool
-get_type_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
+get_type_names(struct xkb_keymap *keymap, struct x11_atom_interner *interner,
                xcb_xkb_get_names_reply_t *reply,
                xcb_xkb_get_names_value_list_t *list)
 {
@@ -880,13 +901,9 @@ get_type_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
 
         ALLOC_OR_FAIL(type->level_names, type->num_levels);
 
-        if (!adopt_atom(keymap->ctx, conn, wire_type_name, &type->name))
-            goto fail;
-
-        if (!adopt_atoms(keymap->ctx, conn,
-                         kt_level_names_iter, type->level_names,
-                         wire_num_levels))
-            goto fail;
+        x11_atom_interner_adopt_atom(interner, wire_type_name, &type->name);
+        x11_atom_interner_adopt_atoms(interner, kt_level_names_iter,
+                                      type->level_names, wire_num_levels);
 
         type->num_level_names = type->num_levels;
         kt_level_names_iter += wire_num_levels;
@@ -901,7 +918,7 @@ fail:
 }
 
 static bool
-get_indicator_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
+get_indicator_names(struct xkb_keymap *keymap, struct x11_atom_interner *interner,
                     xcb_xkb_get_names_reply_t *reply,
                     xcb_xkb_get_names_value_list_t *list)
 {
@@ -914,8 +931,7 @@ get_indicator_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
             xcb_atom_t wire = *iter;
             struct xkb_led *led = &keymap->leds[i];
 
-            if (!adopt_atom(keymap->ctx, conn, wire, &led->name))
-                return false;
+            x11_atom_interner_adopt_atom(interner, wire, &led->name);
 
             iter++;
         }
@@ -928,7 +944,7 @@ fail:
 }
 
 static bool
-get_vmod_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
+get_vmod_names(struct xkb_keymap *keymap, struct x11_atom_interner *interner,
                xcb_xkb_get_names_reply_t *reply,
                xcb_xkb_get_names_value_list_t *list)
 {
@@ -947,8 +963,7 @@ get_vmod_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
             xcb_atom_t wire = *iter;
             struct xkb_mod *mod = &keymap->mods.mods[NUM_REAL_MODS + i];
 
-            if (!adopt_atom(keymap->ctx, conn, wire, &mod->name))
-                return false;
+            x11_atom_interner_adopt_atom(interner, wire, &mod->name);
 
             iter++;
         }
@@ -958,7 +973,7 @@ get_vmod_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
 }
 
 static bool
-get_group_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
+get_group_names(struct xkb_keymap *keymap, struct x11_atom_interner *interner,
                 xcb_xkb_get_names_reply_t *reply,
                 xcb_xkb_get_names_value_list_t *list)
 {
@@ -968,9 +983,8 @@ get_group_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
     keymap->num_group_names = msb_pos(reply->groupNames);
     ALLOC_OR_FAIL(keymap->group_names, keymap->num_group_names);
 
-    if (!adopt_atoms(keymap->ctx, conn,
-                     iter, keymap->group_names, length))
-        goto fail;
+    x11_atom_interner_adopt_atoms(interner, iter,
+                                  keymap->group_names, length);
 
     return true;
 
@@ -1050,9 +1064,8 @@ fail:
     return false;
 }
 
-static bool
-get_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
-          uint16_t device_id)
+static xcb_xkb_get_names_cookie_t
+send_names_request(xcb_connection_t *conn, uint16_t device_id)
 {
     static const xcb_xkb_name_detail_t wanted =
         (XCB_XKB_NAME_DETAIL_KEYCODES |
@@ -1066,14 +1079,26 @@ get_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
          XCB_XKB_NAME_DETAIL_KEY_ALIASES |
          XCB_XKB_NAME_DETAIL_VIRTUAL_MOD_NAMES |
          XCB_XKB_NAME_DETAIL_GROUP_NAMES);
+
+    return xcb_xkb_get_names(conn, device_id, wanted);
+}
+
+/*
+ * The atoms in the names are only requested here; they are resolved
+ * (and the section names escaped) by the caller's
+ * x11_atom_interner_round_trip().
+ */
+static bool
+get_names(struct xkb_keymap *keymap, struct x11_atom_interner *interner,
+          xcb_xkb_get_names_cookie_t cookie)
+{
     static const xcb_xkb_name_detail_t required =
         (XCB_XKB_NAME_DETAIL_KEY_TYPE_NAMES |
          XCB_XKB_NAME_DETAIL_KT_LEVEL_NAMES |
          XCB_XKB_NAME_DETAIL_KEY_NAMES |
          XCB_XKB_NAME_DETAIL_VIRTUAL_MOD_NAMES);
 
-    xcb_xkb_get_names_cookie_t cookie =
-        xcb_xkb_get_names(conn, device_id, wanted);
+    xcb_connection_t *conn = interner->conn;
     xcb_xkb_get_names_reply_t *reply =
         xcb_xkb_get_names_reply(conn, cookie, NULL);
     xcb_xkb_get_names_value_list_t list;
@@ -1093,23 +1118,23 @@ get_names(struct xkb_keymap *keymap, xcb_connection_t *conn,
                                         reply->which,
                                         &list);
 
-    if (!get_atom_name(conn, list.keycodesName, &keymap->keycodes_section_name) ||
-        !get_atom_name(conn, list.symbolsName, &keymap->symbols_section_name) ||
-        !get_atom_name(conn, list.typesName, &keymap->types_section_name) ||
-        !get_atom_name(conn, list.compatName, &keymap->compat_section_name) ||
-        !get_type_names(keymap, conn, reply, &list) ||
-        !get_indicator_names(keymap, conn, reply, &list) ||
-        !get_vmod_names(keymap, conn, reply, &list) ||
-        !get_group_names(keymap, conn, reply, &list) ||
+    x11_atom_interner_get_escaped_atom_name(interner, list.keycodesName,
+                                            &keymap->keycodes_section_name);
+    x11_atom_interner_get_escaped_atom_name(interner, list.symbolsName,
+                                            &keymap->symbols_section_name);
+    x11_atom_interner_get_escaped_atom_name(interner, list.typesName,
+                                            &keymap->types_section_name);
+    x11_atom_interner_get_escaped_atom_name(interner, list.compatName,
+                                            &keymap->compat_section_name);
+
+    if (!get_type_names(keymap, interner, reply, &list) ||
+        !get_indicator_names(keymap, interner, reply, &list) ||
+        !get_vmod_names(keymap, interner, reply, &list) ||
+        !get_group_names(keymap, interner, reply, &list) ||
         !get_key_names(keymap, conn, reply, &list) ||
         !get_aliases(keymap, conn, reply, &list))
         goto fail;
 
-    XkbEscapeMapName(keymap->keycodes_section_name);
-    XkbEscapeMapName(keymap->symbols_section_name);
-    XkbEscapeMapName(keymap->types_section_name);
-    XkbEscapeMapName(keymap->compat_section_name);
-
     free(reply);
     return true;
 
@@ -1118,12 +1143,16 @@ fail:
     return false;
 }
 
+static xcb_xkb_get_controls_cookie_t
+send_controls_request(xcb_connection_t *conn, uint16_t device_id)
+{
+    return xcb_xkb_get_controls(conn, device_id);
+}
+
 static bool
 get_controls(struct xkb_keymap *keymap, xcb_connection_t *conn,
-             uint16_t device_id)
+             xcb_xkb_get_controls_cookie_t cookie)
 {
-    xcb_xkb_get_controls_cookie_t cookie =
-        xcb_xkb_get_controls(conn, device_id);
     xcb_xkb_get_controls_reply_t *reply =
         xcb_xkb_get_controls_reply(conn, cookie, NULL);
 
@@ -1146,6 +1175,347 @@ fail:
     return false;
 }
 
+/*
+ * Copying the parts of an existing keymap which didn't change. Each of
+ * these copies exactly the fields which the corresponding get_*()
+ * functions set; in particular, the names are left for copy_names() or
+ * get_names().
+ */
+
+static bool
+copy_map(struct xkb_keymap *keymap, const struct xkb_keymap *old)
+{
+    keymap->num_types = old->num_types;
+    ALLOC_OR_FAIL(keymap->types, keymap->num_types);
+
+    for (unsigned i = 0; i < keymap->num_types; i++) {
+        const struct xkb_key_type *old_type = &old->types[i];
+        struct xkb_key_type *type = &keymap->types[i];
+
+        type->mods = old_type->mods;
+        type->num_levels = old_type->num_levels;
+        type->num_entries = old_type->num_entries;
+        ALLOC_OR_FAIL(type->entries, type->num_entries);
+        for (unsigned j = 0; j < type->num_entries; j++)
+            type->entries[j] = old_type->entries[j];
+    }
+
+    keymap->min_key_code = old->min_key_code;
+    keymap->max_key_code = old->max_key_code;
+    ALLOC_OR_FAIL(keymap->keys, keymap->max_key_code + 1);
+
+    for (xkb_keycode_t kc = keymap->min_key_code; kc <= keymap->max_key_code; kc++) {
+        const struct xkb_key *old_key = &old->keys[kc];
+        struct xkb_key *key = &keymap->keys[kc];
+
+        key->keycode = kc;
+        key->explicit = old_key->explicit;
+        key->modmap = old_key->modmap;
+        key->vmodmap = old_key->vmodmap;
+        key->out_of_range_group_action = old_key->out_of_range_group_action;
+        key->out_of_range_group_number = old_key->out_of_range_group_number;
+
+        key->num_groups = old_key->num_groups;
+        ALLOC_OR_FAIL(key->groups, key->num_groups);
+
+        for (xkb_layout_index_t group = 0; group < key->num_groups; group++) {
+            const struct xkb_group *old_group = &old_key->groups[group];
+            struct xkb_group *new_group = &key->groups[group];
+            xkb_level_index_t num_levels = old_group->type->num_levels;
+
+            new_group->explicit_type = old_group->explicit_type;
+            new_group->type = &keymap->types[old_group->type - old->types];
+            ALLOC_OR_FAIL(new_group->levels, num_levels);
+
+            for (xkb_level_index_t level = 0; level < num_levels; level++) {
+                const struct xkb_level *old_level = &old_group->levels[level];
+                struct xkb_level *new_level = &new_group->levels[level];
+
+                if (old_level->num_syms > 1) {
+                    new_level->u.syms = memdup(old_level->u.syms,
+                                               old_level->num_syms,
+                                               sizeof(*old_level->u.syms));
+                    if (!new_level->u.syms)
+                        goto fail;
+                }
+                else {
+                    new_level->u.sym = old_level->u.sym;
+                }
+                new_level->num_syms = old_level->num_syms;
+                new_level->action = old_level->action;
+            }
+        }
+    }
+
+    keymap->mods.num_mods = old->mods.num_mods;
+    for (unsigned i = NUM_REAL_MODS; i < NUM_REAL_MODS + NUM_VMODS; i++) {
+        keymap->mods.mods[i].type = old->mods.mods[i].type;
+        keymap->mods.mods[i].mapping = old->mods.mods[i].mapping;
+    }
+
+    return true;
+
+fail:
+    return false;
+}
+
+static bool
+copy_indicator_map(struct xkb_keymap *keymap, const struct xkb_keymap *old)
+{
+    keymap->num_leds = old->num_leds;
+
+    for (unsigned i = 0; i < NUM_INDICATORS; i++) {
+        keymap->leds[i] = old->leds[i];
+        keymap->leds[i].name = XKB_ATOM_NONE;
+    }
+
+    return true;
+}
+
+static bool
+copy_compat_map(struct xkb_keymap *keymap, const struct xkb_keymap *old)
+{
+    keymap->num_sym_interprets = old->num_sym_interprets;
+    ALLOC_OR_FAIL(keymap->sym_interprets, keymap->num_sym_interprets);
+
+    for (unsigned i = 0; i < keymap->num_sym_interprets; i++)
+        keymap->sym_interprets[i] = old->sym_interprets[i];
+
+    return true;
+
+fail:
+    return false;
+}
+
+static bool
+copy_names(struct xkb_keymap *keymap, const struct xkb_keymap *old)
+{
+    /* The map is never fetched without the names. */
+    FAIL_UNLESS(keymap->num_types == old->num_types);
+    FAIL_UNLESS(keymap->min_key_code == old->min_key_code);
+    FAIL_UNLESS(keymap->max_key_code == old->max_key_code);
+
+    keymap->keycodes_section_name = strdup_safe(old->keycodes_section_name);
+    keymap->symbols_section_name = strdup_safe(old->symbols_section_name);
+    keymap->types_section_name = strdup_safe(old->types_section_name);
+    keymap->compat_section_name = strdup_safe(old->compat_section_name);
+    if ((old->keycodes_section_name && !keymap->keycodes_section_name) ||
+        (old->symbols_section_name && !keymap->symbols_section_name) ||
+        (old->types_section_name && !keymap->types_section_name) ||
+        (old->compat_section_name && !keymap->compat_section_name))
+        goto fail;
+
+    for (unsigned i = 0; i < keymap->num_types; i++) {
+        const struct xkb_key_type *old_type = &old->types[i];
+        struct xkb_key_type *type = &keymap->types[i];
+
+        type->name = old_type->name;
+        type->num_level_names = old_type->num_level_names;
+        ALLOC_OR_FAIL(type->level_names, type->num_level_names);
+        for (unsigned j = 0; j < type->num_level_names; j++)
+            type->level_names[j] = old_type->level_names[j];
+    }
+
+    for (unsigned i = 0; i < NUM_INDICATORS; i++)
+        keymap->leds[i].name = old->leds[i].name;
+
+    keymap->mods.num_mods = old->mods.num_mods;
+    for (unsigned i = NUM_REAL_MODS; i < NUM_REAL_MODS + NUM_VMODS; i++)
+        keymap->mods.mods[i].name = old->mods.mods[i].name;
+
+    keymap->num_group_names = old->num_group_names;
+    ALLOC_OR_FAIL(keymap->group_names, keymap->num_group_names);
+    for (xkb_layout_index_t i = 0; i < keymap->num_group_names; i++)
+        keymap->group_names[i] = old->group_names[i];
+
+    for (xkb_keycode_t kc = keymap->min_key_code; kc <= keymap->max_key_code; kc++)
+        keymap->keys[kc].name = old->keys[kc].name;
+
+    keymap->num_key_aliases = old->num_key_aliases;
+    ALLOC_OR_FAIL(keymap->key_aliases, keymap->num_key_aliases);
+    for (unsigned i = 0; i < keymap->num_key_aliases; i++)
+        keymap->key_aliases[i] = old->key_aliases[i];
+
+    return true;
+
+fail:
+    return false;
+}
+
+static bool
+copy_controls(struct xkb_keymap *keymap, const struct xkb_keymap *old)
+{
+    /* The map is never fetched without the controls. */
+    FAIL_UNLESS(keymap->min_key_code == old->min_key_code);
+    FAIL_UNLESS(keymap->max_key_code == old->max_key_code);
+
+    keymap->enabled_ctrls = old->enabled_ctrls;
+    keymap->num_groups = old->num_groups;
+
+    for (xkb_keycode_t kc = keymap->min_key_code; kc <= keymap->max_key_code; kc++)
+        keymap->keys[kc].repeats = old->keys[kc].repeats;
+
+    return true;
+
+fail:
+    return false;
+}
+
+/*
+ * Fill @keymap from the X server, fetching only the @changes parts and
+ * copying the rest from @old.
+ */
+static bool
+get_keymap(struct xkb_keymap *keymap, const struct xkb_keymap *old,
+           xcb_connection_t *conn, uint16_t device_id,
+           enum xkb_x11_keymap_changes changes)
+{
+    xcb_xkb_get_map_cookie_t map_cookie = { 0 };
+    xcb_xkb_get_indicator_map_cookie_t indicator_map_cookie = { 0 };
+    xcb_xkb_get_compat_map_cookie_t compat_map_cookie = { 0 };
+    xcb_xkb_get_names_cookie_t names_cookie = { 0 };
+    xcb_xkb_get_controls_cookie_t controls_cookie = { 0 };
+    struct x11_atom_interner interner;
+
+    /*
+     * The names refer to the types and keys by index, and the per-key
+     * repeat controls to the keys, so they must follow the map.
+     */
+    if (changes & XKB_X11_KEYMAP_CHANGED_MAP)
+        changes |= XKB_X11_KEYMAP_CHANGED_NAMES |
+                   XKB_X11_KEYMAP_CHANGED_CONTROLS;
+
+    /*
+     * Send all of the requests up front and only then wait for the
+     * replies, so that getting the keymap costs a single round trip,
+     * plus one for the atom names.
+     */
+    if (changes & XKB_X11_KEYMAP_CHANGED_MAP)
+        map_cookie = send_map_request(conn, device_id);
+    if (changes & XKB_X11_KEYMAP_CHANGED_INDICATOR_MAP)
+        indicator_map_cookie = send_indicator_map_request(conn, device_id);
+    if (changes & XKB_X11_KEYMAP_CHANGED_COMPAT_MAP)
+        compat_map_cookie = send_compat_map_request(conn, device_id);
+    if (changes & XKB_X11_KEYMAP_CHANGED_NAMES)
+        names_cookie = send_names_request(conn, device_id);
+    if (changes & XKB_X11_KEYMAP_CHANGED_CONTROLS)
+        controls_cookie = send_controls_request(conn, device_id);
+
+    x11_atom_interner_init(&interner, keymap->ctx, conn);
+
+    /*
+     * The replies which we don't get to after a failure must be
+     * discarded, or they would sit in the XCB queue forever.
+     */
+    if (changes & XKB_X11_KEYMAP_CHANGED_MAP ?
+        !get_map(keymap, conn, map_cookie) : !copy_map(keymap, old))
+        goto err_map;
+    if (changes & XKB_X11_KEYMAP_CHANGED_INDICATOR_MAP ?
+        !get_indicator_map(keymap, conn, indicator_map_cookie) :
+        !copy_indicator_map(keymap, old))
+        goto err_indicator_map;
+    if (changes & XKB_X11_KEYMAP_CHANGED_COMPAT_MAP ?
+        !get_compat_map(keymap, conn, compat_map_cookie) :
+        !copy_compat_map(keymap, old))
+        goto err_compat_map;
+    if (changes & XKB_X11_KEYMAP_CHANGED_NAMES ?
+        !get_names(keymap, &interner, names_cookie) :
+        !copy_names(keymap, old))
+        goto err_names;
+    if (changes & XKB_X11_KEYMAP_CHANGED_CONTROLS ?
+        !get_controls(keymap, conn, controls_cookie) :
+        !copy_controls(keymap, old))
+        goto err_controls;
+
+    x11_atom_interner_round_trip(&interner);
+    if (interner.had_error)
+        return false;
+
+    xkb_keymap_share_parts(keymap);
+    return true;
+
+err_map:
+    if (changes & XKB_X11_KEYMAP_CHANGED_INDICATOR_MAP)
+        xcb_discard_reply(conn, indicator_map_cookie.sequence);
+err_indicator_map:
+    if (changes & XKB_X11_KEYMAP_CHANGED_COMPAT_MAP)
+        xcb_discard_reply(conn, compat_map_cookie.sequence);
+err_compat_map:
+    if (changes & XKB_X11_KEYMAP_CHANGED_NAMES)
+        xcb_discard_reply(conn, names_cookie.sequence);
+err_names:
+    if (changes & XKB_X11_KEYMAP_CHANGED_CONTROLS)
+        xcb_discard_reply(conn, controls_cookie.sequence);
+err_controls:
+    /* Collect the atom names requested so far. */
+    x11_atom_interner_round_trip(&interner);
+    return false;
+}
+
+/*
+ * The key of the device's keymap in the keymap cache: the connection and
+ * device, the names of its components, as set by e.g. setxkbmap, and its
+ * keycode range. This is a single GetNames request; the atoms are usually
+ * in the atom cache.
+ *
+ * The connection is identified by its address and its resource ID base,
+ * which the server assigns per client. XKB has no serial for changes to
+ * the keymap, so edits which keep the names are not noticed.
+ */
+static char *
+get_cache_key(struct xkb_context *ctx, xcb_connection_t *conn,
+              uint16_t device_id)
+{
+    static const xcb_xkb_name_detail_t wanted =
+        (XCB_XKB_NAME_DETAIL_KEYCODES |
+         XCB_XKB_NAME_DETAIL_SYMBOLS |
+         XCB_XKB_NAME_DETAIL_TYPES |
+         XCB_XKB_NAME_DETAIL_COMPAT);
+
+    xcb_xkb_get_names_cookie_t cookie =
+        xcb_xkb_get_names(conn, device_id, wanted);
+    xcb_xkb_get_names_reply_t *reply =
+        xcb_xkb_get_names_reply(conn, cookie, NULL);
+    xcb_xkb_get_names_value_list_t list;
+    struct x11_atom_interner interner;
+    xkb_atom_t keycodes, symbols, types, compat;
+    char *key = NULL;
+
+    if (!reply)
+        return NULL;
+
+    xcb_xkb_get_names_value_list_unpack(xcb_xkb_get_names_value_list(reply),
+                                        reply->nTypes,
+                                        reply->indicators,
+                                        reply->virtualMods,
+                                        reply->groupNames,
+                                        reply->nKeys,
+                                        reply->nKeyAliases,
+                                        reply->nRadioGroups,
+                                        reply->which,
+                                        &list);
+
+    x11_atom_interner_init(&interner, ctx, conn);
+    x11_atom_interner_adopt_atom(&interner, list.keycodesName, &keycodes);
+    x11_atom_interner_adopt_atom(&interner, list.symbolsName, &symbols);
+    x11_atom_interner_adopt_atom(&interner, list.typesName, &types);
+    x11_atom_interner_adopt_atom(&interner, list.compatName, &compat);
+    x11_atom_interner_round_trip(&interner);
+
+    /* Without any names, there is nothing to tell the keymaps apart. */
+    if (!interner.had_error &&
+        (keycodes || symbols || types || compat))
+        key = asprintf_safe("x11:%p:%" PRIu32 ":%u:%u:%u:%u:%u:%u:%u",
+                            (void *) conn,
+                            xcb_get_setup(conn)->resource_id_base,
+                            reply->deviceID,
+                            keycodes, symbols, types, compat,
+                            reply->minKeyCode, reply->maxKeyCode);
+
+    free(reply);
+    return key;
+}
+
 XKB_EXPORT struct xkb_keymap *
 xkb_x11_keymap_new_from_device(struct xkb_context *ctx,
                                xcb_connection_t *conn,
@@ -1154,8 +1524,9 @@ xkb_x11_keymap_new_from_device(struct xkb_context *ctx,
 {
     struct xkb_keymap *keymap;
     const enum xkb_keymap_format format = XKB_KEYMAP_FORMAT_TEXT_V1;
+    char *cache_key = NULL;
 
-    if (flags & ~(XKB_KEYMAP_COMPILE_NO_FLAGS)) {
+    if (flags & ~(XKB_KEYMAP_COMPILE_USE_CACHE)) {
         log_err_func(ctx, "unrecognized flags: %#x\n", flags);
         return NULL;
     }
@@ -1165,15 +1536,66 @@ xkb_x11_keymap_new_from_device(struct xkb_context *ctx,
         return NULL;
     }
 
+    if (flags & XKB_KEYMAP_COMPILE_USE_CACHE) {
+        cache_key = get_cache_key(ctx, conn, device_id);
+        if (cache_key) {
+            keymap = xkb_keymap_cache_lookup(ctx, cache_key);
+            if (keymap) {
+                free(cache_key);
+                return keymap;
+            }
+        }
+    }
+
     keymap = xkb_keymap_new(ctx, format, flags);
+    if (!keymap) {
+        free(cache_key);
+        return NULL;
+    }
+
+    if (!get_keymap(keymap, NULL, conn, device_id, ALL_CHANGES)) {
+        free(cache_key);
+        xkb_keymap_unref(keymap);
+        return NULL;
+    }
+
+    if (flags & XKB_KEYMAP_COMPILE_USE_CACHE)
+        keymap = xkb_keymap_cache_dedup(keymap);
+
+    if (cache_key)
+        xkb_keymap_cache_add(keymap, cache_key);
+
+    free(cache_key);
+    return keymap;
+}
+
+XKB_EXPORT struct xkb_keymap *
+xkb_x11_keymap_new_from_changes(struct xkb_keymap *old,
+                                xcb_connection_t *conn,
+                                int32_t device_id,
+                                enum xkb_x11_keymap_changes changes)
+{
+    struct xkb_keymap *keymap;
+
+    if (changes & ~ALL_CHANGES) {
+        log_err_func(old->ctx, "unrecognized changes: %#x\n", changes);
+        return NULL;
+    }
+
+    if (device_id < 0 || device_id > 127) {
+        log_err_func(old->ctx, "illegal device ID: %d\n", device_id);
+        return NULL;
+    }
+
+    /* Nothing changed; the keymap is immutable anyway. */
+    if (changes == 0)
+        return xkb_keymap_ref(old);
+
+    keymap = xkb_keymap_new(old->ctx, old->format, old->flags);
     if (!keymap)
         return NULL;
 
-    if (!get_map(keymap, conn, device_id) ||
-        !get_indicator_map(keymap, conn, device_id) ||
-        !get_compat_map(keymap, conn, device_id) ||
-        !get_names(keymap, conn, device_id) ||
-        !get_controls(keymap, conn, device_id)) {
+    if (!get_keymap(keymap, old, conn, device_id, changes)) {
         xkb_keymap_unref(keymap);
         return NULL;
     }
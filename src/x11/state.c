@@ -27,10 +27,8 @@
 
 static bool
 update_initial_state(struct xkb_state *state, xcb_connection_t *conn,
-                     uint16_t device_id)
+                     xcb_xkb_get_state_cookie_t cookie)
 {
-    xcb_xkb_get_state_cookie_t cookie =
-        xcb_xkb_get_state(conn, device_id);
     xcb_xkb_get_state_reply_t *reply =
         xcb_xkb_get_state_reply(conn, cookie, NULL);
 
@@ -53,6 +51,7 @@ XKB_EXPORT struct xkb_state *
 xkb_x11_state_new_from_device(struct xkb_keymap *keymap,
                               xcb_connection_t *conn, int32_t device_id)
 {
+    xcb_xkb_get_state_cookie_t cookie;
     struct xkb_state *state;
 
     if (device_id < 0 || device_id > 255) {
@@ -60,11 +59,16 @@ xkb_x11_state_new_from_device(struct xkb_keymap *keymap,
         return NULL;
     }
 
+    /* Let the server work on the request while we set up the state. */
+    cookie = xcb_xkb_get_state(conn, device_id);
+
     state = xkb_state_new(keymap);
-    if (!state)
+    if (!state) {
+        xcb_discard_reply(conn, cookie.sequence);
         return NULL;
+    }
 
-    if (!update_initial_state(state, conn, device_id)) {
+    if (!update_initial_state(state, conn, cookie)) {
         xkb_state_unref(state);
         return NULL;
     }
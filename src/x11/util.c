@@ -124,141 +124,251 @@ xkb_x11_get_core_keyboard_device_id(xcb_connection_t *conn)
     return device_id;
 }
 
-bool
-get_atom_name(xcb_connection_t *conn, xcb_atom_t atom, char **out)
+/*
+ * A hash table from X atoms to xkb_atom_t's, kept on the context for its
+ * lifetime, so that re-fetching a keymap mostly doesn't need any
+ * GetAtomName requests.
+ *
+ * X11 atoms are actually not per connection or client, but per X server
+ * session. But better be safe just in case we survive an X server restart
+ * or the context is used with several servers, and key the entries by the
+ * XCB connection as well.
+ *
+ * The table is a single allocation, since the context just free()s it.
+ */
+struct x11_atom_cache {
+    /* Power of 2. */
+    size_t size;
+    size_t count;
+    struct x11_atom_cache_entry {
+        xcb_connection_t *conn;
+        /* XCB_ATOM_NONE for an empty slot. */
+        xcb_atom_t from;
+        xkb_atom_t to;
+    } entries[];
+};
+
+static size_t
+cache_slot(const struct x11_atom_cache *cache, xcb_connection_t *conn,
+           xcb_atom_t atom)
 {
-    xcb_get_atom_name_cookie_t cookie;
-    xcb_get_atom_name_reply_t *reply;
-    int length;
-    char *name;
+    const size_t mask = cache->size - 1;
+    uint32_t hash = atom * 2654435761u ^ (uint32_t) ((uintptr_t) conn >> 4);
+    size_t i = hash & mask;
 
-    if (atom == 0) {
-        *out = NULL;
-        return true;
-    }
+    while (cache->entries[i].from != XCB_ATOM_NONE &&
+           (cache->entries[i].from != atom || cache->entries[i].conn != conn))
+        i = (i + 1) & mask;
 
-    cookie = xcb_get_atom_name(conn, atom);
-    reply = xcb_get_atom_name_reply(conn, cookie, NULL);
-    if (!reply)
-        return false;
+    return i;
+}
+
+static bool
+cache_lookup(struct xkb_context *ctx, xcb_connection_t *conn,
+             xcb_atom_t atom, xkb_atom_t *out)
+{
+    const struct x11_atom_cache *cache = ctx->x11_atom_cache;
 
-    length = xcb_get_atom_name_name_length(reply);
-    name = xcb_get_atom_name_name(reply);
+    if (!cache)
+        return false;
 
-    *out = strndup(name, length);
-    if (!*out) {
-        free(reply);
+    const struct x11_atom_cache_entry *entry =
+        &cache->entries[cache_slot(cache, conn, atom)];
+    if (entry->from == XCB_ATOM_NONE)
         return false;
-    }
 
-    free(reply);
+    *out = entry->to;
     return true;
 }
 
-struct x11_atom_cache {
-    /*
-     * Invalidate the cache based on the XCB connection.
-     * X11 atoms are actually not per connection or client, but per X server
-     * session. But better be safe just in case we survive an X server restart.
-     */
-    xcb_connection_t *conn;
-    struct {
-        xcb_atom_t from;
-        xkb_atom_t to;
-    } cache[256];
-    size_t len;
-};
-
-bool
-adopt_atoms(struct xkb_context *ctx, xcb_connection_t *conn,
-            const xcb_atom_t *from, xkb_atom_t *to, const size_t count)
+static void
+cache_insert(struct xkb_context *ctx, xcb_connection_t *conn,
+             xcb_atom_t atom, xkb_atom_t to)
 {
-    enum { SIZE = 128 };
-    xcb_get_atom_name_cookie_t cookies[SIZE];
-    const size_t num_batches = ROUNDUP(count, SIZE) / SIZE;
-
-    if (!ctx->x11_atom_cache) {
-        ctx->x11_atom_cache = calloc(1, sizeof(struct x11_atom_cache));
-    }
-    /* Can be NULL in case the malloc failed. */
     struct x11_atom_cache *cache = ctx->x11_atom_cache;
-    if (cache && cache->conn != conn) {
-        cache->conn = conn;
-        cache->len = 0;
-    }
-
-    memset(to, 0, count * sizeof(*to));
-
-    /* Send and collect the atoms in batches of reasonable SIZE. */
-    for (size_t batch = 0; batch < num_batches; batch++) {
-        const size_t start = batch * SIZE;
-        const size_t stop = MIN((batch + 1) * SIZE, count);
-
-        /* Send. */
-        for (size_t i = start; i < stop; i++) {
-            bool cache_hit = false;
-            if (cache) {
-                for (size_t c = 0; c < cache->len; c++) {
-                    if (cache->cache[c].from == from[i]) {
-                        to[i] = cache->cache[c].to;
-                        cache_hit = true;
-                        break;
-                    }
-                }
+    size_t i;
+
+    /* Keep the load factor under 1/2, growing as needed. */
+    if (!cache || 2 * (cache->count + 1) > cache->size) {
+        const size_t size = cache ? 2 * cache->size : 256;
+        struct x11_atom_cache *grown =
+            calloc(1, sizeof(*grown) + size * sizeof(grown->entries[0]));
+
+        /* The cache is best effort; just don't insert. */
+        if (!grown)
+            return;
+
+        grown->size = size;
+        if (cache) {
+            for (size_t j = 0; j < cache->size; j++) {
+                const struct x11_atom_cache_entry *entry = &cache->entries[j];
+                if (entry->from == XCB_ATOM_NONE)
+                    continue;
+                grown->entries[cache_slot(grown, entry->conn, entry->from)] =
+                    *entry;
             }
-            if (!cache_hit && from[i] != XCB_ATOM_NONE)
-                cookies[i % SIZE] = xcb_get_atom_name(conn, from[i]);
+            grown->count = cache->count;
+            free(cache);
         }
+        ctx->x11_atom_cache = cache = grown;
+    }
 
-        /* Collect. */
-        for (size_t i = start; i < stop; i++) {
-            xcb_get_atom_name_reply_t *reply;
+    i = cache_slot(cache, conn, atom);
+    if (cache->entries[i].from == XCB_ATOM_NONE)
+        cache->count++;
+    cache->entries[i].conn = conn;
+    cache->entries[i].from = atom;
+    cache->entries[i].to = to;
+}
 
-            if (from[i] == XCB_ATOM_NONE)
-                continue;
+void
+x11_atom_interner_init(struct x11_atom_interner *interner,
+                       struct xkb_context *ctx, xcb_connection_t *conn)
+{
+    interner->had_error = false;
+    interner->ctx = ctx;
+    interner->conn = conn;
+    interner->num_pending = 0;
+    interner->num_copies = 0;
+    interner->num_escaped = 0;
+}
 
-            /* Was filled from cache. */
-            if (to[i] != 0)
-                continue;
+void
+x11_atom_interner_adopt_atom(struct x11_atom_interner *interner,
+                             const xcb_atom_t atom, xkb_atom_t *out)
+{
+    *out = XKB_ATOM_NONE;
 
-            reply = xcb_get_atom_name_reply(conn, cookies[i % SIZE], NULL);
-            if (!reply)
-                goto err_discard;
+    if (atom == XCB_ATOM_NONE)
+        return;
 
-            to[i] = xkb_atom_intern(ctx,
-                                    xcb_get_atom_name_name(reply),
-                                    xcb_get_atom_name_name_length(reply));
-            free(reply);
+retry:
 
-            if (to[i] == XKB_ATOM_NONE)
-                goto err_discard;
+    /* Already in the cache? */
+    if (cache_lookup(interner->ctx, interner->conn, atom, out))
+        return;
 
-            if (cache && cache->len < ARRAY_SIZE(cache->cache)) {
-                size_t idx = cache->len++;
-                cache->cache[idx].from = from[i];
-                cache->cache[idx].to = to[i];
+    /* Already pending? */
+    for (size_t i = 0; i < interner->num_pending; i++) {
+        if (interner->pending[i].from == atom) {
+            if (interner->num_copies == ARRAY_SIZE(interner->copies)) {
+                x11_atom_interner_round_trip(interner);
+                goto retry;
             }
 
-            continue;
-
-            /*
-             * If we don't discard the uncollected replies, they just
-             * sit in the XCB queue waiting forever. Sad.
-             */
-err_discard:
-            for (size_t j = i + 1; j < stop; j++)
-                if (from[j] != XCB_ATOM_NONE)
-                    xcb_discard_reply(conn, cookies[j % SIZE].sequence);
-            return false;
+            size_t idx = interner->num_copies++;
+            interner->copies[idx].from = atom;
+            interner->copies[idx].out = out;
+            return;
         }
     }
 
-    return true;
+    /* We have to send a GetAtomName request. */
+    /* The round trip empties the pending list. */
+    if (interner->num_pending == ARRAY_SIZE(interner->pending))
+        x11_atom_interner_round_trip(interner);
+    size_t idx = interner->num_pending++;
+    interner->pending[idx].from = atom;
+    interner->pending[idx].out = out;
+    interner->pending[idx].cookie = xcb_get_atom_name(interner->conn, atom);
 }
 
-bool
-adopt_atom(struct xkb_context *ctx, xcb_connection_t *conn, xcb_atom_t atom,
-           xkb_atom_t *out)
+void
+x11_atom_interner_adopt_atoms(struct x11_atom_interner *interner,
+                              const xcb_atom_t *from, xkb_atom_t *to,
+                              size_t count)
 {
-    return adopt_atoms(ctx, conn, &atom, out, 1);
+    for (size_t i = 0; i < count; i++) {
+        x11_atom_interner_adopt_atom(interner, from[i], &to[i]);
+    }
+}
+
+void
+x11_atom_interner_get_escaped_atom_name(struct x11_atom_interner *interner,
+                                        xcb_atom_t atom, char **out)
+{
+    if (atom == 0) {
+        *out = NULL;
+        return;
+    }
+    /* There can only be a fixed number of calls to this function. */
+    if (interner->num_escaped == ARRAY_SIZE(interner->escaped)) {
+        log_err_func1(interner->ctx, "too many escaped atom names requested\n");
+        interner->had_error = true;
+        *out = NULL;
+        return;
+    }
+    size_t idx = interner->num_escaped++;
+    interner->escaped[idx].out = out;
+    interner->escaped[idx].cookie = xcb_get_atom_name(interner->conn, atom);
+}
+
+void
+x11_atom_interner_round_trip(struct x11_atom_interner *interner)
+{
+    struct xkb_context *ctx = interner->ctx;
+    xcb_connection_t *conn = interner->conn;
+
+    /*
+     * Every reply is collected, even after an error; if we don't, they
+     * just sit in the XCB queue waiting forever. Sad.
+     */
+    for (size_t i = 0; i < interner->num_pending; i++) {
+        xcb_get_atom_name_reply_t *reply;
+
+        reply = xcb_get_atom_name_reply(conn, interner->pending[i].cookie, NULL);
+        if (!reply) {
+            interner->had_error = true;
+            continue;
+        }
+        xcb_atom_t x11_atom = interner->pending[i].from;
+        xkb_atom_t atom = xkb_atom_intern(ctx,
+                                          xcb_get_atom_name_name(reply),
+                                          xcb_get_atom_name_name_length(reply));
+        free(reply);
+
+        if (atom == XKB_ATOM_NONE) {
+            interner->had_error = true;
+            continue;
+        }
+
+        cache_insert(ctx, conn, x11_atom, atom);
+
+        *interner->pending[i].out = atom;
+
+        for (size_t j = 0; j < interner->num_copies; j++) {
+            if (interner->copies[j].from == x11_atom)
+                *interner->copies[j].out = atom;
+        }
+    }
+
+    for (size_t i = 0; i < interner->num_escaped; i++) {
+        xcb_get_atom_name_reply_t *reply;
+        char **out = interner->escaped[i].out;
+        int length;
+        char *name;
+
+        reply = xcb_get_atom_name_reply(conn, interner->escaped[i].cookie, NULL);
+        *out = NULL;
+        if (!reply) {
+            interner->had_error = true;
+            continue;
+        }
+
+        length = xcb_get_atom_name_name_length(reply);
+        name = xcb_get_atom_name_name(reply);
+
+        *out = strndup(name, length);
+        free(reply);
+        if (!*out) {
+            interner->had_error = true;
+            continue;
+        }
+
+        XkbEscapeMapName(*out);
+    }
+
+    interner->num_pending = 0;
+    interner->num_copies = 0;
+    interner->num_escaped = 0;
 }
@@ -54,74 +54,215 @@
 #include "xkbcomp-priv.h"
 #include "text.h"
 
-#define BUF_CHUNK_SIZE 4096
-
 struct buf {
     char *buf;
     size_t size;
     size_t alloc;
 };
 
+/* Make room for @len more bytes, and the terminating NUL. */
 static bool
-do_realloc(struct buf *buf, size_t at_least)
+buf_reserve(struct buf *buf, size_t len)
 {
+    size_t alloc;
     char *new;
 
-    buf->alloc += BUF_CHUNK_SIZE;
-    if (at_least >= BUF_CHUNK_SIZE)
-        buf->alloc += at_least;
+    if (buf->size + len < buf->alloc)
+        return true;
 
-    new = realloc(buf->buf, buf->alloc);
+    alloc = MAX(2 * buf->alloc, buf->size + len + 1);
+    new = realloc(buf->buf, alloc);
     if (!new)
         return false;
 
     buf->buf = new;
+    buf->alloc = alloc;
     return true;
 }
 
-ATTR_PRINTF(2, 3) static bool
-check_write_buf(struct buf *buf, const char *fmt, ...)
+static bool
+buf_append(struct buf *buf, const char *str, size_t len)
 {
-    va_list args;
-    int printed;
-    size_t available;
+    if (!buf_reserve(buf, len))
+        return false;
+
+    memcpy(buf->buf + buf->size, str, len);
+    buf->size += len;
+    return true;
+}
 
-    available = buf->alloc - buf->size;
-    va_start(args, fmt);
-    printed = vsnprintf(buf->buf + buf->size, available, fmt, args);
-    va_end(args);
+/* Append @str, padded with spaces to @width; on the left if @right. */
+static bool
+buf_append_padded(struct buf *buf, const char *str, size_t width, bool right)
+{
+    size_t len = strlen(str);
+    size_t pad = len < width ? width - len : 0;
 
-    if (printed < 0)
-        goto err;
+    if (!buf_reserve(buf, len + pad))
+        return false;
 
-    if ((size_t) printed >= available)
-        if (!do_realloc(buf, printed))
-            goto err;
+    if (right) {
+        memset(buf->buf + buf->size, ' ', pad);
+        buf->size += pad;
+    }
+    memcpy(buf->buf + buf->size, str, len);
+    buf->size += len;
+    if (!right) {
+        memset(buf->buf + buf->size, ' ', pad);
+        buf->size += pad;
+    }
+    return true;
+}
 
-    /* The buffer has enough space now. */
+static bool
+buf_append_uint(struct buf *buf, unsigned int value)
+{
+    char digits[16];
+    size_t pos = sizeof(digits);
 
-    available = buf->alloc - buf->size;
-    va_start(args, fmt);
-    printed = vsnprintf(buf->buf + buf->size, available, fmt, args);
-    va_end(args);
+    do {
+        digits[--pos] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
 
-    if (printed < 0 || (size_t) printed >= available)
-        goto err;
+    return buf_append(buf, digits + pos, sizeof(digits) - pos);
+}
 
-    buf->size += printed;
-    return true;
+static bool
+buf_append_int(struct buf *buf, int value)
+{
+    if (value < 0) {
+        if (!buf_append(buf, "-", 1))
+            return false;
+        /* Avoid overflowing on INT_MIN. */
+        return buf_append_uint(buf, 0u - (unsigned int) value);
+    }
 
-err:
-    free(buf->buf);
-    buf->buf = NULL;
-    return false;
+    return buf_append_uint(buf, value);
+}
+
+/* As with "0x%02x". */
+static bool
+buf_append_hex(struct buf *buf, unsigned int value)
+{
+    static const char hex[] = "0123456789abcdef";
+    char digits[16];
+    size_t pos = sizeof(digits);
+
+    do {
+        digits[--pos] = hex[value % 16];
+        value /= 16;
+    } while (value > 0 || pos > sizeof(digits) - 2);
+    digits[--pos] = 'x';
+    digits[--pos] = '0';
+
+    return buf_append(buf, digits + pos, sizeof(digits) - pos);
 }
 
-#define write_buf(buf, ...) do { \
-    if (!check_write_buf(buf, __VA_ARGS__)) \
+/*
+ * The writing helpers return false from the calling function if the
+ * allocation fails.
+ */
+
+/* A string literal. */
+#define write_lit(buf, lit) do { \
+    if (!buf_append(buf, lit, sizeof(lit) - 1)) \
+        return false; \
+} while (0)
+
+#define write_str(buf, str) do { \
+    const char *str_ = strnull(str); \
+    if (!buf_append(buf, str_, strlen(str_))) \
+        return false; \
+} while (0)
+
+#define write_padded(buf, str, width, right) do { \
+    if (!buf_append_padded(buf, strnull(str), width, right)) \
+        return false; \
+} while (0)
+
+#define write_uint(buf, value) do { \
+    if (!buf_append_uint(buf, value)) \
+        return false; \
+} while (0)
+
+#define write_int(buf, value) do { \
+    if (!buf_append_int(buf, value)) \
         return false; \
 } while (0)
 
+#define write_hex(buf, value) do { \
+    if (!buf_append_hex(buf, value)) \
+        return false; \
+} while (0)
+
+#define write_atom(buf, keymap, atom) \
+    write_str(buf, xkb_atom_text((keymap)->ctx, atom))
+
+/* As with ModMaskText(), without the intermediate buffer. */
+static bool
+write_mod_mask(struct xkb_keymap *keymap, struct buf *buf,
+               xkb_mod_mask_t mask)
+{
+    xkb_mod_index_t i;
+    const struct xkb_mod *mod;
+    bool first = true;
+
+    if (mask == 0) {
+        write_lit(buf, "none");
+        return true;
+    }
+
+    if (mask == MOD_REAL_MASK_ALL) {
+        write_lit(buf, "all");
+        return true;
+    }
+
+    xkb_mods_enumerate(i, mod, &keymap->mods) {
+        if (!(mask & (1u << i)))
+            continue;
+
+        if (!first)
+            write_lit(buf, "+");
+        write_atom(buf, keymap, mod->name);
+        first = false;
+    }
+
+    return true;
+}
+
+/* As with KeyNameText(), padded to @width. */
+static bool
+write_key_name(struct xkb_keymap *keymap, struct buf *buf, xkb_atom_t name,
+               size_t width)
+{
+    const char *sname = strempty(xkb_atom_text(keymap->ctx, name));
+    size_t len = strlen(sname) + 2;
+
+    write_lit(buf, "<");
+    write_str(buf, sname);
+    write_lit(buf, ">");
+    if (len < width) {
+        if (!buf_reserve(buf, width - len))
+            return false;
+        memset(buf->buf + buf->size, ' ', width - len);
+        buf->size += width - len;
+    }
+
+    return true;
+}
+
+/* As with KeysymText(), without the context buffer. */
+static bool
+write_keysym(struct buf *buf, xkb_keysym_t sym, size_t width)
+{
+    char name[64];
+
+    xkb_keysym_get_name(sym, name, sizeof(name));
+    write_padded(buf, name, width, true);
+    return true;
+}
+
 static bool
 write_vmods(struct xkb_keymap *keymap, struct buf *buf)
 {
@@ -133,15 +274,15 @@ write_vmods(struct xkb_keymap *keymap, struct buf *buf)
             continue;
 
         if (num_vmods == 0)
-            write_buf(buf, "\tvirtual_modifiers ");
+            write_lit(buf, "\tvirtual_modifiers ");
         else
-            write_buf(buf, ",");
-        write_buf(buf, "%s", xkb_atom_text(keymap->ctx, mod->name));
+            write_lit(buf, ",");
+        write_atom(buf, keymap, mod->name);
         num_vmods++;
     }
 
     if (num_vmods > 0)
-        write_buf(buf, ";\n\n");
+        write_lit(buf, ";\n\n");
 
     return true;
 }
@@ -153,64 +294,87 @@ write_keycodes(struct xkb_keymap *keymap, struct buf *buf)
     xkb_led_index_t idx;
     const struct xkb_led *led;
 
-    if (keymap->keycodes_section_name)
-        write_buf(buf, "xkb_keycodes \"%s\" {\n",
-                  keymap->keycodes_section_name);
-    else
-        write_buf(buf, "xkb_keycodes {\n");
+    if (keymap->keycodes_section_name) {
+        write_lit(buf, "xkb_keycodes \"");
+        write_str(buf, keymap->keycodes_section_name);
+        write_lit(buf, "\" {\n");
+    }
+    else {
+        write_lit(buf, "xkb_keycodes {\n");
+    }
 
     /* xkbcomp and X11 really want to see keymaps with a minimum of 8, and
      * a maximum of at least 255, else XWayland really starts hating life.
      * If this is a problem and people really need strictly bounded keymaps,
      * we should probably control this with a flag. */
-    write_buf(buf, "\tminimum = %u;\n", MIN(keymap->min_key_code, 8));
-    write_buf(buf, "\tmaximum = %u;\n", MAX(keymap->max_key_code, 255));
+    write_lit(buf, "\tminimum = ");
+    write_uint(buf, MIN(keymap->min_key_code, 8));
+    write_lit(buf, ";\n\tmaximum = ");
+    write_uint(buf, MAX(keymap->max_key_code, 255));
+    write_lit(buf, ";\n");
 
     xkb_keys_foreach(key, keymap) {
         if (key->name == XKB_ATOM_NONE)
             continue;
 
-        write_buf(buf, "\t%-20s = %u;\n",
-                  KeyNameText(keymap->ctx, key->name), key->keycode);
+        write_lit(buf, "\t");
+        if (!write_key_name(keymap, buf, key->name, 20))
+            return false;
+        write_lit(buf, " = ");
+        write_uint(buf, key->keycode);
+        write_lit(buf, ";\n");
     }
 
-    xkb_leds_enumerate(idx, led, keymap)
-        if (led->name != XKB_ATOM_NONE)
-            write_buf(buf, "\tindicator %u = \"%s\";\n",
-                      idx + 1, xkb_atom_text(keymap->ctx, led->name));
-
+    xkb_leds_enumerate(idx, led, keymap) {
+        if (led->name != XKB_ATOM_NONE) {
+            write_lit(buf, "\tindicator ");
+            write_uint(buf, idx + 1);
+            write_lit(buf, " = \"");
+            write_atom(buf, keymap, led->name);
+            write_lit(buf, "\";\n");
+        }
+    }
 
-    for (unsigned i = 0; i < keymap->num_key_aliases; i++)
-        write_buf(buf, "\talias %-14s = %s;\n",
-                  KeyNameText(keymap->ctx, keymap->key_aliases[i].alias),
-                  KeyNameText(keymap->ctx, keymap->key_aliases[i].real));
+    for (unsigned i = 0; i < keymap->num_key_aliases; i++) {
+        write_lit(buf, "\talias ");
+        if (!write_key_name(keymap, buf, keymap->key_aliases[i].alias, 14))
+            return false;
+        write_lit(buf, " = ");
+        if (!write_key_name(keymap, buf, keymap->key_aliases[i].real, 0))
+            return false;
+        write_lit(buf, ";\n");
+    }
 
-    write_buf(buf, "};\n\n");
+    write_lit(buf, "};\n\n");
     return true;
 }
 
 static bool
 write_types(struct xkb_keymap *keymap, struct buf *buf)
 {
-    if (keymap->types_section_name)
-        write_buf(buf, "xkb_types \"%s\" {\n",
-                  keymap->types_section_name);
-    else
-        write_buf(buf, "xkb_types {\n");
+    if (keymap->types_section_name) {
+        write_lit(buf, "xkb_types \"");
+        write_str(buf, keymap->types_section_name);
+        write_lit(buf, "\" {\n");
+    }
+    else {
+        write_lit(buf, "xkb_types {\n");
+    }
 
-    write_vmods(keymap, buf);
+    if (!write_vmods(keymap, buf))
+        return false;
 
     for (unsigned i = 0; i < keymap->num_types; i++) {
         const struct xkb_key_type *type = &keymap->types[i];
 
-        write_buf(buf, "\ttype \"%s\" {\n",
-                  xkb_atom_text(keymap->ctx, type->name));
-
-        write_buf(buf, "\t\tmodifiers= %s;\n",
-                  ModMaskText(keymap->ctx, &keymap->mods, type->mods.mods));
+        write_lit(buf, "\ttype \"");
+        write_atom(buf, keymap, type->name);
+        write_lit(buf, "\" {\n\t\tmodifiers= ");
+        if (!write_mod_mask(keymap, buf, type->mods.mods))
+            return false;
+        write_lit(buf, ";\n");
 
         for (unsigned j = 0; j < type->num_entries; j++) {
-            const char *str;
             const struct xkb_key_type_entry *entry = &type->entries[j];
 
             /*
@@ -220,25 +384,38 @@ write_types(struct xkb_keymap *keymap, struct buf *buf)
             if (entry->level == 0 && entry->preserve.mods == 0)
                 continue;
 
-            str = ModMaskText(keymap->ctx, &keymap->mods, entry->mods.mods);
-            write_buf(buf, "\t\tmap[%s]= %u;\n",
-                      str, entry->level + 1);
-
-            if (entry->preserve.mods)
-                write_buf(buf, "\t\tpreserve[%s]= %s;\n",
-                          str, ModMaskText(keymap->ctx, &keymap->mods,
-                                           entry->preserve.mods));
+            write_lit(buf, "\t\tmap[");
+            if (!write_mod_mask(keymap, buf, entry->mods.mods))
+                return false;
+            write_lit(buf, "]= ");
+            write_uint(buf, entry->level + 1);
+            write_lit(buf, ";\n");
+
+            if (entry->preserve.mods) {
+                write_lit(buf, "\t\tpreserve[");
+                if (!write_mod_mask(keymap, buf, entry->mods.mods))
+                    return false;
+                write_lit(buf, "]= ");
+                if (!write_mod_mask(keymap, buf, entry->preserve.mods))
+                    return false;
+                write_lit(buf, ";\n");
+            }
         }
 
-        for (xkb_level_index_t n = 0; n < type->num_level_names; n++)
-            if (type->level_names[n])
-                write_buf(buf, "\t\tlevel_name[%u]= \"%s\";\n", n + 1,
-                          xkb_atom_text(keymap->ctx, type->level_names[n]));
+        for (xkb_level_index_t n = 0; n < type->num_level_names; n++) {
+            if (type->level_names[n]) {
+                write_lit(buf, "\t\tlevel_name[");
+                write_uint(buf, n + 1);
+                write_lit(buf, "]= \"");
+                write_atom(buf, keymap, type->level_names[n]);
+                write_lit(buf, "\";\n");
+            }
+        }
 
-        write_buf(buf, "\t};\n");
+        write_lit(buf, "\t};\n");
     }
 
-    write_buf(buf, "};\n\n");
+    write_lit(buf, "};\n\n");
     return true;
 }
 
@@ -246,33 +423,40 @@ static bool
 write_led_map(struct xkb_keymap *keymap, struct buf *buf,
               const struct xkb_led *led)
 {
-    write_buf(buf, "\tindicator \"%s\" {\n",
-              xkb_atom_text(keymap->ctx, led->name));
+    write_lit(buf, "\tindicator \"");
+    write_atom(buf, keymap, led->name);
+    write_lit(buf, "\" {\n");
 
     if (led->which_groups) {
         if (led->which_groups != XKB_STATE_LAYOUT_EFFECTIVE) {
-            write_buf(buf, "\t\twhichGroupState= %s;\n",
-                      LedStateMaskText(keymap->ctx, led->which_groups));
+            write_lit(buf, "\t\twhichGroupState= ");
+            write_str(buf, LedStateMaskText(keymap->ctx, led->which_groups));
+            write_lit(buf, ";\n");
         }
-        write_buf(buf, "\t\tgroups= 0x%02x;\n",
-                  led->groups);
+        write_lit(buf, "\t\tgroups= ");
+        write_hex(buf, led->groups);
+        write_lit(buf, ";\n");
     }
 
     if (led->which_mods) {
         if (led->which_mods != XKB_STATE_MODS_EFFECTIVE) {
-            write_buf(buf, "\t\twhichModState= %s;\n",
-                      LedStateMaskText(keymap->ctx, led->which_mods));
+            write_lit(buf, "\t\twhichModState= ");
+            write_str(buf, LedStateMaskText(keymap->ctx, led->which_mods));
+            write_lit(buf, ";\n");
         }
-        write_buf(buf, "\t\tmodifiers= %s;\n",
-                  ModMaskText(keymap->ctx, &keymap->mods, led->mods.mods));
+        write_lit(buf, "\t\tmodifiers= ");
+        if (!write_mod_mask(keymap, buf, led->mods.mods))
+            return false;
+        write_lit(buf, ";\n");
     }
 
     if (led->ctrls) {
-        write_buf(buf, "\t\tcontrols= %s;\n",
-                  ControlMaskText(keymap->ctx, led->ctrls));
+        write_lit(buf, "\t\tcontrols= ");
+        write_str(buf, ControlMaskText(keymap->ctx, led->ctrls));
+        write_lit(buf, ";\n");
     }
 
-    write_buf(buf, "\t};\n");
+    write_lit(buf, "\t};\n");
     return true;
 }
 
@@ -292,117 +476,153 @@ affect_lock_text(enum xkb_action_flags flags, bool show_both)
     return "";
 }
 
+/* A relative value is written with an explicit sign. */
+static bool
+write_signed(struct buf *buf, int value, bool absolute, bool plus_zero)
+{
+    if (!absolute && (value > 0 || (plus_zero && value == 0)))
+        write_lit(buf, "+");
+    write_int(buf, value);
+    return true;
+}
+
 static bool
 write_action(struct xkb_keymap *keymap, struct buf *buf,
              const union xkb_action *action,
              const char *prefix, const char *suffix)
 {
-    const char *type;
     const char *args = NULL;
 
-    if (!prefix)
-        prefix = "";
-    if (!suffix)
-        suffix = "";
+    if (prefix)
+        write_str(buf, prefix);
 
-    type = ActionTypeText(action->type);
+    if (action->type == ACTION_TYPE_NONE)
+        write_lit(buf, "NoAction");
+    else
+        write_str(buf, ActionTypeText(action->type));
 
     switch (action->type) {
     case ACTION_TYPE_MOD_SET:
     case ACTION_TYPE_MOD_LATCH:
     case ACTION_TYPE_MOD_LOCK:
+        write_lit(buf, "(modifiers=");
         if (action->mods.flags & ACTION_MODS_LOOKUP_MODMAP)
-            args = "modMapMods";
-        else
-            args = ModMaskText(keymap->ctx, &keymap->mods,
-                               action->mods.mods.mods);
-        write_buf(buf, "%s%s(modifiers=%s%s%s%s)%s", prefix, type, args,
-                  (action->type != ACTION_TYPE_MOD_LOCK && (action->mods.flags & ACTION_LOCK_CLEAR)) ? ",clearLocks" : "",
-                  (action->type != ACTION_TYPE_MOD_LOCK && (action->mods.flags & ACTION_LATCH_TO_LOCK)) ? ",latchToLock" : "",
-                  (action->type == ACTION_TYPE_MOD_LOCK) ? affect_lock_text(action->mods.flags, false) : "",
-                  suffix);
+            write_lit(buf, "modMapMods");
+        else if (!write_mod_mask(keymap, buf, action->mods.mods.mods))
+            return false;
+        if (action->type != ACTION_TYPE_MOD_LOCK) {
+            if (action->mods.flags & ACTION_LOCK_CLEAR)
+                write_lit(buf, ",clearLocks");
+            if (action->mods.flags & ACTION_LATCH_TO_LOCK)
+                write_lit(buf, ",latchToLock");
+        }
+        else {
+            write_str(buf, affect_lock_text(action->mods.flags, false));
+        }
+        write_lit(buf, ")");
         break;
 
     case ACTION_TYPE_GROUP_SET:
     case ACTION_TYPE_GROUP_LATCH:
     case ACTION_TYPE_GROUP_LOCK:
-        write_buf(buf, "%s%s(group=%s%d%s%s)%s", prefix, type,
-                  (!(action->group.flags & ACTION_ABSOLUTE_SWITCH) && action->group.group > 0) ? "+" : "",
-                  (action->group.flags & ACTION_ABSOLUTE_SWITCH) ? action->group.group + 1 : action->group.group,
-                  (action->type != ACTION_TYPE_GROUP_LOCK && (action->group.flags & ACTION_LOCK_CLEAR)) ? ",clearLocks" : "",
-                  (action->type != ACTION_TYPE_GROUP_LOCK && (action->group.flags & ACTION_LATCH_TO_LOCK)) ? ",latchToLock" : "",
-                  suffix);
+        write_lit(buf, "(group=");
+        if (action->group.flags & ACTION_ABSOLUTE_SWITCH)
+            write_int(buf, action->group.group + 1);
+        else if (!write_signed(buf, action->group.group, false, false))
+            return false;
+        if (action->type != ACTION_TYPE_GROUP_LOCK) {
+            if (action->group.flags & ACTION_LOCK_CLEAR)
+                write_lit(buf, ",clearLocks");
+            if (action->group.flags & ACTION_LATCH_TO_LOCK)
+                write_lit(buf, ",latchToLock");
+        }
+        write_lit(buf, ")");
         break;
 
     case ACTION_TYPE_TERMINATE:
-        write_buf(buf, "%s%s()%s", prefix, type, suffix);
+        write_lit(buf, "()");
         break;
 
     case ACTION_TYPE_PTR_MOVE:
-        write_buf(buf, "%s%s(x=%s%d,y=%s%d%s)%s", prefix, type,
-                  (!(action->ptr.flags & ACTION_ABSOLUTE_X) && action->ptr.x >= 0) ? "+" : "",
-                  action->ptr.x,
-                  (!(action->ptr.flags & ACTION_ABSOLUTE_Y) && action->ptr.y >= 0) ? "+" : "",
-                  action->ptr.y,
-                  (action->ptr.flags & ACTION_ACCEL) ? "" : ",!accel",
-                  suffix);
+        write_lit(buf, "(x=");
+        if (!write_signed(buf, action->ptr.x,
+                          action->ptr.flags & ACTION_ABSOLUTE_X, true))
+            return false;
+        write_lit(buf, ",y=");
+        if (!write_signed(buf, action->ptr.y,
+                          action->ptr.flags & ACTION_ABSOLUTE_Y, true))
+            return false;
+        if (!(action->ptr.flags & ACTION_ACCEL))
+            write_lit(buf, ",!accel");
+        write_lit(buf, ")");
         break;
 
     case ACTION_TYPE_PTR_LOCK:
         args = affect_lock_text(action->btn.flags, true);
         /* fallthrough */
     case ACTION_TYPE_PTR_BUTTON:
-        write_buf(buf, "%s%s(button=", prefix, type);
+        write_lit(buf, "(button=");
         if (action->btn.button > 0 && action->btn.button <= 5)
-            write_buf(buf, "%d", action->btn.button);
+            write_int(buf, action->btn.button);
         else
-            write_buf(buf, "default");
-        if (action->btn.count)
-            write_buf(buf, ",count=%d", action->btn.count);
+            write_lit(buf, "default");
+        if (action->btn.count) {
+            write_lit(buf, ",count=");
+            write_int(buf, action->btn.count);
+        }
         if (args)
-            write_buf(buf, "%s", args);
-        write_buf(buf, ")%s", suffix);
+            write_str(buf, args);
+        write_lit(buf, ")");
         break;
 
     case ACTION_TYPE_PTR_DEFAULT:
-        write_buf(buf, "%s%s(", prefix, type);
-        write_buf(buf, "affect=button,button=%s%d",
-                  (!(action->dflt.flags & ACTION_ABSOLUTE_SWITCH) && action->dflt.value >= 0) ? "+" : "",
-                  action->dflt.value);
-        write_buf(buf, ")%s", suffix);
+        write_lit(buf, "(affect=button,button=");
+        if (!write_signed(buf, action->dflt.value,
+                          action->dflt.flags & ACTION_ABSOLUTE_SWITCH, true))
+            return false;
+        write_lit(buf, ")");
         break;
 
     case ACTION_TYPE_SWITCH_VT:
-        write_buf(buf, "%s%s(screen=%s%d,%ssame)%s", prefix, type,
-                  (!(action->screen.flags & ACTION_ABSOLUTE_SWITCH) && action->screen.screen >= 0) ? "+" : "",
-                  action->screen.screen,
-                  (action->screen.flags & ACTION_SAME_SCREEN) ? "" : "!",
-                  suffix);
+        write_lit(buf, "(screen=");
+        if (!write_signed(buf, action->screen.screen,
+                          action->screen.flags & ACTION_ABSOLUTE_SWITCH, true))
+            return false;
+        if (action->screen.flags & ACTION_SAME_SCREEN)
+            write_lit(buf, ",same)");
+        else
+            write_lit(buf, ",!same)");
         break;
 
     case ACTION_TYPE_CTRL_SET:
     case ACTION_TYPE_CTRL_LOCK:
-        write_buf(buf, "%s%s(controls=%s%s)%s", prefix, type,
-                  ControlMaskText(keymap->ctx, action->ctrls.ctrls),
-                  (action->type == ACTION_TYPE_CTRL_LOCK) ? affect_lock_text(action->ctrls.flags, false) : "",
-                  suffix);
+        write_lit(buf, "(controls=");
+        write_str(buf, ControlMaskText(keymap->ctx, action->ctrls.ctrls));
+        if (action->type == ACTION_TYPE_CTRL_LOCK)
+            write_str(buf, affect_lock_text(action->ctrls.flags, false));
+        write_lit(buf, ")");
         break;
 
     case ACTION_TYPE_NONE:
-        write_buf(buf, "%sNoAction()%s", prefix, suffix);
+        write_lit(buf, "()");
         break;
 
     default:
-        write_buf(buf,
-                  "%s%s(type=0x%02x,data[0]=0x%02x,data[1]=0x%02x,data[2]=0x%02x,data[3]=0x%02x,data[4]=0x%02x,data[5]=0x%02x,data[6]=0x%02x)%s",
-                  prefix, type, action->type, action->priv.data[0],
-                  action->priv.data[1], action->priv.data[2],
-                  action->priv.data[3], action->priv.data[4],
-                  action->priv.data[5], action->priv.data[6],
-                  suffix);
+        write_lit(buf, "(type=");
+        write_hex(buf, action->type);
+        for (unsigned i = 0; i < sizeof(action->priv.data); i++) {
+            write_lit(buf, ",data[");
+            write_uint(buf, i);
+            write_lit(buf, "]=");
+            write_hex(buf, action->priv.data[i]);
+        }
+        write_lit(buf, ")");
         break;
     }
 
+    if (suffix)
+        write_str(buf, suffix);
+
     return true;
 }
 
@@ -411,46 +631,61 @@ write_compat(struct xkb_keymap *keymap, struct buf *buf)
 {
     const struct xkb_led *led;
 
-    if (keymap->compat_section_name)
-        write_buf(buf, "xkb_compatibility \"%s\" {\n",
-                  keymap->compat_section_name);
-    else
-        write_buf(buf, "xkb_compatibility {\n");
+    if (keymap->compat_section_name) {
+        write_lit(buf, "xkb_compatibility \"");
+        write_str(buf, keymap->compat_section_name);
+        write_lit(buf, "\" {\n");
+    }
+    else {
+        write_lit(buf, "xkb_compatibility {\n");
+    }
 
-    write_vmods(keymap, buf);
+    if (!write_vmods(keymap, buf))
+        return false;
 
-    write_buf(buf, "\tinterpret.useModMapMods= AnyLevel;\n");
-    write_buf(buf, "\tinterpret.repeat= False;\n");
+    write_lit(buf, "\tinterpret.useModMapMods= AnyLevel;\n");
+    write_lit(buf, "\tinterpret.repeat= False;\n");
 
     for (unsigned i = 0; i < keymap->num_sym_interprets; i++) {
         const struct xkb_sym_interpret *si = &keymap->sym_interprets[i];
 
-        write_buf(buf, "\tinterpret %s+%s(%s) {\n",
-                  si->sym ? KeysymText(keymap->ctx, si->sym) : "Any",
-                  SIMatchText(si->match),
-                  ModMaskText(keymap->ctx, &keymap->mods, si->mods));
+        write_lit(buf, "\tinterpret ");
+        if (!si->sym)
+            write_lit(buf, "Any");
+        else if (!write_keysym(buf, si->sym, 0))
+            return false;
+        write_lit(buf, "+");
+        write_str(buf, SIMatchText(si->match));
+        write_lit(buf, "(");
+        if (!write_mod_mask(keymap, buf, si->mods))
+            return false;
+        write_lit(buf, ") {\n");
 
-        if (si->virtual_mod != XKB_MOD_INVALID)
-            write_buf(buf, "\t\tvirtualModifier= %s;\n",
-                      ModIndexText(keymap->ctx, &keymap->mods,
-                                   si->virtual_mod));
+        if (si->virtual_mod != XKB_MOD_INVALID) {
+            write_lit(buf, "\t\tvirtualModifier= ");
+            write_str(buf, ModIndexText(keymap->ctx, &keymap->mods,
+                                        si->virtual_mod));
+            write_lit(buf, ";\n");
+        }
 
         if (si->level_one_only)
-            write_buf(buf, "\t\tuseModMapMods=level1;\n");
+            write_lit(buf, "\t\tuseModMapMods=level1;\n");
 
         if (si->repeat)
-            write_buf(buf, "\t\trepeat= True;\n");
+            write_lit(buf, "\t\trepeat= True;\n");
 
-        write_action(keymap, buf, &si->action, "\t\taction= ", ";\n");
-        write_buf(buf, "\t};\n");
+        if (!write_action(keymap, buf, &si->action, "\t\taction= ", ";\n"))
+            return false;
+        write_lit(buf, "\t};\n");
     }
 
     xkb_leds_foreach(led, keymap)
         if (led->which_groups || led->groups || led->which_mods ||
             led->mods.mods || led->ctrls)
-            write_led_map(keymap, buf, led);
+            if (!write_led_map(keymap, buf, led))
+                return false;
 
-    write_buf(buf, "};\n\n");
+    write_lit(buf, "};\n\n");
 
     return true;
 }
@@ -465,24 +700,26 @@ write_keysyms(struct xkb_keymap *keymap, struct buf *buf,
         int num_syms;
 
         if (level != 0)
-            write_buf(buf, ", ");
+            write_lit(buf, ", ");
 
         num_syms = xkb_keymap_key_get_syms_by_level(keymap, key->keycode,
                                                     group, level, &syms);
         if (num_syms == 0) {
-            write_buf(buf, "%15s", "NoSymbol");
+            write_padded(buf, "NoSymbol", 15, true);
         }
         else if (num_syms == 1) {
-            write_buf(buf, "%15s", KeysymText(keymap->ctx, syms[0]));
+            if (!write_keysym(buf, syms[0], 15))
+                return false;
         }
         else {
-            write_buf(buf, "{ ");
+            write_lit(buf, "{ ");
             for (int s = 0; s < num_syms; s++) {
                 if (s != 0)
-                    write_buf(buf, ", ");
-                write_buf(buf, "%s", KeysymText(keymap->ctx, syms[s]));
+                    write_lit(buf, ", ");
+                if (!write_keysym(buf, syms[s], 0))
+                    return false;
             }
-            write_buf(buf, " }");
+            write_lit(buf, " }");
         }
     }
 
@@ -499,7 +736,10 @@ write_key(struct xkb_keymap *keymap, struct buf *buf,
     bool multi_type = false;
     bool show_actions;
 
-    write_buf(buf, "\tkey %-20s {", KeyNameText(keymap->ctx, key->name));
+    write_lit(buf, "\tkey ");
+    if (!write_key_name(keymap, buf, key->name, 20))
+        return false;
+    write_lit(buf, " {");
 
     for (group = 0; group < key->num_groups; group++) {
         if (key->groups[group].explicit_type)
@@ -519,38 +759,45 @@ write_key(struct xkb_keymap *keymap, struct buf *buf,
                     continue;
 
                 type = key->groups[group].type;
-                write_buf(buf, "\n\t\ttype[Group%u]= \"%s\",",
-                            group + 1,
-                            xkb_atom_text(keymap->ctx, type->name));
+                write_lit(buf, "\n\t\ttype[Group");
+                write_uint(buf, group + 1);
+                write_lit(buf, "]= \"");
+                write_atom(buf, keymap, type->name);
+                write_lit(buf, "\",");
             }
         }
         else {
             type = key->groups[0].type;
-            write_buf(buf, "\n\t\ttype= \"%s\",",
-                        xkb_atom_text(keymap->ctx, type->name));
+            write_lit(buf, "\n\t\ttype= \"");
+            write_atom(buf, keymap, type->name);
+            write_lit(buf, "\",");
         }
     }
 
     if (key->explicit & EXPLICIT_REPEAT) {
         if (key->repeats)
-            write_buf(buf, "\n\t\trepeat= Yes,");
+            write_lit(buf, "\n\t\trepeat= Yes,");
         else
-            write_buf(buf, "\n\t\trepeat= No,");
+            write_lit(buf, "\n\t\trepeat= No,");
         simple = false;
     }
 
-    if (key->vmodmap && (key->explicit & EXPLICIT_VMODMAP))
-        write_buf(buf, "\n\t\tvirtualMods= %s,",
-                  ModMaskText(keymap->ctx, &keymap->mods, key->vmodmap));
+    if (key->vmodmap && (key->explicit & EXPLICIT_VMODMAP)) {
+        write_lit(buf, "\n\t\tvirtualMods= ");
+        if (!write_mod_mask(keymap, buf, key->vmodmap))
+            return false;
+        write_lit(buf, ",");
+    }
 
     switch (key->out_of_range_group_action) {
     case RANGE_SATURATE:
-        write_buf(buf, "\n\t\tgroupsClamp,");
+        write_lit(buf, "\n\t\tgroupsClamp,");
         break;
 
     case RANGE_REDIRECT:
-        write_buf(buf, "\n\t\tgroupsRedirect= Group%u,",
-                    key->out_of_range_group_number + 1);
+        write_lit(buf, "\n\t\tgroupsRedirect= Group");
+        write_uint(buf, key->out_of_range_group_number + 1);
+        write_lit(buf, ",");
         break;
 
     default:
@@ -563,34 +810,39 @@ write_key(struct xkb_keymap *keymap, struct buf *buf,
         simple = false;
 
     if (simple) {
-        write_buf(buf, "\t[ ");
+        write_lit(buf, "\t[ ");
         if (!write_keysyms(keymap, buf, key, 0))
             return false;
-        write_buf(buf, " ] };\n");
+        write_lit(buf, " ] };\n");
     }
     else {
         xkb_level_index_t level;
 
         for (group = 0; group < key->num_groups; group++) {
             if (group != 0)
-                write_buf(buf, ",");
-            write_buf(buf, "\n\t\tsymbols[Group%u]= [ ", group + 1);
+                write_lit(buf, ",");
+            write_lit(buf, "\n\t\tsymbols[Group");
+            write_uint(buf, group + 1);
+            write_lit(buf, "]= [ ");
             if (!write_keysyms(keymap, buf, key, group))
                 return false;
-            write_buf(buf, " ]");
+            write_lit(buf, " ]");
             if (show_actions) {
-                write_buf(buf, ",\n\t\tactions[Group%u]= [ ", group + 1);
+                write_lit(buf, ",\n\t\tactions[Group");
+                write_uint(buf, group + 1);
+                write_lit(buf, "]= [ ");
                 for (level = 0; level < XkbKeyNumLevels(key, group); level++) {
                     if (level != 0)
-                        write_buf(buf, ", ");
-                    write_action(keymap, buf,
-                                    &key->groups[group].levels[level].action,
-                                    NULL, NULL);
+                        write_lit(buf, ", ");
+                    if (!write_action(keymap, buf,
+                                      &key->groups[group].levels[level].action,
+                                      NULL, NULL))
+                        return false;
                 }
-                write_buf(buf, " ]");
+                write_lit(buf, " ]");
             }
         }
-        write_buf(buf, "\n\t};\n");
+        write_lit(buf, "\n\t};\n");
     }
 
     return true;
@@ -604,54 +856,96 @@ write_symbols(struct xkb_keymap *keymap, struct buf *buf)
     xkb_mod_index_t i;
     const struct xkb_mod *mod;
 
-    if (keymap->symbols_section_name)
-        write_buf(buf, "xkb_symbols \"%s\" {\n",
-                  keymap->symbols_section_name);
-    else
-        write_buf(buf, "xkb_symbols {\n");
+    if (keymap->symbols_section_name) {
+        write_lit(buf, "xkb_symbols \"");
+        write_str(buf, keymap->symbols_section_name);
+        write_lit(buf, "\" {\n");
+    }
+    else {
+        write_lit(buf, "xkb_symbols {\n");
+    }
 
-    for (group = 0; group < keymap->num_group_names; group++)
-        if (keymap->group_names[group])
-            write_buf(buf,
-                      "\tname[Group%u]=\"%s\";\n", group + 1,
-                      xkb_atom_text(keymap->ctx, keymap->group_names[group]));
+    for (group = 0; group < keymap->num_group_names; group++) {
+        if (keymap->group_names[group]) {
+            write_lit(buf, "\tname[Group");
+            write_uint(buf, group + 1);
+            write_lit(buf, "]=\"");
+            write_atom(buf, keymap, keymap->group_names[group]);
+            write_lit(buf, "\";\n");
+        }
+    }
     if (group > 0)
-        write_buf(buf, "\n");
+        write_lit(buf, "\n");
 
     xkb_keys_foreach(key, keymap)
         if (key->num_groups > 0)
-            write_key(keymap, buf, key);
+            if (!write_key(keymap, buf, key))
+                return false;
 
     xkb_mods_enumerate(i, mod, &keymap->mods) {
         bool had_any = false;
         xkb_keys_foreach(key, keymap) {
             if (key->modmap & (1u << i)) {
-                if (!had_any)
-                    write_buf(buf, "\tmodifier_map %s { ",
-                              xkb_atom_text(keymap->ctx, mod->name));
-                write_buf(buf, "%s%s",
-                          had_any ? ", " : "",
-                          KeyNameText(keymap->ctx, key->name));
+                if (!had_any) {
+                    write_lit(buf, "\tmodifier_map ");
+                    write_atom(buf, keymap, mod->name);
+                    write_lit(buf, " { ");
+                }
+                else {
+                    write_lit(buf, ", ");
+                }
+                if (!write_key_name(keymap, buf, key->name, 0))
+                    return false;
                 had_any = true;
             }
         }
         if (had_any)
-            write_buf(buf, " };\n");
+            write_lit(buf, " };\n");
     }
 
-    write_buf(buf, "};\n\n");
+    write_lit(buf, "};\n\n");
     return true;
 }
 
+/*
+ * A rough upper bound of the output size, so that the buffer rarely needs
+ * to grow.
+ */
+static size_t
+estimate_size(struct xkb_keymap *keymap)
+{
+    const struct xkb_key *key;
+    size_t size = 4096;
+
+    size += 64 * keymap->num_key_aliases;
+    size += 128 * keymap->num_sym_interprets;
+    for (unsigned i = 0; i < keymap->num_types; i++)
+        size += 128 + 64 * keymap->types[i].num_entries;
+
+    xkb_keys_foreach(key, keymap) {
+        /* The keycode line and the key header. */
+        size += 64;
+        for (xkb_layout_index_t group = 0; group < key->num_groups; group++)
+            size += 32 + 20 * XkbKeyNumLevels(key, group);
+    }
+
+    return size;
+}
+
 static bool
 write_keymap(struct xkb_keymap *keymap, struct buf *buf)
 {
-    return (check_write_buf(buf, "xkb_keymap {\n") &&
-            write_keycodes(keymap, buf) &&
-            write_types(keymap, buf) &&
-            write_compat(keymap, buf) &&
-            write_symbols(keymap, buf) &&
-            check_write_buf(buf, "};\n"));
+    write_lit(buf, "xkb_keymap {\n");
+
+    if (!write_keycodes(keymap, buf) ||
+        !write_types(keymap, buf) ||
+        !write_compat(keymap, buf) ||
+        !write_symbols(keymap, buf))
+        return false;
+
+    /* With the terminating NUL. */
+    write_lit(buf, "};\n\0");
+    return true;
 }
 
 char *
@@ -659,7 +953,8 @@ text_v1_keymap_get_as_string(struct xkb_keymap *keymap)
 {
     struct buf buf = { NULL, 0, 0 };
 
-    if (!write_keymap(keymap, &buf)) {
+    if (!buf_reserve(&buf, estimate_size(keymap)) ||
+        !write_keymap(keymap, &buf)) {
         free(buf.buf);
         return NULL;
     }
@@ -48,6 +48,7 @@ compile_keymap_file(struct xkb_keymap *keymap, XkbFile *file)
         return false;
     }
 
+    xkb_keymap_share_parts(keymap);
     return true;
 }
 
@@ -23,8 +23,13 @@
 
 #include "config.h"
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
 #include "xkbcommon/xkbcommon-compose.h"
 
+#include "evdev-scancodes.h"
 #include "test.h"
 
 static const char *
@@ -426,6 +431,130 @@ test_XCOMPOSEFILE(struct xkb_context *ctx)
     xkb_compose_table_unref(table);
 }
 
+static void
+write_compose_file(const char *path, const char *include, const char *result)
+{
+    FILE *file = fopen(path, "wb");
+    assert(file);
+    fprintf(file, "include \"%s\"\n<F35> <a> : \"%s\"\n", include, result);
+    fclose(file);
+}
+
+static void
+set_mtime(const char *path, time_t sec, long nsec)
+{
+    struct timespec times[2] = { { sec, nsec }, { sec, nsec } };
+    assert(utimensat(AT_FDCWD, path, times, 0) == 0);
+}
+
+static void
+test_cache(struct xkb_context *ctx)
+{
+    struct xkb_compose_table *table;
+    char tmpdir[] = "/tmp/xkbcommon-test.XXXXXX";
+    char *include, *compose_path, *cache_home, *cache_dir, *cache_path;
+    struct dirent *entry;
+    struct stat st;
+    DIR *dir;
+
+    assert(mkdtemp(tmpdir));
+    include = test_get_path("compose/en_US.UTF-8/Compose");
+    compose_path = asprintf_safe("%s/Compose", tmpdir);
+    cache_home = asprintf_safe("%s/cache", tmpdir);
+    cache_dir = asprintf_safe("%s/xkbcommon", cache_home);
+    assert(include && compose_path && cache_home && cache_dir);
+
+    write_compose_file(compose_path, include, "first");
+    set_mtime(compose_path, 1000000000, 0);
+    setenv("XCOMPOSEFILE", compose_path, 1);
+    setenv("XDG_CACHE_HOME", cache_home, 1);
+
+    /* Without the flag, nothing is cached. */
+    table = xkb_compose_table_new_from_locale(ctx, "C",
+                                              XKB_COMPOSE_COMPILE_NO_FLAGS);
+    assert(table);
+    xkb_compose_table_unref(table);
+    assert(stat(cache_dir, &st) != 0);
+
+    /* Compiled, and then loaded from the cache. */
+    for (int i = 0; i < 2; i++) {
+        table = xkb_compose_table_new_from_locale(ctx, "C",
+                                                  XKB_COMPOSE_COMPILE_USE_CACHE);
+        assert(table);
+        assert(test_compose_seq(table,
+            XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",      XKB_KEY_NoSymbol,
+            XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "first", XKB_KEY_NoSymbol,
+            XKB_KEY_dead_tilde,     XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",      XKB_KEY_NoSymbol,
+            XKB_KEY_space,          XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "~",     XKB_KEY_asciitilde,
+            XKB_KEY_NoSymbol));
+        xkb_compose_table_unref(table);
+    }
+
+    dir = opendir(cache_dir);
+    assert(dir);
+    cache_path = NULL;
+    while ((entry = readdir(dir))) {
+        if (entry->d_name[0] == '.')
+            continue;
+        assert(!cache_path);
+        cache_path = asprintf_safe("%s/%s", cache_dir, entry->d_name);
+    }
+    closedir(dir);
+    assert(cache_path);
+
+    /*
+     * The cache only looks at the size and modification time, so a
+     * change which keeps both proves the cache is actually used.
+     */
+    write_compose_file(compose_path, include, "third");
+    set_mtime(compose_path, 1000000000, 0);
+    table = xkb_compose_table_new_from_locale(ctx, "C",
+                                              XKB_COMPOSE_COMPILE_USE_CACHE);
+    assert(table);
+    assert(test_compose_seq(table,
+        XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",      XKB_KEY_NoSymbol,
+        XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "first", XKB_KEY_NoSymbol,
+        XKB_KEY_NoSymbol));
+    xkb_compose_table_unref(table);
+
+    /* A modification, even within the same second, invalidates the entry. */
+    set_mtime(compose_path, 1000000000, 500000000);
+    for (int i = 0; i < 2; i++) {
+        table = xkb_compose_table_new_from_locale(ctx, "C",
+                                                  XKB_COMPOSE_COMPILE_USE_CACHE);
+        assert(table);
+        assert(test_compose_seq(table,
+            XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",      XKB_KEY_NoSymbol,
+            XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "third", XKB_KEY_NoSymbol,
+            XKB_KEY_NoSymbol));
+        xkb_compose_table_unref(table);
+    }
+
+    /* A corrupt cache file is ignored. */
+    write_compose_file(cache_path, include, "garbage");
+    table = xkb_compose_table_new_from_locale(ctx, "C",
+                                              XKB_COMPOSE_COMPILE_USE_CACHE);
+    assert(table);
+    assert(test_compose_seq(table,
+        XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",      XKB_KEY_NoSymbol,
+        XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "third", XKB_KEY_NoSymbol,
+        XKB_KEY_NoSymbol));
+    xkb_compose_table_unref(table);
+
+    unsetenv("XCOMPOSEFILE");
+    unsetenv("XDG_CACHE_HOME");
+    unlink(cache_path);
+    rmdir(cache_dir);
+    rmdir(cache_home);
+    unlink(compose_path);
+    rmdir(tmpdir);
+    free(cache_path);
+    free(cache_dir);
+    free(cache_home);
+    free(compose_path);
+    free(include);
+}
+
 static void
 test_modifier_syntax(struct xkb_context *ctx)
 {
@@ -515,6 +644,547 @@ test_include(struct xkb_context *ctx)
     free(table_string);
 }
 
+static void
+test_overlay(struct xkb_context *ctx)
+{
+    struct xkb_compose_table *base, *overlay;
+    char *path, *overlay_string;
+
+    path = test_get_path("compose/en_US.UTF-8/Compose");
+    assert(path);
+    setenv("XCOMPOSEFILE", path, 1);
+    base = xkb_compose_table_new_from_locale(ctx, "C",
+                                             XKB_COMPOSE_COMPILE_NO_FLAGS);
+    unsetenv("XCOMPOSEFILE");
+    assert(base);
+
+    /* The include is skipped, since the base already has it. */
+    overlay_string = asprintf_safe("include \"%s\"\n"
+                                   "<dead_tilde> <space>   : \"foo\" X\n"
+                                   "<F35> <a>              : \"bar\"\n"
+                                   "<Multi_key> <a>        : \"baz\"\n"
+                                   "<dead_acute> <dead_acute> <dead_acute> : \"qux\"\n",
+                                   path);
+    assert(overlay_string);
+    overlay = xkb_compose_table_new_overlay_from_buffer(base, overlay_string,
+                                                        strlen(overlay_string),
+                                                        XKB_COMPOSE_FORMAT_TEXT_V1,
+                                                        XKB_COMPOSE_COMPILE_NO_FLAGS);
+    assert(overlay);
+
+    assert(test_compose_seq(overlay,
+        /* Only in the base. */
+        XKB_KEY_dead_acute,     XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "á",    XKB_KEY_aacute,
+
+        /* In both; the overlay wins. */
+        XKB_KEY_dead_tilde,     XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_space,          XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "foo",  XKB_KEY_X,
+
+        /* Only in the overlay. */
+        XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "bar",  XKB_KEY_NoSymbol,
+
+        /* A prefix of base sequences in the overlay. */
+        XKB_KEY_Multi_key,      XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "baz",  XKB_KEY_NoSymbol,
+
+        /* A base sequence is a prefix of an overlay sequence. */
+        XKB_KEY_dead_acute,     XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_dead_acute,     XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_dead_acute,     XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "qux",  XKB_KEY_NoSymbol,
+
+        /* Falls through to the base after the first keysym. */
+        XKB_KEY_Multi_key,      XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_o,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_c,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "©",    XKB_KEY_copyright,
+
+        /* In neither. */
+        XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_b,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_CANCELLED,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_x,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_NOTHING,    "",     XKB_KEY_NoSymbol,
+
+        XKB_KEY_NoSymbol));
+
+    /* An overlay cannot be a base. */
+    assert(!xkb_compose_table_new_overlay_from_buffer(overlay, "", 0,
+                                                      XKB_COMPOSE_FORMAT_TEXT_V1,
+                                                      XKB_COMPOSE_COMPILE_NO_FLAGS));
+
+    /* The overlay keeps the base alive. */
+    xkb_compose_table_unref(base);
+    assert(test_compose_seq(overlay,
+        XKB_KEY_dead_acute,     XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_e,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "é",    XKB_KEY_eacute,
+        XKB_KEY_NoSymbol));
+
+    xkb_compose_table_unref(overlay);
+    free(overlay_string);
+    free(path);
+}
+
+static void
+test_compact(struct xkb_context *ctx)
+{
+    struct xkb_compose_table *table, *compact;
+    struct xkb_compose_state *state, *compact_state;
+    const char *table_string;
+    char *path;
+    FILE *file;
+    size_t size, compact_size;
+    xkb_keysym_t keysyms[] = {
+        XKB_KEY_Multi_key, XKB_KEY_dead_acute, XKB_KEY_dead_grave,
+        XKB_KEY_dead_tilde, XKB_KEY_dead_circumflex, XKB_KEY_dead_diaeresis,
+        XKB_KEY_apostrophe, XKB_KEY_quotedbl, XKB_KEY_grave,
+        XKB_KEY_asciicircum, XKB_KEY_minus, XKB_KEY_space, XKB_KEY_a,
+        XKB_KEY_e, XKB_KEY_o, XKB_KEY_A, XKB_KEY_c, XKB_KEY_s, XKB_KEY_1,
+        XKB_KEY_q,
+    };
+
+    path = test_get_path("compose/en_US.UTF-8/Compose");
+    file = fopen(path, "rb");
+    assert(file);
+    table = xkb_compose_table_new_from_file(ctx, file, "",
+                                            XKB_COMPOSE_FORMAT_TEXT_V1,
+                                            XKB_COMPOSE_COMPILE_NO_FLAGS);
+    assert(table);
+    rewind(file);
+    compact = xkb_compose_table_new_from_file(ctx, file, "",
+                                              XKB_COMPOSE_FORMAT_TEXT_V1,
+                                              XKB_COMPOSE_COMPILE_COMPACT);
+    assert(compact);
+    fclose(file);
+    free(path);
+
+    size = xkb_compose_table_get_memory_size(table);
+    compact_size = xkb_compose_table_get_memory_size(compact);
+    assert(compact_size < size);
+
+    /* Both tables must compose the same. */
+    state = xkb_compose_state_new(table, XKB_COMPOSE_STATE_NO_FLAGS);
+    compact_state = xkb_compose_state_new(compact, XKB_COMPOSE_STATE_NO_FLAGS);
+    assert(state && compact_state);
+    srand(1);
+    for (int i = 0; i < 200000; i++) {
+        xkb_keysym_t keysym = keysyms[rand() % ARRAY_SIZE(keysyms)];
+        char buffer[64], compact_buffer[64];
+
+        assert(xkb_compose_state_feed(state, keysym) ==
+               xkb_compose_state_feed(compact_state, keysym));
+        assert(xkb_compose_state_get_status(state) ==
+               xkb_compose_state_get_status(compact_state));
+        assert(xkb_compose_state_get_one_sym(state) ==
+               xkb_compose_state_get_one_sym(compact_state));
+        xkb_compose_state_get_utf8(state, buffer, sizeof(buffer));
+        xkb_compose_state_get_utf8(compact_state, compact_buffer,
+                                   sizeof(compact_buffer));
+        assert(streq(buffer, compact_buffer));
+    }
+    xkb_compose_state_unref(state);
+    xkb_compose_state_unref(compact_state);
+    xkb_compose_table_unref(table);
+    xkb_compose_table_unref(compact);
+
+    /* Shared subtrees, overridden and suffix-shared strings. */
+    table_string =
+        "<dead_acute> <a> : \"á\" aacute\n"
+        "<dead_acute> <e> : \"é\" eacute\n"
+        "<Multi_key> <apostrophe> <a> : \"á\" aacute\n"
+        "<Multi_key> <apostrophe> <e> : \"é\" eacute\n"
+        "<Multi_key> <quotedbl> <a> : \"xyz\"\n"
+        "<Multi_key> <quotedbl> <a> : \"ä\" adiaeresis\n"
+        "<Multi_key> <b> : \"abc\"\n"
+        "<Multi_key> <c> : \"bc\"\n"
+        "<Multi_key> <d> : \"c\"\n";
+    assert(test_compose_seq_buffer(ctx, table_string,
+        XKB_KEY_dead_acute,     XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_e,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "é",    XKB_KEY_eacute,
+        XKB_KEY_NoSymbol));
+    compact = xkb_compose_table_new_from_buffer(ctx, table_string,
+                                                strlen(table_string), "",
+                                                XKB_COMPOSE_FORMAT_TEXT_V1,
+                                                XKB_COMPOSE_COMPILE_COMPACT);
+    assert(compact);
+    assert(test_compose_seq(compact,
+        XKB_KEY_dead_acute,     XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "á",    XKB_KEY_aacute,
+        XKB_KEY_Multi_key,      XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_apostrophe,     XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_e,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "é",    XKB_KEY_eacute,
+        XKB_KEY_Multi_key,      XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_quotedbl,       XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "ä",    XKB_KEY_adiaeresis,
+        XKB_KEY_Multi_key,      XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_b,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "abc",  XKB_KEY_NoSymbol,
+        XKB_KEY_Multi_key,      XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_c,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "bc",   XKB_KEY_NoSymbol,
+        XKB_KEY_Multi_key,      XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_d,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "c",    XKB_KEY_NoSymbol,
+        XKB_KEY_NoSymbol));
+    table = xkb_compose_table_new_from_buffer(ctx, table_string,
+                                              strlen(table_string), "",
+                                              XKB_COMPOSE_FORMAT_TEXT_V1,
+                                              XKB_COMPOSE_COMPILE_NO_FLAGS);
+    assert(table);
+    assert(xkb_compose_table_get_memory_size(compact) <
+           xkb_compose_table_get_memory_size(table));
+    xkb_compose_table_unref(table);
+    xkb_compose_table_unref(compact);
+}
+
+static void
+test_feed_keysyms(struct xkb_context *ctx)
+{
+    struct xkb_compose_table *table;
+    struct xkb_compose_state *state, *batch_state;
+    char *path;
+    FILE *file;
+    enum xkb_compose_status statuses[512];
+    xkb_keysym_t input[512];
+    char expected[4096], buffer[4096];
+    size_t expected_len;
+    int ret;
+    xkb_keysym_t keysyms[] = {
+        XKB_KEY_Multi_key, XKB_KEY_dead_acute, XKB_KEY_dead_grave,
+        XKB_KEY_dead_circumflex, XKB_KEY_apostrophe, XKB_KEY_quotedbl,
+        XKB_KEY_a, XKB_KEY_e, XKB_KEY_o, XKB_KEY_A, XKB_KEY_c, XKB_KEY_1,
+        XKB_KEY_Shift_L, XKB_KEY_NoSymbol, XKB_KEY_eacute,
+    };
+
+    path = test_get_path("compose/en_US.UTF-8/Compose");
+    file = fopen(path, "rb");
+    assert(file);
+    free(path);
+    table = xkb_compose_table_new_from_file(ctx, file, "",
+                                            XKB_COMPOSE_FORMAT_TEXT_V1,
+                                            XKB_COMPOSE_COMPILE_NO_FLAGS);
+    assert(table);
+    fclose(file);
+
+    state = xkb_compose_state_new(table, XKB_COMPOSE_STATE_NO_FLAGS);
+    batch_state = xkb_compose_state_new(table, XKB_COMPOSE_STATE_NO_FLAGS);
+    assert(state && batch_state);
+
+    /* The batch must match feeding the keysyms one by one. */
+    srand(2);
+    for (int i = 0; i < 200; i++) {
+        expected_len = 0;
+        for (size_t j = 0; j < ARRAY_SIZE(input); j++) {
+            enum xkb_compose_status status;
+            char text[64] = "";
+
+            input[j] = keysyms[rand() % ARRAY_SIZE(keysyms)];
+            if (xkb_compose_state_feed(state, input[j]) ==
+                XKB_COMPOSE_FEED_IGNORED)
+                continue;
+            status = xkb_compose_state_get_status(state);
+            if (status == XKB_COMPOSE_COMPOSED)
+                xkb_compose_state_get_utf8(state, text, sizeof(text));
+            else if (status == XKB_COMPOSE_NOTHING)
+                xkb_keysym_to_utf8(input[j], text, sizeof(text));
+            memcpy(expected + expected_len, text, strlen(text));
+            expected_len += strlen(text);
+        }
+        expected[expected_len] = '\0';
+
+        ret = xkb_compose_state_feed_keysyms(batch_state, input,
+                                             ARRAY_SIZE(input), statuses,
+                                             buffer, sizeof(buffer));
+        assert(ret == (int) expected_len);
+        assert(streq(buffer, expected));
+        assert(statuses[ARRAY_SIZE(input) - 1] ==
+               xkb_compose_state_get_status(state));
+    }
+    xkb_compose_state_unref(state);
+
+    /* Truncation never splits a keysym's text. */
+    xkb_compose_state_reset(batch_state);
+    input[0] = XKB_KEY_dead_acute;
+    input[1] = XKB_KEY_e;
+    input[2] = XKB_KEY_a;
+    input[3] = XKB_KEY_eacute;
+    ret = xkb_compose_state_feed_keysyms(batch_state, input, 4, statuses,
+                                         buffer, 4);
+    assert(ret == 5);
+    assert(streq(buffer, "éa"));
+    assert(statuses[0] == XKB_COMPOSE_COMPOSING);
+    assert(statuses[1] == XKB_COMPOSE_COMPOSED);
+    assert(statuses[2] == XKB_COMPOSE_NOTHING);
+    assert(statuses[3] == XKB_COMPOSE_NOTHING);
+    ret = xkb_compose_state_feed_keysyms(batch_state, input, 4, NULL,
+                                         buffer, 2);
+    assert(ret == 5);
+    assert(streq(buffer, ""));
+    ret = xkb_compose_state_feed_keysyms(batch_state, input, 4, NULL,
+                                         NULL, 0);
+    assert(ret == 5);
+
+    xkb_compose_state_unref(batch_state);
+    xkb_compose_table_unref(table);
+}
+
+static void
+test_text_transducer(struct xkb_context *ctx)
+{
+    struct xkb_keymap *keymap;
+    struct xkb_compose_table *table;
+    struct xkb_text_transducer *transducer;
+    struct xkb_state *state;
+    struct xkb_compose_state *compose_state;
+    char *path;
+    FILE *file;
+    const xkb_keycode_t keys[] = {
+        KEY_A, KEY_E, KEY_O, KEY_C, KEY_1, KEY_2, KEY_SPACE, KEY_APOSTROPHE,
+        KEY_EQUAL, KEY_GRAVE, KEY_SEMICOLON, KEY_LEFTSHIFT, KEY_CAPSLOCK,
+        KEY_LEFTCTRL, KEY_RIGHTALT, KEY_COMPOSE, KEY_F1,
+    };
+
+    keymap = test_compile_rules(ctx, "evdev", "pc104", "us,de", NULL,
+                                "grp:menu_toggle,compose:ralt");
+    assert(keymap);
+
+    path = test_get_path("compose/en_US.UTF-8/Compose");
+    file = fopen(path, "rb");
+    assert(file);
+    free(path);
+    table = xkb_compose_table_new_from_file(ctx, file, "",
+                                            XKB_COMPOSE_FORMAT_TEXT_V1,
+                                            XKB_COMPOSE_COMPILE_NO_FLAGS);
+    assert(table);
+    fclose(file);
+
+    /* The transducer must match the usual per-key chain of calls. */
+    transducer = xkb_text_transducer_new(keymap, table,
+                                         XKB_TEXT_TRANSDUCER_NO_FLAGS);
+    assert(transducer);
+    state = xkb_state_new(keymap);
+    compose_state = xkb_compose_state_new(table, XKB_COMPOSE_STATE_NO_FLAGS);
+    assert(state && compose_state);
+    srand(3);
+    for (int i = 0; i < 100000; i++) {
+        xkb_keycode_t kc = keys[rand() % ARRAY_SIZE(keys)] + EVDEV_OFFSET;
+        enum xkb_key_direction direction =
+            rand() % 3 == 0 ? XKB_KEY_UP : XKB_KEY_DOWN;
+        char expected[64] = "", buffer[64];
+        int expected_ret = 0, ret;
+
+        if (direction == XKB_KEY_DOWN) {
+            xkb_keysym_t keysym = xkb_state_key_get_one_sym(state, kc);
+            enum xkb_compose_status status = XKB_COMPOSE_NOTHING;
+
+            if (xkb_compose_state_feed(compose_state, keysym) ==
+                XKB_COMPOSE_FEED_ACCEPTED)
+                status = xkb_compose_state_get_status(compose_state);
+            if (status == XKB_COMPOSE_COMPOSED)
+                expected_ret =
+                    xkb_compose_state_get_utf8(compose_state, expected,
+                                               sizeof(expected));
+            else if (status == XKB_COMPOSE_NOTHING)
+                expected_ret = xkb_state_key_get_utf8(state, kc, expected,
+                                                      sizeof(expected));
+        }
+        xkb_state_update_key(state, kc, direction);
+
+        ret = xkb_text_transducer_key(transducer, kc, direction,
+                                      buffer, sizeof(buffer));
+        /* With Control, e.g. "2" becomes a NUL byte. */
+        assert(ret == expected_ret);
+        assert(memcmp(buffer, expected, ret + 1) == 0);
+        assert(xkb_state_serialize_mods(state, XKB_STATE_MODS_EFFECTIVE) ==
+               xkb_state_serialize_mods(xkb_text_transducer_get_state(transducer),
+                                        XKB_STATE_MODS_EFFECTIVE));
+    }
+    xkb_state_unref(state);
+    xkb_compose_state_unref(compose_state);
+    xkb_text_transducer_unref(transducer);
+
+    /* Without a compose table. */
+    transducer = xkb_text_transducer_new(keymap, NULL,
+                                         XKB_TEXT_TRANSDUCER_NO_FLAGS);
+    assert(transducer);
+    assert(!xkb_text_transducer_get_compose_state(transducer));
+    {
+        char buffer[64];
+
+        assert(xkb_text_transducer_key(transducer, KEY_A + EVDEV_OFFSET,
+                                       XKB_KEY_DOWN, buffer,
+                                       sizeof(buffer)) == 1);
+        assert(streq(buffer, "a"));
+        assert(xkb_text_transducer_key(transducer, KEY_A + EVDEV_OFFSET,
+                                       XKB_KEY_UP, buffer,
+                                       sizeof(buffer)) == 0);
+        assert(streq(buffer, ""));
+        assert(xkb_text_transducer_key(transducer, KEY_CAPSLOCK + EVDEV_OFFSET,
+                                       XKB_KEY_DOWN, buffer,
+                                       sizeof(buffer)) == 0);
+        assert(xkb_text_transducer_key(transducer, KEY_A + EVDEV_OFFSET,
+                                       XKB_KEY_DOWN, NULL, 0) == 1);
+        assert(xkb_text_transducer_key(transducer, KEY_A + EVDEV_OFFSET,
+                                       XKB_KEY_DOWN, buffer,
+                                       sizeof(buffer)) == 1);
+        assert(streq(buffer, "A"));
+        assert(xkb_text_transducer_key(transducer, 0, XKB_KEY_DOWN, buffer,
+                                       sizeof(buffer)) == 0);
+    }
+    xkb_text_transducer_unref(transducer);
+
+    xkb_compose_table_unref(table);
+    xkb_keymap_unref(keymap);
+}
+
+static void
+write_file(const char *dir, const char *name, const char *contents)
+{
+    char *path = asprintf_safe("%s/%s", dir, name);
+    FILE *file;
+
+    assert(path);
+    file = fopen(path, "wb");
+    assert(file);
+    fputs(contents, file);
+    fclose(file);
+    free(path);
+}
+
+static void
+test_locale_resolution(struct xkb_context *ctx)
+{
+    struct xkb_compose_table *table;
+    char tmpdir[] = "/tmp/xkbcommon-test.XXXXXX";
+    char *home, *path, *dir_path, *user_path, *cache_home, *cache_dir;
+    struct dirent *entry;
+    DIR *dir;
+    const char *files[] = {
+        "locale.alias", "compose.dir", "fr.Compose", "de.Compose",
+        "user.Compose",
+    };
+
+    assert(mkdtemp(tmpdir));
+    home = strdup_safe(getenv("HOME"));
+    setenv("XLOCALEDIR", tmpdir, 1);
+    setenv("HOME", tmpdir, 1);
+    setenv("XDG_CONFIG_HOME", tmpdir, 1);
+    unsetenv("XCOMPOSEFILE");
+
+    write_file(tmpdir, "locale.alias",
+               "# The first match wins.\n"
+               "foo_FOO:\tfr_FR.UTF-8\n"
+               "foo_FOO\t\tde_DE.UTF-8\n");
+    write_file(tmpdir, "compose.dir",
+               "fr.Compose:\tfr_FR.UTF-8\n"
+               "de.Compose:\tde_DE.UTF-8\n");
+    dir_path = asprintf_safe("%s/compose.dir", tmpdir);
+    assert(dir_path);
+    set_mtime(dir_path, 1000000000, 0);
+    write_file(tmpdir, "fr.Compose", "<F35> <a> : \"fr\"\n");
+    write_file(tmpdir, "de.Compose", "<F35> <a> : \"de\"\n");
+
+    for (int i = 0; i < 2; i++) {
+        table = xkb_compose_table_new_from_locale(ctx, "foo_FOO",
+                                                  XKB_COMPOSE_COMPILE_NO_FLAGS);
+        assert(table);
+        assert(test_compose_seq(table,
+            XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+            XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "fr",   XKB_KEY_NoSymbol,
+            XKB_KEY_NoSymbol));
+        xkb_compose_table_unref(table);
+    }
+
+    table = xkb_compose_table_new_from_locale(ctx, "de_DE.UTF-8",
+                                              XKB_COMPOSE_COMPILE_NO_FLAGS);
+    assert(table);
+    assert(test_compose_seq(table,
+        XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "de",   XKB_KEY_NoSymbol,
+        XKB_KEY_NoSymbol));
+    xkb_compose_table_unref(table);
+
+    assert(!xkb_compose_table_new_from_locale(ctx, "xx_XX.UTF-8",
+                                              XKB_COMPOSE_COMPILE_NO_FLAGS));
+
+    /*
+     * The files are parsed again once they change, even within the same
+     * second and with the same size.
+     */
+    write_file(tmpdir, "compose.dir",
+               "de.Compose:\tfr_FR.UTF-8\n"
+               "fr.Compose:\tde_DE.UTF-8\n");
+    set_mtime(dir_path, 1000000000, 500000000);
+    table = xkb_compose_table_new_from_locale(ctx, "foo_FOO",
+                                              XKB_COMPOSE_COMPILE_NO_FLAGS);
+    assert(table);
+    assert(test_compose_seq(table,
+        XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "de",   XKB_KEY_NoSymbol,
+        XKB_KEY_NoSymbol));
+    xkb_compose_table_unref(table);
+
+    /* A cached table with a %L include depends on compose.dir too. */
+    write_file(tmpdir, "user.Compose", "include \"%L\"\n");
+    user_path = asprintf_safe("%s/user.Compose", tmpdir);
+    cache_home = asprintf_safe("%s/cache", tmpdir);
+    cache_dir = asprintf_safe("%s/xkbcommon", cache_home);
+    assert(user_path && cache_home && cache_dir);
+    setenv("XCOMPOSEFILE", user_path, 1);
+    setenv("XDG_CACHE_HOME", cache_home, 1);
+    for (int i = 0; i < 2; i++) {
+        table = xkb_compose_table_new_from_locale(ctx, "foo_FOO",
+                                                  XKB_COMPOSE_COMPILE_USE_CACHE);
+        assert(table);
+        assert(test_compose_seq(table,
+            XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+            XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "de",   XKB_KEY_NoSymbol,
+            XKB_KEY_NoSymbol));
+        xkb_compose_table_unref(table);
+    }
+    write_file(tmpdir, "compose.dir",
+               "fr.Compose:\tfr_FR.UTF-8\n"
+               "de.Compose:\tde_DE.UTF-8\n");
+    set_mtime(dir_path, 1000000000, 0);
+    table = xkb_compose_table_new_from_locale(ctx, "foo_FOO",
+                                              XKB_COMPOSE_COMPILE_USE_CACHE);
+    assert(table);
+    assert(test_compose_seq(table,
+        XKB_KEY_F35,            XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSING,  "",     XKB_KEY_NoSymbol,
+        XKB_KEY_a,              XKB_COMPOSE_FEED_ACCEPTED,  XKB_COMPOSE_COMPOSED,   "fr",   XKB_KEY_NoSymbol,
+        XKB_KEY_NoSymbol));
+    xkb_compose_table_unref(table);
+
+    unsetenv("XCOMPOSEFILE");
+    unsetenv("XDG_CACHE_HOME");
+    dir = opendir(cache_dir);
+    assert(dir);
+    while ((entry = readdir(dir))) {
+        if (entry->d_name[0] == '.')
+            continue;
+        path = asprintf_safe("%s/%s", cache_dir, entry->d_name);
+        unlink(path);
+        free(path);
+    }
+    closedir(dir);
+    rmdir(cache_dir);
+    rmdir(cache_home);
+    free(cache_dir);
+    free(cache_home);
+    free(user_path);
+    free(dir_path);
+
+    for (size_t i = 0; i < ARRAY_SIZE(files); i++) {
+        path = asprintf_safe("%s/%s", tmpdir, files[i]);
+        unlink(path);
+        free(path);
+    }
+    rmdir(tmpdir);
+
+    unsetenv("XLOCALEDIR");
+    unsetenv("XDG_CONFIG_HOME");
+    if (home)
+        setenv("HOME", home, 1);
+    else
+        unsetenv("HOME");
+    free(home);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -526,9 +1196,15 @@ main(int argc, char *argv[])
     test_seqs(ctx);
     test_conflicting(ctx);
     test_XCOMPOSEFILE(ctx);
+    test_cache(ctx);
     test_state(ctx);
     test_modifier_syntax(ctx);
     test_include(ctx);
+    test_overlay(ctx);
+    test_compact(ctx);
+    test_feed_keysyms(ctx);
+    test_text_transducer(ctx);
+    test_locale_resolution(ctx);
 
     xkb_context_unref(ctx);
     return 0;
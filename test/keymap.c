@@ -30,6 +30,8 @@
 #include <stdlib.h>
 
 #include "test.h"
+#include "context.h"
+#include "keymap.h"
 
 static void
 test_garbage_key(void)
@@ -149,11 +151,113 @@ test_keymap(void)
     xkb_context_unref(context);
 }
 
+static void
+test_keymap_cache(void)
+{
+    struct xkb_context *context = test_get_context(0);
+    const struct xkb_rule_names names = { .layout = "us,de" };
+    const struct xkb_rule_names other_names = { .layout = "us" };
+    struct xkb_keymap *keymap, *keymap2, *other;
+    char *dump;
+
+    assert(context);
+
+    /* Identical keymaps from names are shared. */
+    keymap = xkb_keymap_new_from_names(context, &names,
+                                       XKB_KEYMAP_COMPILE_USE_CACHE);
+    assert(keymap);
+    keymap2 = xkb_keymap_new_from_names(context, &names,
+                                        XKB_KEYMAP_COMPILE_USE_CACHE);
+    assert(keymap2 == keymap);
+    xkb_keymap_unref(keymap2);
+
+    /* Only if asked to. */
+    other = xkb_keymap_new_from_names(context, &names, 0);
+    assert(other && other != keymap);
+    xkb_keymap_unref(other);
+
+    /* Also with a keymap compiled from its string, twice. */
+    dump = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+    assert(dump);
+    keymap2 = xkb_keymap_new_from_string(context, dump,
+                                         XKB_KEYMAP_FORMAT_TEXT_V1,
+                                         XKB_KEYMAP_COMPILE_USE_CACHE);
+    assert(keymap2 == keymap);
+    xkb_keymap_unref(keymap2);
+    keymap2 = xkb_keymap_new_from_buffer(context, dump, strlen(dump),
+                                         XKB_KEYMAP_FORMAT_TEXT_V1,
+                                         XKB_KEYMAP_COMPILE_USE_CACHE);
+    assert(keymap2 == keymap);
+    xkb_keymap_unref(keymap2);
+
+    /* A different keymap isn't. */
+    other = xkb_keymap_new_from_names(context, &other_names,
+                                      XKB_KEYMAP_COMPILE_USE_CACHE);
+    assert(other && other != keymap);
+    xkb_keymap_unref(other);
+
+    /* A freed keymap leaves the cache. */
+    xkb_keymap_unref(keymap);
+    assert(darray_empty(context->keymap_cache));
+    keymap = xkb_keymap_new_from_string(context, dump,
+                                        XKB_KEYMAP_FORMAT_TEXT_V1,
+                                        XKB_KEYMAP_COMPILE_USE_CACHE);
+    assert(keymap);
+    assert(!darray_empty(context->keymap_cache));
+    xkb_keymap_unref(keymap);
+    assert(darray_empty(context->keymap_cache));
+
+    free(dump);
+    xkb_context_unref(context);
+}
+
+static void
+test_shared_parts(void)
+{
+    struct xkb_context *context = test_get_context(0);
+    struct xkb_keymap *us, *us_de, *us_de2;
+    const struct xkb_key *us_key, *us_de_key;
+    xkb_keycode_t kc;
+
+    assert(context);
+
+    us = test_compile_rules(context, NULL, NULL, "us", NULL, NULL);
+    assert(us);
+    us_de = test_compile_rules(context, NULL, NULL, "us,de", NULL, NULL);
+    assert(us_de);
+
+    /* The types are the same, and so are the levels of the first layout. */
+    assert(us->types == us_de->types);
+    kc = xkb_keymap_key_by_name(us, "AD06");
+    us_key = XkbKey(us, kc);
+    us_de_key = XkbKey(us_de, kc);
+    assert(us_key->num_groups == 1 && us_de_key->num_groups == 2);
+    assert(us_key->groups[0].levels == us_de_key->groups[0].levels);
+    assert(us_key->groups != us_de_key->groups);
+
+    /* The same keymap twice shares all of the keys. */
+    us_de2 = test_compile_rules(context, NULL, NULL, "us,de", NULL, NULL);
+    assert(us_de2 && us_de2 != us_de);
+    assert(XkbKey(us_de2, kc)->groups == us_de_key->groups);
+
+    /* The shared parts outlive any one keymap. */
+    xkb_keymap_unref(us_de);
+    us_de_key = XkbKey(us_de2, kc);
+    assert(us_de_key->groups[1].levels[0].u.sym == XKB_KEY_z);
+    xkb_keymap_unref(us);
+    xkb_keymap_unref(us_de2);
+    assert(context->num_shared_blocks == 0);
+
+    xkb_context_unref(context);
+}
+
 int
 main(void)
 {
     test_garbage_key();
     test_keymap();
+    test_keymap_cache();
+    test_shared_parts();
 
     return 0;
 }
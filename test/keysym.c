@@ -85,6 +85,48 @@ test_utf8(xkb_keysym_t keysym, const char *expected)
     return streq(s, expected);
 }
 
+static void
+test_keysyms_to_utf8(void)
+{
+    const xkb_keysym_t keysyms[] = {
+        XKB_KEY_a, XKB_KEY_eacute, XKB_KEY_Shift_L, XKB_KEY_EuroSign,
+        XKB_KEY_Return, 0x101F609, XKB_KEY_z,
+    };
+    const char expected[] = "a\xc3\xa9\xe2\x82\xac\r\xf0\x9f\x98\x89z";
+    const size_t expected_offsets[] = { 0, 1, 3, 3, 6, 7, 11 };
+    size_t offsets[ARRAY_SIZE(keysyms)];
+    char s[32];
+    int ret;
+
+    ret = xkb_keysyms_to_utf8(keysyms, ARRAY_SIZE(keysyms), s, sizeof(s),
+                              offsets);
+    assert(ret == (int) strlen(expected));
+    assert(streq(s, expected));
+    for (size_t i = 0; i < ARRAY_SIZE(keysyms); i++)
+        assert(offsets[i] == expected_offsets[i]);
+
+    /* Same result as the one-at-a-time function. */
+    for (xkb_keysym_t ks = 0; ks <= 0xffff; ks++) {
+        char single[7];
+        int len = xkb_keysym_to_utf8(ks, single, sizeof(single));
+        ret = xkb_keysyms_to_utf8(&ks, 1, s, sizeof(s), NULL);
+        assert(ret == (len > 0 ? len - 1 : 0));
+        assert(ret == 0 || streq(s, single));
+    }
+
+    /* Size query. */
+    ret = xkb_keysyms_to_utf8(keysyms, ARRAY_SIZE(keysyms), NULL, 0, NULL);
+    assert(ret == (int) strlen(expected));
+
+    /* Truncation never splits a UTF-8 sequence. */
+    ret = xkb_keysyms_to_utf8(keysyms, ARRAY_SIZE(keysyms), s, 3, NULL);
+    assert(ret == (int) strlen(expected));
+    assert(streq(s, "a"));
+    ret = xkb_keysyms_to_utf8(keysyms, ARRAY_SIZE(keysyms), s, 9, NULL);
+    assert(ret == (int) strlen(expected));
+    assert(streq(s, "a\xc3\xa9\xe2\x82\xac\r"));
+}
+
 static void
 test_github_issue_42(void)
 {
@@ -127,6 +169,71 @@ test_utf32_to_keysym(uint32_t ucs, xkb_keysym_t expected)
     return expected == actual;
 }
 
+/* Check the case mapping invariants over the whole keysym space. */
+static void
+test_case_mapping_exhaustive(void)
+{
+    for (xkb_keysym_t ks = 0; ks <= 0x0110ffff; ks++) {
+        xkb_keysym_t lower, upper;
+
+        if (ks == 0x10000)
+            ks = 0x01000000;
+
+        lower = xkb_keysym_to_lower(ks);
+        upper = xkb_keysym_to_upper(ks);
+
+        assert(xkb_keysym_is_lower(ks) == (lower != upper && ks == lower));
+        assert(xkb_keysym_is_upper(ks) == (lower != upper && ks == upper));
+
+        if (ks >= 0x01000000) {
+            /* Unicode keysyms map to Unicode keysyms. */
+            assert(lower >= 0x01000000 && lower <= 0x0110ffff);
+            assert(upper >= 0x01000000 && upper <= 0x0110ffff);
+        }
+        else if (ks < 0x100) {
+            /* Latin-1 keysyms map like their Unicode counterparts. */
+            assert(lower == (xkb_keysym_to_lower(ks | 0x01000000) & 0xffffff));
+            assert(upper == (xkb_keysym_to_upper(ks | 0x01000000) & 0xffffff));
+        }
+        else {
+            /* Legacy keysyms map to legacy keysyms of the Unicode case. */
+            uint32_t cp = xkb_keysym_to_utf32(ks);
+            assert(lower <= 0xffff && upper <= 0xffff);
+            if (cp == 0)
+                continue;
+            if (lower != ks)
+                assert(xkb_keysym_to_utf32(lower) ==
+                       xkb_keysym_to_lower(cp | 0x01000000) - 0x01000000);
+            if (upper != ks)
+                assert(xkb_keysym_to_utf32(upper) ==
+                       xkb_keysym_to_upper(cp | 0x01000000) - 0x01000000);
+        }
+    }
+}
+
+static void
+test_utf32_to_keysyms(void)
+{
+    uint32_t ucs[0x3200];
+    xkb_keysym_t keysyms[ARRAY_SIZE(ucs)];
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(ucs); i++)
+        ucs[i] = i;
+
+    xkb_utf32_to_keysyms(ucs, ARRAY_SIZE(ucs), keysyms);
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(ucs); i++)
+        assert(keysyms[i] == xkb_utf32_to_keysym(ucs[i]));
+
+    /* Every legacy keysym must round-trip to its codepoint. */
+    for (xkb_keysym_t ks = 0; ks <= 0xffff; ks++) {
+        uint32_t cp = xkb_keysym_to_utf32(ks);
+        if (cp == 0)
+            continue;
+        assert(xkb_keysym_to_utf32(xkb_utf32_to_keysym(cp)) == cp);
+    }
+}
+
 int
 main(void)
 {
@@ -248,6 +355,13 @@ main(void)
     assert(test_utf32_to_keysym(0x110000, XKB_KEY_NoSymbol));
     assert(test_utf32_to_keysym(0xdeadbeef, XKB_KEY_NoSymbol));
 
+    // Duplicate codepoints resolve to the lowest keysym
+    assert(test_utf32_to_keysym(0x20ac, 0x13a4));
+    assert(test_utf32_to_keysym(0x2500, XKB_KEY_horizconnector));
+    assert(test_utf32_to_keysym(0x318e, XKB_KEY_Hangul_AraeAE));
+
+    test_utf32_to_keysyms();
+
     assert(xkb_keysym_is_lower(XKB_KEY_a));
     assert(xkb_keysym_is_lower(XKB_KEY_Greek_lambda));
     assert(xkb_keysym_is_lower(xkb_keysym_from_name("U03b1", 0))); /* GREEK SMALL LETTER ALPHA */
@@ -288,6 +402,23 @@ main(void)
     assert(xkb_keysym_to_lower(XKB_KEY_Greek_LAMBDA) == XKB_KEY_Greek_lambda);
     assert(xkb_keysym_to_upper(XKB_KEY_eacute) == XKB_KEY_Eacute);
     assert(xkb_keysym_to_lower(XKB_KEY_Eacute) == XKB_KEY_eacute);
+    assert(xkb_keysym_to_upper(XKB_KEY_ssharp) == 0x1e9e);
+    assert(xkb_keysym_to_upper(XKB_KEY_ydiaeresis) == 0x178);
+    assert(xkb_keysym_to_upper(XKB_KEY_Greek_finalsmallsigma) == XKB_KEY_Greek_finalsmallsigma);
+    assert(xkb_keysym_to_lower(0x1001e9e) == 0x10000df); /* LATIN CAPITAL LETTER SHARP S */
+    assert(xkb_keysym_to_upper(0x10000df) == 0x1001e9e); /* LATIN SMALL LETTER SHARP S */
+    assert(xkb_keysym_to_upper(0x1000180) == 0x1000243); /* LATIN SMALL LETTER B WITH STROKE */
+    assert(xkb_keysym_to_lower(0x10013a0) == 0x100ab70); /* CHEROKEE LETTER A */
+    assert(xkb_keysym_to_upper(0x1002d00) == 0x10010a0); /* GEORGIAN SMALL LETTER AN */
+    assert(xkb_keysym_to_lower(0x101e900) == 0x101e922); /* ADLAM CAPITAL LETTER ALIF */
+    assert(xkb_keysym_is_upper(0x101e900));
+    assert(xkb_keysym_is_lower(0x101e922));
+    assert(!xkb_keysym_is_lower(0x10001c5)); /* LATIN CAPITAL LETTER D WITH SMALL LETTER Z WITH CARON */
+    assert(!xkb_keysym_is_upper(0x10001c5));
+
+    test_case_mapping_exhaustive();
+
+    test_keysyms_to_utf8();
 
     test_github_issue_42();
 
@@ -31,6 +31,8 @@
 #include <stdio.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <dirent.h>
+#include <fcntl.h>
 
 #include "xkbcommon/xkbregistry.h"
 
@@ -831,6 +833,381 @@ test_invalid_include(void)
     rxkb_context_unref(ctx);
 }
 
+static void
+write_rules_file(const char *dir, const char *ruleset, const char *contents)
+{
+    char *path = asprintf_safe("%s/rules/%s.xml", dir, ruleset);
+    FILE *fp;
+
+    assert(path);
+    fp = fopen(path, "w");
+    assert(fp);
+    fputs(contents, fp);
+    fclose(fp);
+    free(path);
+}
+
+static struct rxkb_context *
+parse_two_dirs(const char *userdir, const char *sysdir, const char *ruleset,
+               enum rxkb_context_flags flags)
+{
+    struct rxkb_context *ctx;
+
+    ctx = rxkb_context_new(RXKB_CONTEXT_NO_DEFAULT_INCLUDES | flags);
+    assert(ctx);
+    assert(rxkb_context_include_path_append(ctx, userdir));
+    assert(rxkb_context_include_path_append(ctx, sysdir));
+    assert(rxkb_context_parse(ctx, ruleset));
+    assert(find_model(ctx, "m1"));
+    assert(find_layout(ctx, "l1", NO_VARIANT));
+    return ctx;
+}
+
+static void
+test_invalid_document(void)
+{
+    struct test_model system_models[] =  {
+        {"m1", "vendor1", "desc1"},
+        {NULL},
+    };
+    struct test_layout system_layouts[] =  {
+        {"l1", NO_VARIANT, "lbrief1", "ldesc1"},
+        {NULL},
+    };
+    const char *ruleset = "xkbtests";
+    struct rxkb_context *ctx;
+    char *sysdir, *userdir;
+
+    sysdir = test_create_rules(ruleset, system_models, system_layouts, NULL);
+    /* Overwritten below with a document which is invalid halfway. */
+    userdir = test_create_rules(ruleset, NULL, NULL, NULL);
+    write_rules_file(userdir, ruleset,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<xkbConfigRegistry version=\"1.1\">\n"
+        "<modelList>\n"
+        "  <model><configItem><name>m2</name></configItem></model>\n"
+        "</modelList>\n"
+        "<layoutList>\n"
+        "  <layout><configItem><name>l2</name></configItem></layout>\n"
+        "  <layout><configItem><name>l3</name><bogus/></configItem></layout>\n"
+        "</layoutList>\n"
+        "</xkbConfigRegistry>\n");
+
+    /* Nothing from the invalid document is kept. */
+    ctx = parse_two_dirs(userdir, sysdir, ruleset, RXKB_CONTEXT_NO_FLAGS);
+    assert(!find_model(ctx, "m2"));
+    assert(!find_layout(ctx, "l2", NO_VARIANT));
+    assert(!find_layout(ctx, "l3", NO_VARIANT));
+    rxkb_context_unref(ctx);
+
+    /* Without validation, the unknown element is just skipped. */
+    ctx = parse_two_dirs(userdir, sysdir, ruleset,
+                         RXKB_CONTEXT_NO_VALIDATION);
+    assert(find_model(ctx, "m2"));
+    assert(find_layout(ctx, "l2", NO_VARIANT));
+    assert(find_layout(ctx, "l3", NO_VARIANT));
+    rxkb_context_unref(ctx);
+
+    /* But nothing is kept from a document which is not well-formed. */
+    write_rules_file(userdir, ruleset,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<xkbConfigRegistry version=\"1.1\">\n"
+        "<modelList>\n"
+        "  <model><configItem><name>m2</name></configItem></model>\n"
+        "</modelList>\n"
+        "<layoutList>\n"
+        "  <layout><configItem><name>l2</name></configItem></layout>\n"
+        "  <layout><configItem><name>l3</name></layout>\n"
+        "</layoutList>\n"
+        "</xkbConfigRegistry>\n");
+    ctx = parse_two_dirs(userdir, sysdir, ruleset,
+                         RXKB_CONTEXT_NO_VALIDATION);
+    assert(!find_model(ctx, "m2"));
+    assert(!find_layout(ctx, "l2", NO_VARIANT));
+    assert(!find_layout(ctx, "l3", NO_VARIANT));
+    rxkb_context_unref(ctx);
+
+    test_remove_rules(sysdir, ruleset);
+    test_remove_rules(userdir, ruleset);
+}
+
+static void
+assert_same_items(struct rxkb_context *a, struct rxkb_context *b)
+{
+    struct rxkb_model *ma = rxkb_model_first(a), *mb = rxkb_model_first(b);
+    struct rxkb_layout *la = rxkb_layout_first(a), *lb = rxkb_layout_first(b);
+    struct rxkb_option_group *ga = rxkb_option_group_first(a),
+                             *gb = rxkb_option_group_first(b);
+
+    for (; ma && mb; ma = rxkb_model_next(ma), mb = rxkb_model_next(mb)) {
+        assert(streq(rxkb_model_get_name(ma), rxkb_model_get_name(mb)));
+        assert(streq_null(rxkb_model_get_vendor(ma),
+                          rxkb_model_get_vendor(mb)));
+        assert(streq_null(rxkb_model_get_description(ma),
+                          rxkb_model_get_description(mb)));
+        assert(rxkb_model_get_popularity(ma) == rxkb_model_get_popularity(mb));
+    }
+    assert(!ma && !mb);
+
+    for (; la && lb; la = rxkb_layout_next(la), lb = rxkb_layout_next(lb)) {
+        struct rxkb_iso639_code *ia = rxkb_layout_get_iso639_first(la),
+                                *ib = rxkb_layout_get_iso639_first(lb);
+        struct rxkb_iso3166_code *ca = rxkb_layout_get_iso3166_first(la),
+                                 *cb = rxkb_layout_get_iso3166_first(lb);
+
+        assert(streq(rxkb_layout_get_name(la), rxkb_layout_get_name(lb)));
+        assert(streq_null(rxkb_layout_get_variant(la),
+                          rxkb_layout_get_variant(lb)));
+        assert(streq_null(rxkb_layout_get_brief(la),
+                          rxkb_layout_get_brief(lb)));
+        assert(streq_null(rxkb_layout_get_description(la),
+                          rxkb_layout_get_description(lb)));
+        assert(rxkb_layout_get_popularity(la) ==
+               rxkb_layout_get_popularity(lb));
+        for (; ia && ib;
+             ia = rxkb_iso639_code_next(ia), ib = rxkb_iso639_code_next(ib))
+            assert(streq(rxkb_iso639_code_get_code(ia),
+                         rxkb_iso639_code_get_code(ib)));
+        assert(!ia && !ib);
+        for (; ca && cb;
+             ca = rxkb_iso3166_code_next(ca), cb = rxkb_iso3166_code_next(cb))
+            assert(streq(rxkb_iso3166_code_get_code(ca),
+                         rxkb_iso3166_code_get_code(cb)));
+        assert(!ca && !cb);
+    }
+    assert(!la && !lb);
+
+    for (; ga && gb;
+         ga = rxkb_option_group_next(ga), gb = rxkb_option_group_next(gb)) {
+        struct rxkb_option *oa = rxkb_option_first(ga),
+                           *ob = rxkb_option_first(gb);
+
+        assert(streq(rxkb_option_group_get_name(ga),
+                     rxkb_option_group_get_name(gb)));
+        assert(streq_null(rxkb_option_group_get_description(ga),
+                          rxkb_option_group_get_description(gb)));
+        assert(rxkb_option_group_get_popularity(ga) ==
+               rxkb_option_group_get_popularity(gb));
+        assert(rxkb_option_group_allows_multiple(ga) ==
+               rxkb_option_group_allows_multiple(gb));
+        for (; oa && ob; oa = rxkb_option_next(oa), ob = rxkb_option_next(ob)) {
+            assert(streq(rxkb_option_get_name(oa), rxkb_option_get_name(ob)));
+            assert(streq_null(rxkb_option_get_brief(oa),
+                              rxkb_option_get_brief(ob)));
+            assert(streq_null(rxkb_option_get_description(oa),
+                              rxkb_option_get_description(ob)));
+            assert(rxkb_option_get_popularity(oa) ==
+                   rxkb_option_get_popularity(ob));
+        }
+        assert(!oa && !ob);
+    }
+    assert(!ga && !gb);
+}
+
+static struct rxkb_context *
+test_parse_with_flags(const char *path, const char *ruleset,
+                      enum rxkb_context_flags flags)
+{
+    struct rxkb_context *ctx;
+
+    ctx = rxkb_context_new(RXKB_CONTEXT_NO_DEFAULT_INCLUDES | flags);
+    assert(ctx);
+    assert(rxkb_context_include_path_append(ctx, path));
+    assert(rxkb_context_parse(ctx, ruleset));
+    return ctx;
+}
+
+static void
+test_find_and_search(void)
+{
+    const char *srcdir = getenv("top_srcdir");
+    char *datadir;
+    struct rxkb_context *ctx;
+    struct rxkb_layout *layouts[8], *l;
+    size_t count, num_layouts = 0;
+
+    datadir = asprintf_safe("%s/test/data", srcdir ? srcdir : ".");
+    assert(datadir);
+
+    /* Not parsed yet. */
+    ctx = rxkb_context_new(RXKB_CONTEXT_NO_DEFAULT_INCLUDES |
+                           RXKB_CONTEXT_LOAD_EXOTIC_RULES);
+    assert(ctx);
+    assert(rxkb_context_include_path_append(ctx, datadir));
+    assert(!rxkb_layout_find(ctx, "us", NULL));
+    assert(rxkb_layout_search(ctx, "", NULL, 0) == 0);
+    assert(rxkb_context_parse(ctx, "evdev"));
+    free(datadir);
+
+    /* Every item can be looked up by its name. */
+    for (struct rxkb_model *m = rxkb_model_first(ctx); m;
+         m = rxkb_model_next(m))
+        assert(streq(rxkb_model_get_name(rxkb_model_find(ctx,
+                     rxkb_model_get_name(m))), rxkb_model_get_name(m)));
+    for (l = rxkb_layout_first(ctx); l; l = rxkb_layout_next(l)) {
+        struct rxkb_layout *found =
+            rxkb_layout_find(ctx, rxkb_layout_get_name(l),
+                             rxkb_layout_get_variant(l));
+        assert(streq(rxkb_layout_get_name(found), rxkb_layout_get_name(l)));
+        assert(streq_null(rxkb_layout_get_variant(found),
+                          rxkb_layout_get_variant(l)));
+        num_layouts++;
+    }
+    for (struct rxkb_option_group *g = rxkb_option_group_first(ctx); g;
+         g = rxkb_option_group_next(g)) {
+        assert(streq(rxkb_option_group_get_name(rxkb_option_group_find(ctx,
+                     rxkb_option_group_get_name(g))),
+                     rxkb_option_group_get_name(g)));
+        for (struct rxkb_option *o = rxkb_option_first(g); o;
+             o = rxkb_option_next(o))
+            assert(streq(rxkb_option_get_name(rxkb_option_find(ctx,
+                         rxkb_option_get_name(o))), rxkb_option_get_name(o)));
+    }
+
+    assert(rxkb_model_find(ctx, "pc105"));
+    assert(!rxkb_model_find(ctx, "pc106"));
+    l = rxkb_layout_find(ctx, "us", NULL);
+    assert(l && !rxkb_layout_get_variant(l));
+    l = rxkb_layout_find(ctx, "us", "intl");
+    assert(l && streq(rxkb_layout_get_variant(l), "intl"));
+    assert(!rxkb_layout_find(ctx, "us", ""));
+    assert(!rxkb_layout_find(ctx, "us", "nope"));
+    assert(rxkb_option_group_find(ctx, "grp"));
+    assert(streq(rxkb_option_get_name(rxkb_option_find(ctx, "grp:alt_shift_toggle")),
+                 "grp:alt_shift_toggle"));
+    assert(!rxkb_option_find(ctx, "grp"));
+
+    /* An empty query matches everything. */
+    assert(rxkb_layout_search(ctx, "", NULL, 0) == num_layouts);
+    assert(rxkb_layout_search(ctx, " ,", NULL, 0) == num_layouts);
+
+    /* Prefixes of the words of the description, case-insensitive. */
+    count = rxkb_layout_search(ctx, "fre SWITZ", layouts, ARRAY_SIZE(layouts));
+    assert(count >= 1 && count <= ARRAY_SIZE(layouts));
+    for (size_t i = 0; i < count; i++) {
+        assert(strstr(rxkb_layout_get_description(layouts[i]), "French"));
+        assert(strstr(rxkb_layout_get_description(layouts[i]), "Switzerland"));
+    }
+    assert(rxkb_layout_search(ctx, "switz fre", NULL, 0) == count);
+
+    /* Names and codes. */
+    count = rxkb_layout_search(ctx, "us intl", layouts, ARRAY_SIZE(layouts));
+    assert(count >= 1);
+    assert(layouts[0] == rxkb_layout_find(ctx, "us", "intl"));
+    assert(rxkb_layout_search(ctx, "xyzzy", layouts, 0) == 0);
+
+    /* Results are truncated, in the list order. */
+    count = rxkb_layout_search(ctx, "e", layouts, 2);
+    assert(count > 2);
+    for (l = rxkb_layout_first(ctx); l != layouts[0]; l = rxkb_layout_next(l))
+        ;
+    assert(l);
+
+    rxkb_context_unref(ctx);
+}
+
+static void
+set_mtime(const char *path, time_t sec, long nsec)
+{
+    struct timespec times[2] = { { sec, nsec }, { sec, nsec } };
+    assert(utimensat(AT_FDCWD, path, times, 0) == 0);
+}
+
+static void
+test_cache(void)
+{
+    struct test_model models1[] = { {"m1", "vendor1", "desc1"}, {NULL} };
+    struct test_model models2[] = { {"m2", "vendor2", "desc2"}, {NULL} };
+    char cache_home[] = "/tmp/xkbregistry-cache.XXXXXX";
+    const char *ruleset = "xkbtests";
+    const char *srcdir;
+    char *datadir, *dir, *dir2, *rules, *rules2, *cache_dir, *cache_path;
+    struct rxkb_context *ctx, *cached;
+    struct rxkb_model *m;
+    struct dirent *entry;
+    DIR *d;
+
+    assert(mkdtemp(cache_home));
+    setenv("XDG_CACHE_HOME", cache_home, 1);
+    cache_dir = asprintf_safe("%s/xkbcommon", cache_home);
+    assert(cache_dir);
+
+    /* A real registry: the cached items are exactly the parsed ones. */
+    srcdir = getenv("top_srcdir");
+    datadir = asprintf_safe("%s/test/data", srcdir ? srcdir : ".");
+    assert(datadir);
+    ctx = test_parse_with_flags(datadir, "evdev",
+                                RXKB_CONTEXT_LOAD_EXOTIC_RULES);
+    for (int i = 0; i < 2; i++) {
+        cached = test_parse_with_flags(datadir, "evdev",
+                                       RXKB_CONTEXT_LOAD_EXOTIC_RULES |
+                                       RXKB_CONTEXT_USE_CACHE);
+        assert_same_items(ctx, cached);
+        rxkb_context_unref(cached);
+    }
+    rxkb_context_unref(ctx);
+    free(datadir);
+
+    /*
+     * The cache only looks at the size and modification time, so a
+     * change which keeps both proves the cache is actually used.
+     */
+    dir = test_create_rules(ruleset, models1, NULL, NULL);
+    dir2 = test_create_rules(ruleset, models2, NULL, NULL);
+    rules = asprintf_safe("%s/rules/%s.xml", dir, ruleset);
+    rules2 = asprintf_safe("%s/rules/%s.xml", dir2, ruleset);
+    assert(rules && rules2);
+    set_mtime(rules, 1000000000, 0);
+
+    for (int i = 0; i < 2; i++) {
+        ctx = test_parse_with_flags(dir, ruleset, RXKB_CONTEXT_USE_CACHE);
+        assert(find_model(ctx, "m1"));
+        rxkb_context_unref(ctx);
+    }
+
+    assert(rename(rules2, rules) == 0);
+    set_mtime(rules, 1000000000, 0);
+    ctx = test_parse_with_flags(dir, ruleset, RXKB_CONTEXT_USE_CACHE);
+    assert(find_model(ctx, "m1"));
+    assert(!find_model(ctx, "m2"));
+    rxkb_context_unref(ctx);
+
+    /* Without the flag, the cache is not used. */
+    ctx = test_parse_with_flags(dir, ruleset, RXKB_CONTEXT_NO_FLAGS);
+    assert(find_model(ctx, "m2"));
+    rxkb_context_unref(ctx);
+
+    /* A changed file makes the cache stale, even within the same second. */
+    set_mtime(rules, 1000000000, 500000000);
+    ctx = test_parse_with_flags(dir, ruleset, RXKB_CONTEXT_USE_CACHE);
+    m = fetch_model(ctx, "m2");
+    assert(cmp_models(&models2[0], m));
+    rxkb_model_unref(m);
+    assert(!find_model(ctx, "m1"));
+    rxkb_context_unref(ctx);
+
+    test_remove_rules(dir, ruleset);
+    test_remove_rules(dir2, ruleset);
+    free(rules);
+    free(rules2);
+
+    d = opendir(cache_dir);
+    assert(d);
+    while ((entry = readdir(d))) {
+        if (entry->d_name[0] == '.')
+            continue;
+        cache_path = asprintf_safe("%s/%s", cache_dir, entry->d_name);
+        assert(cache_path);
+        unlink(cache_path);
+        free(cache_path);
+    }
+    closedir(d);
+    rmdir(cache_dir);
+    rmdir(cache_home);
+    free(cache_dir);
+    unsetenv("XDG_CACHE_HOME");
+}
+
 int
 main(void)
 {
@@ -841,6 +1218,9 @@ main(void)
     test_load_merge();
     test_load_merge_no_overwrite();
     test_popularity();
+    test_invalid_document();
+    test_find_and_search();
+    test_cache();
 
     return 0;
 }
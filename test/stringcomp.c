@@ -26,17 +26,60 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef HAVE_MEMFD_CREATE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include "test.h"
 
 #define DATA_PATH "keymaps/stringcomp.data"
 
+static void
+test_get_as_fd(struct xkb_keymap *keymap, const char *dump)
+{
+#ifdef HAVE_MEMFD_CREATE
+    size_t size, size2;
+    int fd, fd2;
+    char *map;
+
+    fd = xkb_keymap_get_as_fd(keymap, XKB_KEYMAP_USE_ORIGINAL_FORMAT, &size);
+    assert(fd >= 0);
+    assert(size == strlen(dump) + 1);
+
+    map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    assert(map != MAP_FAILED);
+    assert(streq(map, dump));
+    munmap(map, size);
+
+    /* The file can't be changed by whoever receives it. */
+    assert(mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) ==
+           MAP_FAILED);
+    assert(write(fd, "x", 1) < 0);
+    assert(ftruncate(fd, 0) < 0);
+
+    /* The same file is handed out again. */
+    fd2 = xkb_keymap_get_as_fd(keymap, XKB_KEYMAP_FORMAT_TEXT_V1, &size2);
+    assert(fd2 >= 0 && fd2 != fd);
+    assert(size2 == size);
+    close(fd2);
+    close(fd);
+
+    assert(xkb_keymap_get_as_fd(keymap, 0, NULL) < 0);
+#else
+    assert(xkb_keymap_get_as_fd(keymap, XKB_KEYMAP_USE_ORIGINAL_FORMAT,
+                                NULL) < 0);
+#endif
+}
+
 int
 main(int argc, char *argv[])
 {
     struct xkb_context *ctx = test_get_context(0);
-    struct xkb_keymap *keymap;
+    struct xkb_keymap *keymap, *other;
     char *original, *dump, *dump2;
+    const uint8_t *fingerprint;
 
     assert(ctx);
 
@@ -88,6 +131,28 @@ main(int argc, char *argv[])
     assert(dump2);
     assert(streq(dump, dump2));
 
+    /* The recompiled keymap is equivalent, so has the same fingerprint. */
+    fingerprint = xkb_keymap_get_fingerprint(keymap);
+    assert(fingerprint);
+    assert(xkb_keymap_get_fingerprint(keymap) == fingerprint);
+    other = test_compile_rules(ctx, NULL, NULL,
+                               "ru,ca,de,us", ",multix,neo,intl", NULL);
+    assert(other);
+    assert(memcmp(xkb_keymap_get_fingerprint(other), fingerprint,
+                  XKB_KEYMAP_FINGERPRINT_SIZE) == 0);
+    xkb_keymap_unref(other);
+    other = test_compile_rules(ctx, NULL, NULL, "us", NULL, NULL);
+    assert(other);
+    assert(memcmp(xkb_keymap_get_fingerprint(other), fingerprint,
+                  XKB_KEYMAP_FINGERPRINT_SIZE) != 0);
+    xkb_keymap_unref(other);
+
+    /* Repeated dumps are equal, but each is owned by the caller. */
+    free(dump2);
+    dump2 = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_USE_ORIGINAL_FORMAT);
+    assert(dump2);
+    assert(streq(dump, dump2));
+
     /* Test response to invalid formats and flags. */
     assert(!xkb_keymap_new_from_string(ctx, dump, 0, 0));
     assert(!xkb_keymap_new_from_string(ctx, dump, -1, 0));
@@ -97,6 +162,8 @@ main(int argc, char *argv[])
     assert(!xkb_keymap_get_as_string(keymap, 0));
     assert(!xkb_keymap_get_as_string(keymap, 4893));
 
+    test_get_as_fd(keymap, dump2);
+
     xkb_keymap_unref(keymap);
     free(dump);
     free(dump2);
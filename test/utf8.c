@@ -175,11 +175,130 @@ test_utf32_to_utf8(void)
     check_utf32_to_utf8(0xffffffff, 0, "");
 }
 
+/* Straightforward byte-by-byte decoder, to check the optimized ones. */
+static bool
+reference_utf8_to_utf32(const uint8_t *s, size_t len, uint32_t *out,
+                        size_t *count)
+{
+    size_t i = 0, n = 0;
+
+    while (i < len) {
+        uint32_t cp;
+        size_t tail;
+
+        if (s[i] < 0x80) { cp = s[i]; tail = 0; }
+        else if ((s[i] & 0xE0) == 0xC0) { cp = s[i] & 0x1F; tail = 1; }
+        else if ((s[i] & 0xF0) == 0xE0) { cp = s[i] & 0x0F; tail = 2; }
+        else if ((s[i] & 0xF8) == 0xF0) { cp = s[i] & 0x07; tail = 3; }
+        else return false;
+
+        if (len - i <= tail)
+            return false;
+        for (size_t j = 1; j <= tail; j++) {
+            if ((s[i + j] & 0xC0) != 0x80)
+                return false;
+            cp = (cp << 6) | (s[i + j] & 0x3F);
+        }
+
+        /* Reject overlong forms, surrogates and out of range values. */
+        if ((tail == 1 && cp < 0x80) || (tail == 2 && cp < 0x800) ||
+            (tail == 3 && cp < 0x10000) || cp > 0x10FFFF ||
+            (cp >= 0xD800 && cp <= 0xDFFF))
+            return false;
+
+        out[n++] = cp;
+        i += tail + 1;
+    }
+
+    *count = n;
+    return true;
+}
+
+static void
+test_utf8_random(void)
+{
+    /* Pieces from which to build random, mostly valid, strings. */
+    static const char *const pieces[] = {
+        "a", "abcdefgh", "0123456789abcdef", " ", "\x7F", "\x00",
+        "\xC2\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xED\x9F\xBF",
+        "\xEF\xBF\xBD", "\xF0\x90\x80\x80", "\xF4\x8F\xBF\xBF",
+        "\x80", "\xC0\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80",
+        "\xE0\x80", "\xF8", "\xFF", "\xC2", "\xE1\x80",
+    };
+    uint8_t buf[128];
+    uint32_t expected[128], actual[128];
+    size_t expected_count, actual_count;
+    unsigned int seed = 0x5eed;
+
+    for (int iter = 0; iter < 200000; iter++) {
+        size_t len = 0;
+        int npieces;
+        bool expected_valid;
+
+        seed = seed * 1103515245 + 12345;
+        npieces = (seed >> 16) % 12;
+        for (int p = 0; p < npieces; p++) {
+            const char *piece;
+            size_t piece_len;
+
+            seed = seed * 1103515245 + 12345;
+            /* Keep invalid pieces rare, so valid strings get long. */
+            if ((seed >> 16) % 8 == 0)
+                piece = pieces[(seed >> 20) % ARRAY_SIZE(pieces)];
+            else
+                piece = pieces[(seed >> 20) % 13];
+            piece_len = piece[0] ? strlen(piece) : 1;
+            if (len + piece_len > sizeof(buf))
+                break;
+            memcpy(buf + len, piece, piece_len);
+            len += piece_len;
+        }
+
+        /* Sometimes flip a random byte. */
+        seed = seed * 1103515245 + 12345;
+        if (len > 0 && (seed >> 16) % 4 == 0)
+            buf[(seed >> 18) % len] ^= (uint8_t) (seed >> 8);
+
+        expected_valid = reference_utf8_to_utf32(buf, len, expected,
+                                                 &expected_count);
+        assert(is_valid_utf8((const char *) buf, len) == expected_valid);
+        assert(utf8_to_utf32((const char *) buf, len, actual,
+                             &actual_count) == expected_valid);
+        if (expected_valid) {
+            assert(actual_count == expected_count);
+            assert(memcmp(actual, expected,
+                          expected_count * sizeof(*expected)) == 0);
+        }
+    }
+}
+
+static void
+test_utf8_to_utf32(void)
+{
+    const char str[] = "ascii \xCE\xBA\xE1\xBD\xB9 \xF0\x9F\x98\x89!";
+    const uint32_t expected[] = {
+        'a', 's', 'c', 'i', 'i', ' ', 0x3BA, 0x1F79, ' ', 0x1F609, '!',
+    };
+    uint32_t out[sizeof(str)];
+    size_t count;
+
+    assert(utf8_to_utf32(str, sizeof(str) - 1, out, &count));
+    assert(count == ARRAY_SIZE(expected));
+    assert(memcmp(out, expected, sizeof(expected)) == 0);
+
+    assert(utf8_to_utf32("", 0, out, &count));
+    assert(count == 0);
+
+    assert(!utf8_to_utf32("abc\xED\xA0\x80", 6, out, &count));
+}
+
 int
 main(void)
 {
     test_is_valid_utf8();
     test_utf32_to_utf8();
+    test_utf8_to_utf32();
+    test_utf8_random();
 
     return 0;
 }
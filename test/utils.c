@@ -30,6 +30,38 @@
 
 #include "test.h"
 #include "utils.h"
+#include "sha256.h"
+
+static void
+check_sha256(const char *input, size_t repeat, const char *expected)
+{
+    struct sha256 sha;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    char hex[2 * SHA256_DIGEST_SIZE + 1];
+
+    sha256_init(&sha);
+    for (size_t i = 0; i < repeat; i++)
+        sha256_update(&sha, input, strlen(input));
+    sha256_final(&sha, digest);
+
+    for (size_t i = 0; i < SHA256_DIGEST_SIZE; i++)
+        sprintf(hex + 2 * i, "%02x", digest[i]);
+    assert(streq(hex, expected));
+}
+
+static void
+test_sha256(void)
+{
+    check_sha256("", 1,
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    check_sha256("abc", 1,
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    check_sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    /* Fed in pieces which don't line up with the blocks. */
+    check_sha256("a", 1000000,
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
 
 int
 main(void)
@@ -52,5 +84,7 @@ main(void)
     assert(!streq_null(NULL, "foobar"));
     assert(streq_null(NULL, NULL));
 
+    test_sha256();
+
     return 0;
 }
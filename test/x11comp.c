@@ -154,6 +154,53 @@ main(void)
         goto err_dump;
     }
 
+    /* Rebuilding from any set of changes must give the same keymap. */
+    for (unsigned changes = 0; changes < (1u << 5); changes++) {
+        struct xkb_keymap *changed;
+        char *changed_dump;
+
+        changed = xkb_x11_keymap_new_from_changes(keymap, conn, device_id,
+                                                  changes);
+        assert(changed);
+        assert((changes == 0) == (changed == keymap));
+
+        changed_dump = xkb_keymap_get_as_string(changed,
+                                                XKB_KEYMAP_USE_ORIGINAL_FORMAT);
+        assert(changed_dump);
+        if (!streq(original, changed_dump)) {
+            fprintf(stderr,
+                    "incremental test failed: dumped map differs from original with changes %#x\n",
+                    changes);
+            free(changed_dump);
+            xkb_keymap_unref(changed);
+            ret = 1;
+            goto err_dump;
+        }
+
+        free(changed_dump);
+        xkb_keymap_unref(changed);
+    }
+
+    /* The keymap is reused while it is alive, keyed by the names. */
+    {
+        struct xkb_keymap *cached, *reused;
+        char *cached_dump;
+
+        cached = xkb_x11_keymap_new_from_device(ctx, conn, device_id,
+                                                XKB_KEYMAP_COMPILE_USE_CACHE);
+        assert(cached && cached != keymap);
+        reused = xkb_x11_keymap_new_from_device(ctx, conn, device_id,
+                                                XKB_KEYMAP_COMPILE_USE_CACHE);
+        assert(reused == cached);
+        xkb_keymap_unref(reused);
+
+        cached_dump = xkb_keymap_get_as_string(cached,
+                                               XKB_KEYMAP_USE_ORIGINAL_FORMAT);
+        assert(cached_dump && streq(original, cached_dump));
+        free(cached_dump);
+        xkb_keymap_unref(cached);
+    }
+
     ret = 0;
 err_dump:
     free(original);
@@ -141,7 +141,30 @@ struct xkb_compose_state;
 /** Flags affecting Compose file compilation. */
 enum xkb_compose_compile_flags {
     /** Do not apply any flags. */
-    XKB_COMPOSE_COMPILE_NO_FLAGS = 0
+    XKB_COMPOSE_COMPILE_NO_FLAGS = 0,
+    /**
+     * Load the compiled table from, and save it to, a per-user cache.
+     *
+     * Only affects xkb_compose_table_new_from_locale().  The cache is
+     * kept in `$XDG_CACHE_HOME/xkbcommon` (with a fall back to
+     * `$HOME/.cache/xkbcommon`), and an entry is only used if none of
+     * the Compose files it was compiled from have changed since.
+     *
+     * @since 1.1.0
+     */
+    XKB_COMPOSE_COMPILE_USE_CACHE = (1 << 0),
+    /**
+     * Compact the table after compiling it.
+     *
+     * Equal result strings are stored once, and equal subtrees of the
+     * sequence trie (e.g. everything following `<dead_acute>` and
+     * `<Multi_key> <apostrophe>`) are shared.  This makes compilation
+     * slower, but the table smaller; composing is not affected.
+     *
+     * @see xkb_compose_table_get_memory_size()
+     * @since 1.1.0
+     */
+    XKB_COMPOSE_COMPILE_COMPACT = (1 << 1)
 };
 
 /** The recognized Compose file formats. */
@@ -279,6 +302,73 @@ xkb_compose_table_new_from_buffer(struct xkb_context *context,
                                   enum xkb_compose_format format,
                                   enum xkb_compose_compile_flags flags);
 
+/**
+ * Create a new compose table as an overlay on top of another table.
+ *
+ * The overlay only holds the sequences compiled from @p file; the base
+ * table is shared, not copied.  This allows to load a large system table
+ * once, and keep only small per-user additions (e.g. the contents of
+ * `~/.XCompose`) in separate overlays.
+ *
+ * When composing with an overlay, the keysyms are looked up in both
+ * tables in parallel.  After each keysym, the state is that of the
+ * overlay if the keysyms fed so far are a sequence or the prefix of a
+ * sequence in the overlay, and that of the base otherwise.  Hence:
+ *
+ * - A sequence in the overlay overrides a sequence with the same keysyms
+ *   in the base.
+ * - A sequence in the overlay completes the composition, so the longer
+ *   sequences in the base which start with it cannot be reached.
+ * - A sequence in the base whose keysyms are only a prefix of sequences in
+ *   the overlay cannot be reached either, since the overlay is still
+ *   composing at that point.
+ * - Sequences in the base which share a prefix with sequences in the
+ *   overlay, but then differ, are not affected.
+ *
+ * Include statements in @p file which refer to a Compose file the base
+ * table was compiled from are skipped, since the base already provides
+ * those sequences.
+ *
+ * The overlay uses the context and locale of the base.  The base itself
+ * cannot be an overlay.
+ *
+ * @param base
+ *     The table to use as the base.  The overlay takes a reference on it.
+ * @param file
+ *     The Compose file to compile.
+ * @param format
+ *     The text format of the Compose file to compile.
+ * @param flags
+ *     Optional flags for the compose table, or 0.
+ *
+ * @returns A compose table compiled from the given file, on top of
+ * @p base, or NULL if the compilation failed.
+ *
+ * @memberof xkb_compose_table
+ * @since 1.1.0
+ */
+struct xkb_compose_table *
+xkb_compose_table_new_overlay_from_file(struct xkb_compose_table *base,
+                                        FILE *file,
+                                        enum xkb_compose_format format,
+                                        enum xkb_compose_compile_flags flags);
+
+/**
+ * Create a new compose table as an overlay, from a memory buffer.
+ *
+ * This is just like xkb_compose_table_new_overlay_from_file(), but
+ * instead of a file, gets the table as one enormous string.
+ *
+ * @see xkb_compose_table_new_overlay_from_file()
+ * @memberof xkb_compose_table
+ * @since 1.1.0
+ */
+struct xkb_compose_table *
+xkb_compose_table_new_overlay_from_buffer(struct xkb_compose_table *base,
+                                          const char *buffer, size_t length,
+                                          enum xkb_compose_format format,
+                                          enum xkb_compose_compile_flags flags);
+
 /**
  * Take a new reference on a compose table.
  *
@@ -299,6 +389,22 @@ xkb_compose_table_ref(struct xkb_compose_table *table);
 void
 xkb_compose_table_unref(struct xkb_compose_table *table);
 
+/**
+ * Get the memory used by the compiled sequences of a compose table.
+ *
+ * This is the size of the data which grows with the Compose file, i.e.
+ * the sequence trie and the result strings.  For an overlay, the base
+ * table is not included.
+ *
+ * @returns The size in bytes.
+ *
+ * @see XKB_COMPOSE_COMPILE_COMPACT
+ * @memberof xkb_compose_table
+ * @since 1.1.0
+ */
+size_t
+xkb_compose_table_get_memory_size(struct xkb_compose_table *table);
+
 /** Flags for compose state creation. */
 enum xkb_compose_state_flags {
     /** Do not apply any flags. */
@@ -491,6 +597,198 @@ xkb_compose_state_get_utf8(struct xkb_compose_state *state,
 xkb_keysym_t
 xkb_compose_state_get_one_sym(struct xkb_compose_state *state);
 
+/**
+ * Feed an array of keysyms to the compose state, and get the resulting
+ * text.
+ *
+ * This is equivalent to calling xkb_compose_state_feed() for each keysym
+ * in turn, and collecting the text a client would produce after each:
+ *
+ * - If the status is XKB_COMPOSE_COMPOSED, the result string, as
+ *   returned by xkb_compose_state_get_utf8().
+ * - If the status is XKB_COMPOSE_NOTHING, the keysym itself, as
+ *   returned by xkb_keysym_to_utf8().
+ * - Otherwise, or if the keysym was ignored, nothing.
+ *
+ * The state is left as after feeding the last keysym.
+ *
+ * @param[in] state
+ *     The compose state.
+ * @param[in] keysyms
+ *     The keysyms to feed.
+ * @param[in] count
+ *     The number of keysyms in @p keysyms.
+ * @param[out] statuses
+ *     An optional array of at least @p count entries.  If not NULL, the
+ *     status after feeding each keysym is written into it.
+ * @param[out] buffer
+ *     A buffer to write the UTF-8 string into.
+ * @param[in] size
+ *     Size of the buffer.
+ *
+ * @warning If the buffer passed is too small, the string is truncated
+ * (though still NUL-terminated), never in the middle of the text of a
+ * keysym.  All the keysyms are fed regardless.
+ *
+ * @returns
+ *   The number of bytes required for the string, excluding the NUL byte.
+ * @returns
+ *   You may check if truncation has occurred by comparing the return value
+ *   with the size of `buffer`, similarly to the `snprintf`(3) function.
+ *   You may safely pass NULL and 0 to `buffer` and `size` to find the
+ *   required size (without the NUL-byte).
+ *
+ * @memberof xkb_compose_state
+ * @since 1.1.0
+ **/
+int
+xkb_compose_state_feed_keysyms(struct xkb_compose_state *state,
+                               const xkb_keysym_t *keysyms, size_t count,
+                               enum xkb_compose_status *statuses,
+                               char *buffer, size_t size);
+
+/**
+ * @struct xkb_text_transducer
+ * Opaque text transducer object.
+ *
+ * A text transducer turns key events into text in a single call.  It
+ * combines an xkb_state for a keymap with an optional xkb_compose_state,
+ * and is equivalent to the usual sequence of:
+ *
+ * 1. xkb_state_key_get_one_sym() for the key,
+ * 2. xkb_compose_state_feed() and xkb_compose_state_get_status(),
+ * 3. xkb_compose_state_get_utf8() if the status is XKB_COMPOSE_COMPOSED,
+ *    or xkb_state_key_get_utf8() if it is XKB_COMPOSE_NOTHING,
+ * 4. xkb_state_update_key().
+ *
+ * Like an xkb_state, the transducer must be given every key event, both
+ * presses and releases, since releases update the modifiers and locks.
+ *
+ * The keysyms and strings of all the key levels of the keymap are
+ * computed when the transducer is created, so the per-key work is
+ * reduced to finding the level of the key.
+ *
+ * @since 1.1.0
+ */
+struct xkb_text_transducer;
+
+/** Flags for text transducer creation. */
+enum xkb_text_transducer_flags {
+    /** Do not apply any flags. */
+    XKB_TEXT_TRANSDUCER_NO_FLAGS = 0
+};
+
+/**
+ * Create a new text transducer.
+ *
+ * @param keymap
+ *     The keymap to translate keys with.
+ * @param table
+ *     The compose table to use, or NULL to not do any composing.
+ * @param flags
+ *     Optional flags for the text transducer, or 0.
+ *
+ * @returns A new text transducer, or NULL on failure.
+ *
+ * @memberof xkb_text_transducer
+ * @since 1.1.0
+ */
+struct xkb_text_transducer *
+xkb_text_transducer_new(struct xkb_keymap *keymap,
+                        struct xkb_compose_table *table,
+                        enum xkb_text_transducer_flags flags);
+
+/**
+ * Take a new reference on a text transducer object.
+ *
+ * @returns The passed in object.
+ *
+ * @memberof xkb_text_transducer
+ * @since 1.1.0
+ */
+struct xkb_text_transducer *
+xkb_text_transducer_ref(struct xkb_text_transducer *transducer);
+
+/**
+ * Release a reference on a text transducer object, and possibly free it.
+ *
+ * @param transducer The object.  If NULL, do nothing.
+ *
+ * @memberof xkb_text_transducer
+ * @since 1.1.0
+ */
+void
+xkb_text_transducer_unref(struct xkb_text_transducer *transducer);
+
+/**
+ * Get the keyboard state of a text transducer.
+ *
+ * The state may be updated directly, e.g. with xkb_state_update_mask()
+ * when the modifiers are managed by a server.
+ *
+ * This function does not take a new reference on the state.
+ *
+ * @memberof xkb_text_transducer
+ * @since 1.1.0
+ */
+struct xkb_state *
+xkb_text_transducer_get_state(struct xkb_text_transducer *transducer);
+
+/**
+ * Get the compose state of a text transducer.
+ *
+ * @returns The compose state, or NULL if the transducer was created
+ * without a compose table.
+ *
+ * This function does not take a new reference on the compose state.
+ *
+ * @memberof xkb_text_transducer
+ * @since 1.1.0
+ */
+struct xkb_compose_state *
+xkb_text_transducer_get_compose_state(struct xkb_text_transducer *transducer);
+
+/**
+ * Translate a key event and update the state of the text transducer.
+ *
+ * Every key event must be passed in, press or release, in the order they
+ * happen.  Only presses produce text, but all events update the keyboard
+ * state, as with xkb_state_update_key(): skipping the release of e.g.
+ * Shift leaves the modifier stuck, and lock changes are missed.
+ *
+ * @param[in] transducer
+ *     The text transducer.
+ * @param[in] key
+ *     The keycode of the key.
+ * @param[in] direction
+ *     Whether the key was pressed or released.  Only presses (and
+ *     repeats) produce text; releases still update the state.
+ * @param[out] buffer
+ *     A buffer to write the UTF-8 string into.
+ * @param[in] size
+ *     Size of the buffer.
+ *
+ * @warning If the buffer passed is too small, the string is truncated
+ * (though still NUL-terminated).
+ *
+ * @returns
+ *   The number of bytes required for the string, excluding the NUL byte.
+ *   If the key produces no text, or is part of an unfinished compose
+ *   sequence, returns 0 and writes an empty string into the buffer.
+ * @returns
+ *   You may check if truncation has occurred by comparing the return value
+ *   with the size of `buffer`, similarly to the `snprintf`(3) function.
+ *   You may safely pass NULL and 0 to `buffer` and `size` to find the
+ *   required size (without the NUL-byte).
+ *
+ * @memberof xkb_text_transducer
+ * @since 1.1.0
+ */
+int
+xkb_text_transducer_key(struct xkb_text_transducer *transducer,
+                        xkb_keycode_t key, enum xkb_key_direction direction,
+                        char *buffer, size_t size);
+
 /** @} */
 
 #ifdef __cplusplus
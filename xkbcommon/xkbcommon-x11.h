@@ -202,6 +202,16 @@ xkb_x11_get_core_keyboard_device_id(xcb_connection_t *connection);
  * @param flags
  *     Optional flags for the keymap, or 0.
  *
+ * If @p flags contains XKB_KEYMAP_COMPILE_USE_CACHE, only the names of
+ * the keycodes, symbols, types and compat components and the keycode
+ * range are fetched first.  If a keymap was previously created with this
+ * flag in the same context from a device reporting the same, it is
+ * returned instead of fetching the keymap again.  Note that the X server
+ * keeps these names when the keymap is modified directly, e.g. by
+ * xmodmap; clients which follow such changes should not use this flag
+ * when handling XkbMapNotify events, but see
+ * xkb_x11_keymap_new_from_changes().
+ *
  * @returns A keymap retrieved from the X server, or NULL on failure.
  *
  * @memberof xkb_keymap
@@ -212,6 +222,64 @@ xkb_x11_keymap_new_from_device(struct xkb_context *context,
                                int32_t device_id,
                                enum xkb_keymap_compile_flags flags);
 
+/**
+ * The parts of the keyboard description of an X11 keyboard device, as
+ * used with xkb_x11_keymap_new_from_changes().
+ *
+ * @since 1.1.0
+ */
+enum xkb_x11_keymap_changes {
+    /**
+     * The key types, symbols, actions, explicit components, modifier
+     * maps and virtual modifiers; reported by XkbMapNotify.
+     * The names and controls are always fetched along with the map.
+     */
+    XKB_X11_KEYMAP_CHANGED_MAP = (1 << 0),
+    /** The indicator maps; reported by XkbIndicatorMapNotify. */
+    XKB_X11_KEYMAP_CHANGED_INDICATOR_MAP = (1 << 1),
+    /** The symbol interpretations; reported by XkbCompatMapNotify. */
+    XKB_X11_KEYMAP_CHANGED_COMPAT_MAP = (1 << 2),
+    /** The names of keys, types, modifiers, etc.; reported by XkbNamesNotify. */
+    XKB_X11_KEYMAP_CHANGED_NAMES = (1 << 3),
+    /** The enabled and per-key repeat controls; reported by XkbControlsNotify. */
+    XKB_X11_KEYMAP_CHANGED_CONTROLS = (1 << 4)
+};
+
+/**
+ * Create a keymap from an X11 keyboard device, reusing an older keymap
+ * from the same device for the parts which did not change.
+ *
+ * This is the same as xkb_x11_keymap_new_from_device(), only the parts
+ * of the keymap which were not changed are copied from @p keymap
+ * instead of being fetched from the X server again.  This is useful for
+ * handling the XKB notify events, which report what changed.
+ *
+ * An XkbNewKeyboardNotify event means the keyboard description was
+ * replaced; use xkb_x11_keymap_new_from_device() for it.
+ *
+ * @param keymap
+ *     A keymap previously created with xkb_x11_keymap_new_from_device()
+ *     or this function, for the same device and connection.
+ * @param connection
+ *     An XCB connection to the X server.
+ * @param device_id
+ *     The device ID the keymap was fetched from.
+ * @param changes
+ *     The parts of the keyboard description which changed since
+ *     @p keymap was fetched, as a bitmask of enum xkb_x11_keymap_changes.
+ *     If 0, a new reference to @p keymap is returned.
+ *
+ * @returns A keymap retrieved from the X server, or NULL on failure.
+ *
+ * @memberof xkb_keymap
+ * @since 1.1.0
+ */
+struct xkb_keymap *
+xkb_x11_keymap_new_from_changes(struct xkb_keymap *keymap,
+                                xcb_connection_t *connection,
+                                int32_t device_id,
+                                enum xkb_x11_keymap_changes changes);
+
 /**
  * Create a new keyboard state object from an X11 keyboard device.
  *
@@ -487,6 +487,43 @@ xkb_keysym_from_name(const char *name, enum xkb_keysym_flags flags);
 int
 xkb_keysym_to_utf8(xkb_keysym_t keysym, char *buffer, size_t size);
 
+/**
+ * Get the Unicode/UTF-8 representation of an array of keysyms.
+ *
+ * @param[in]  keysyms The keysyms to convert.
+ * @param[in]  count   The number of keysyms in keysyms.
+ * @param[out] buffer  A buffer to write the UTF-8 string into.
+ * @param[in]  size    Size of the buffer.
+ * @param[out] offsets An optional array of at least count entries.  If
+ * not NULL, the byte offset in the string at which the representation of
+ * each keysym starts is written into it.  Keysyms which do not have a
+ * Unicode representation produce no output, so their offset is equal to
+ * that of the following keysym.
+ *
+ * @warning If the buffer passed is too small, the string is truncated
+ * (though still NUL-terminated), never in the middle of a UTF-8 sequence.
+ * The offsets are always computed for the full string.
+ *
+ * @returns The number of bytes required for the string, excluding the
+ * NUL byte.
+ *
+ * You may check if truncation has occurred by comparing the return value
+ * with the size of @p buffer, similarly to the snprintf(3) function.
+ * You may safely pass NULL and 0 to @p buffer and @p size to find the
+ * required size (without the NUL-byte).
+ *
+ * This is equivalent to concatenating the results of xkb_keysym_to_utf8()
+ * for each keysym, but much faster for long keysym sequences.  Like
+ * xkb_keysym_to_utf8(), it does not perform any @ref
+ * keysym-transformations.
+ *
+ * @sa xkb_keysym_to_utf8()
+ * @since 1.1.0
+ */
+int
+xkb_keysyms_to_utf8(const xkb_keysym_t *keysyms, size_t count,
+                    char *buffer, size_t size, size_t *offsets);
+
 /**
  * Get the Unicode/UTF-32 representation of a keysym.
  *
@@ -525,6 +562,27 @@ xkb_keysym_to_utf32(xkb_keysym_t keysym);
 xkb_keysym_t
 xkb_utf32_to_keysym(uint32_t ucs);
 
+/**
+ * Get the keysyms corresponding to an array of Unicode/UTF-32 codepoints.
+ *
+ * @param[in]  ucs     The codepoints to convert.
+ * @param[in]  count   The number of codepoints in ucs.
+ * @param[out] keysyms An array of at least count keysyms to write the
+ * results into.
+ *
+ * Each codepoint is converted exactly as by xkb_utf32_to_keysym():
+ * codepoints without a dedicated keysym get their direct-encoded keysym
+ * (0x01000000 + codepoint), and only noncharacters and codepoints outside
+ * of the Unicode planes are converted to XKB_KEY_NoSymbol.  This is more
+ * efficient than calling xkb_utf32_to_keysym() for each codepoint when
+ * converting whole strings.
+ *
+ * @sa xkb_utf32_to_keysym()
+ * @since 1.1.0
+ */
+void
+xkb_utf32_to_keysyms(const uint32_t *ucs, size_t count, xkb_keysym_t *keysyms);
+
 /**
  * Convert a keysym to its uppercase form.
  *
@@ -834,7 +892,28 @@ xkb_context_set_log_fn(struct xkb_context *context,
 /** Flags for keymap compilation. */
 enum xkb_keymap_compile_flags {
     /** Do not apply any flags. */
-    XKB_KEYMAP_COMPILE_NO_FLAGS = 0
+    XKB_KEYMAP_COMPILE_NO_FLAGS = 0,
+    /**
+     * Reuse a keymap previously created in the same context, if the
+     * result would be the same keymap.
+     *
+     * The compiled keymap is looked up by its fingerprint (see
+     * xkb_keymap_get_fingerprint()) among the keymaps created with this
+     * flag in the context, and if an identical one is found, a new
+     * reference to it is returned instead.  This saves memory when many
+     * identical keymaps are created, e.g. for several devices or seats.
+     *
+     * xkb_keymap_new_from_string() and xkb_keymap_new_from_buffer()
+     * moreover return the keymap previously compiled from the same input
+     * without parsing it again.  xkb_x11_keymap_new_from_device() does so
+     * for a device reporting the same keymap; see there for the details.
+     *
+     * Keymaps are immutable, so sharing them is safe.  A keymap only
+     * stays in the cache as long as someone holds a reference to it.
+     *
+     * @since 1.1.0
+     */
+    XKB_KEYMAP_COMPILE_USE_CACHE = (1 << 0)
 };
 
 /**
@@ -964,6 +1043,68 @@ char *
 xkb_keymap_get_as_string(struct xkb_keymap *keymap,
                          enum xkb_keymap_format format);
 
+/**
+ * Get the compiled keymap as a sealed, read-only file.
+ *
+ * @param keymap The keymap to get as a file.
+ * @param format The keymap format to use, as in xkb_keymap_get_as_string().
+ * @param[out] size_out If not NULL, set to the size of the file, which
+ * includes the terminating NUL byte.
+ *
+ * @returns A new file descriptor, or -1 if unsuccessful.
+ *
+ * The file holds the same NUL-terminated string as returned by
+ * xkb_keymap_get_as_string(), and is sealed against writing, growing and
+ * shrinking, so it may be passed as is to untrusted processes, e.g. in a
+ * wl_keyboard.keymap event.  It may be mapped with either MAP_PRIVATE or
+ * MAP_SHARED, read-only.
+ *
+ * The file is only created once per keymap; every call returns a new
+ * descriptor for it, with the close-on-exec flag set.  The caller should
+ * close it when done.
+ *
+ * This is only supported on systems with memfd_create() and file sealing,
+ * e.g. Linux; elsewhere it always returns -1.
+ *
+ * @memberof xkb_keymap
+ * @since 1.1.0
+ */
+int
+xkb_keymap_get_as_fd(struct xkb_keymap *keymap,
+                     enum xkb_keymap_format format,
+                     size_t *size_out);
+
+/**
+ * The size of a keymap fingerprint, in bytes.
+ * @sa xkb_keymap_get_fingerprint()
+ * @since 1.1.0
+ */
+#define XKB_KEYMAP_FINGERPRINT_SIZE 32
+
+/**
+ * Get a fingerprint of the compiled keymap.
+ *
+ * @param keymap The keymap.
+ *
+ * @returns A pointer to XKB_KEYMAP_FINGERPRINT_SIZE bytes, or NULL if
+ * unsuccessful.  The fingerprint is owned by the keymap, and stays valid
+ * as long as the keymap does.
+ *
+ * The fingerprint is a SHA-256 hash of the keymap as returned by
+ * xkb_keymap_get_as_string() in the XKB_KEYMAP_FORMAT_TEXT_V1 format.
+ * Two keymaps with the same fingerprint are equivalent, even if they
+ * come from different contexts or were compiled in different ways, e.g.
+ * one from names and one from the string of the other. This makes it
+ * cheap to tell whether a keymap needs to be sent to clients again.
+ *
+ * It is computed on the first call only.
+ *
+ * @memberof xkb_keymap
+ * @since 1.1.0
+ */
+const uint8_t *
+xkb_keymap_get_fingerprint(struct xkb_keymap *keymap);
+
 /** @} */
 
 /**
@@ -163,6 +163,30 @@ enum rxkb_context_flags {
      * on the lookup behavior.
      */
     RXKB_CONTEXT_LOAD_EXOTIC_RULES = (1 << 1),
+    /**
+     * Use a cache of the parsed registry.
+     *
+     * rxkb_context_parse() loads the models, layouts and options from a
+     * binary cache file in `$XDG_CACHE_HOME/xkbcommon` (or
+     * `$HOME/.cache/xkbcommon`) if the XML files in the include paths have
+     * not changed since it was written.  Otherwise the XML files are parsed
+     * and the cache file is (re)written.
+     *
+     * @since 1.1.0
+     */
+    RXKB_CONTEXT_USE_CACHE = (1 << 2),
+    /**
+     * Do not validate the XML files against the xkeyboard-config DTD.
+     *
+     * By default, each file is read into a document tree and validated
+     * before its items are added, and an invalid file is skipped.  With
+     * this flag, the items are read straight from the file instead, which
+     * is faster and uses less memory.  Unknown elements are then ignored,
+     * and only a file which is not well-formed XML is skipped.
+     *
+     * @since 1.1.0
+     */
+    RXKB_CONTEXT_NO_VALIDATION = (1 << 3),
 };
 
 /**
@@ -451,6 +475,20 @@ rxkb_model_get_vendor(struct rxkb_model *m);
 enum rxkb_popularity
 rxkb_model_get_popularity(struct rxkb_model *m);
 
+/**
+ * Find the model with the given name.
+ *
+ * The refcount of the returned model is not increased. Use rxkb_model_ref()
+ * if you need to keep this struct outside the immediate scope.
+ *
+ * @return The model with the given name, or NULL if there is none or the
+ * context was not successfully parsed.
+ *
+ * @since 1.1.0
+ */
+struct rxkb_model *
+rxkb_model_find(struct rxkb_context *ctx, const char *name);
+
 /**
  * Return the first layout for this context. Use this to start iterating over
  * the layouts, followed by calls to rxkb_layout_next(). Layouts are not sorted.
@@ -532,6 +570,54 @@ rxkb_layout_get_description(struct rxkb_layout *l);
 enum rxkb_popularity
 rxkb_layout_get_popularity(struct rxkb_layout *l);
 
+/**
+ * Find the layout with the given name and variant.
+ *
+ * The refcount of the returned layout is not increased. Use rxkb_layout_ref()
+ * if you need to keep this struct outside the immediate scope.
+ *
+ * @param ctx The context.
+ * @param name The layout name, e.g. "us".
+ * @param variant The variant name, e.g. "intl", or NULL for the layout
+ *                itself.
+ *
+ * @return The layout with the given name and variant, or NULL if there is
+ * none or the context was not successfully parsed.
+ *
+ * @since 1.1.0
+ */
+struct rxkb_layout *
+rxkb_layout_find(struct rxkb_context *ctx, const char *name,
+                 const char *variant);
+
+/**
+ * Search the layouts, e.g. for a type-ahead layout picker.
+ *
+ * The query is split into words, and a layout matches if each of them is
+ * a prefix of one of the words of its name, variant, brief and description,
+ * or of one of its ISO 639 and ISO 3166 codes.  The search is
+ * case-insensitive for ASCII.  For example, "fr swi" matches the
+ * "ch(fr)" layout with the description "French (Switzerland)".  An empty
+ * query matches all the layouts.
+ *
+ * The matching layouts are stored in the order of rxkb_layout_first() and
+ * rxkb_layout_next().  Their refcount is not increased.
+ *
+ * @param ctx The context.
+ * @param query The search query.
+ * @param layouts An array for the matching layouts.  May be NULL if
+ *                @p max_layouts is 0.
+ * @param max_layouts The number of layouts which fit in @p layouts.
+ *
+ * @return The number of matching layouts, which may be larger than
+ * @p max_layouts, in which case only the first @p max_layouts are stored.
+ *
+ * @since 1.1.0
+ */
+size_t
+rxkb_layout_search(struct rxkb_context *ctx, const char *query,
+                   struct rxkb_layout **layouts, size_t max_layouts);
+
 /**
  * Return the first option group for this context. Use this to start iterating
  * over the option groups, followed by calls to rxkb_option_group_next().
@@ -605,6 +691,36 @@ rxkb_option_group_allows_multiple(struct rxkb_option_group *g);
 enum rxkb_popularity
 rxkb_option_group_get_popularity(struct rxkb_option_group *g);
 
+/**
+ * Find the option group with the given name.
+ *
+ * The refcount of the returned option group is not increased. Use
+ * rxkb_option_group_ref() if you need to keep this struct outside the
+ * immediate scope.
+ *
+ * @return The option group with the given name, or NULL if there is none
+ * or the context was not successfully parsed.
+ *
+ * @since 1.1.0
+ */
+struct rxkb_option_group *
+rxkb_option_group_find(struct rxkb_context *ctx, const char *name);
+
+/**
+ * Find the option with the given name, e.g. "grp:alt_shift_toggle", in
+ * any option group.
+ *
+ * The refcount of the returned option is not increased. Use rxkb_option_ref()
+ * if you need to keep this struct outside the immediate scope.
+ *
+ * @return The option with the given name, or NULL if there is none or the
+ * context was not successfully parsed.
+ *
+ * @since 1.1.0
+ */
+struct rxkb_option *
+rxkb_option_find(struct rxkb_context *ctx, const char *name);
+
 /**
  * Return the first option for this option group. Use this to start iterating
  * over the options, followed by calls to rxkb_option_next(). Options are not